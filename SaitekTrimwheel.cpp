@@ -20,16 +20,38 @@
 	Parameters:
 	-h : help
 	-a : process all controllers settings, not only Saitek Trimwheel
-	-c <number of cycles> : cycle time in seconds
+	-c <seconds> : run time in seconds (deadline on the monotonic clock, whatever the cycles cost)
+	-p <msecs> : cycle period in milliseconds (default 1000, 2000 with -v), e.g. 10 for a fast boot check
+	--dispatcher[=usecs] : pump GameInput on a thread of its own, Dispatch() quota in usecs (default 1000)
+	--adaptive[=fast,window,idle] : cycle every <fast> ms for <window> ms after the Trimwheel appeared or moved,
+		then back off to the period of -p, or up to <idle> ms while the Trimwheel is absent (default 10,5000,10000)
+	--ready=deadband,positions,travel[,hold] : thresholds of the Trimwheel's readiness detector (default 0.01,2,0.1,250)
+	--rotation[=units[,range]] : keep running after the Trimwheel is turned and show its revolutions and rev/s,
+		<units> of the axis per revolution (default: the whole range), <range> the span of the axis values
+		(default 1.0, GameInput's 0...1; 2.0 for an axis of -1...1)
+	-d : drain, evaluate every Trimwheel reading since the last cycle (GetNextReading), not only the current one
+	-e : event-driven, wake up on GameInput readings instead of sleeping a whole cycle
+	-o : overflow, drop new console messages instead of waiting if the message buffer is full
+	-T <file> : trace, append every reading and device event as binary record to <file> (decode by twtracedecode)
+	--stats[=N] : print p50/p99/max time of each cycle loop phase at exit (and every N seconds)
+	--json : stream one NDJSON event per state transition to stdout, all other messages to stderr
+	--script <file> : fake GameInput build only (CMake option SAITEKTW_FAKEGAMEINPUT), device events from <file>
+	--replay <file> [--session <n>|all] : fake GameInput build only, replay session n (default 1) of trace <file>,
+		or all its sessions, each in a process of its own, with a summary of the sessions with another RC
+	--realtime : fake GameInput build only, the script or replay at real speed (the virtual clock follows the real one)
+	--soak[=hours] : fake GameInput build only, a simulated day (or <hours>) of hotplug churn and noise with leak checks
 	-s : silent, suppress while-cycle message written on each cycle loop
 	-t : tone, beep if Trimwheel detected/appears/disapears or turned (axis<>0)
-	-v : verbose, print additional msgs, reduces loop wait from 500 ms to 2 secs
+	-v : verbose, print additional msgs, cycle period 2 secs instead of 1 sec (unless set by -p)
 
 	Return codes:
 	* Trimwheel is not zero : RC=0
 	* Trimwheel is zero : RC=1
 	* Called with "-h" : RC=4
 	* Parameter error : RC=8
+	* Replay (fake GameInput build) ended with another RC than the recorded session : RC=20
+	  (--session all: any session with another RC, or one that couldn't be replayed)
+	* Soak run (fake GameInput build) failed a check : RC=24
 	* Other errors : RC>8
 
 	Notes
@@ -48,6 +70,12 @@
 	20.06.25/AH reworked hexadecimal printouts
 	10.07.25/AH Trimwheel "appeared/disappeared/not found" messages marked by three asterisks
 	11.07.25/AH Trimwheel "detected" instead of "appeared" in first cycle
+	Cycle loop scheduled by deadlines: -c is the run time in seconds, -p the cycle period, both independent of
+		the time spent in a cycle (messages, tones)
+	Adaptive cycle period (--adaptive): bursts after the Trimwheel appeared or moved, back-off while it is absent
+	Dispatcher thread (--dispatcher): callbacks hand their events over to the main loop, which wakes up for them
+	Readiness detector (--ready): "turned" is decided by the axis movement since connect, not by a non-zero value
+	Rotation telemetry (--rotation): revolutions and rotation rate of the Trimwheel in the cycle messages and at exit
 	
 */
 
@@ -86,18 +114,39 @@
 #include <conio.h>
 // for toupper()
 #include <ctype.h>
+// for memset()
+#include <string.h>
 
 // Windows-specific getopt
 #include "getopt.h"   // see https://github.com/alex85k/wingetopt/tree/master
 
-
-// Number of controllers and pointer to pointer array (name changed from "Joysticks" to "Joystruct" for better reading)
-struct Joystruct
-{
-	uint32_t deviceCount;
-// Create pointer to pointer array, the array pointers point to object instances of class IGameInputDevice
-	IGameInputDevice** devices;
-};
+// Registry of the connected controllers (replaces the former realloc'd pointer array "Joystruct")
+// Number of controllers in 'deviceCount', the controllers in 'devices[0...deviceCount-1]'
+#include "devregistry.h"
+// Compile-time profiles of the controllers we know (Saitek Trimwheel)
+#include "twprofiles.h"
+// Asynchronous console output of the cycle loop (ring buffer and writer thread)
+#include "twlog.h"
+// Binary trace file of readings and device events (-T)
+#include "twtrace.h"
+// NDJSON events for boot scripts (--json)
+#include "twjson.h"
+// Per-phase timing histograms of the cycle loop (--stats)
+#include "twstats.h"
+// Time sources: cycle sleep, event wait, tones, timestamps
+#include "twclock.h"
+// Adaptive cycle period (--adaptive)
+#include "twpoll.h"
+// Readiness detector of the Trimwheel's axis (--ready)
+#include "twready.h"
+// Revolutions and rotation rate of the Trimwheel's axis (--rotation)
+#include "twrotation.h"
+// Dispatcher thread (--dispatcher)
+#include "twdispatch.h"
+// Fake build (CMake option SAITEKTW_FAKEGAMEINPUT): GameInput in memory, devices from a script (--script)
+#ifdef TW_FAKEGAMEINPUT
+#include "fakegameinput.h"
+#endif
 
 // #############################################################################################################
 // Global variables, mostly static
@@ -105,14 +154,17 @@ struct Joystruct
 
 // Size of Structure"GameInputDeviceInfo" (GameInput.h) with device attribute structure 
 static const int GmInpDevInfSize = sizeof(GameInputDeviceInfo);
-// Allocate pointer to structure joydevinfo of type GameInputDeviceInfo to receive address of device data block from GetDeviceInfo()
-// Has to be const as the device data block is owned by IGameInput object and must not be modified by application
-static const GameInputDeviceInfo *joydevinfo;
+// Number of GetDeviceInfo() calls since program start (device identity is only decoded at connect time)
+static uint64_t getdevinfocalls = 0;
 
 
 // Saitek Proflight Trimwheel Vendor-ID (VID) and Product-ID (PID)
-static const int saitektwvid = 0x6a3;
-static const int saitektwpid = 0xbd4;
+static const int saitektwvid = SaitekTrimwheelProfile::vid;
+static const int saitektwpid = SaitekTrimwheelProfile::pid;
+
+// Watch-list: the controllers we are watching for are those with a profile in twprofiles.h (Twknownprofiles)
+// Without "-a", only these controllers are kept in our device registry, all others are dropped at connect time
+// and cost nothing in the cycle loop
 
 // Do we have Saitek Trimwheel attached ?
 static bool saitektwfound = false;
@@ -120,6 +172,23 @@ static bool saitektwfound = false;
 static bool saitektwthere = false;
 // Saitek Trimwheel axis turned, so not equal to zero ?
 static bool saitektwturned = false;
+// Axis value that lead to "turned" (from cycle loop or reading callback)
+static float saitektwturnval = 0;
+// GameInput timestamp (usecs) of the reading that lead to "turned", for the detection latency at program end
+static uint64_t saitektwturnts = 0;
+// Last known axis value of the Trimwheel (for the JSON events)
+static float saitektwaxis = 0;
+// Axis value of the Trimwheel the poll policy has last seen (--adaptive): a reading callback updates saitektwaxis
+// before the cycle loop could compare with it
+static float saitektwpollaxis = 0;
+// Last known state of the Trimwheel's readiness detector (for the summary at program end)
+static Twready saitektwready = {};
+// Rotation telemetry of the Trimwheel, fed by every reading we evaluate (cycle loop, drain mode, reading callback)
+static Twrotation saitektwrotation;
+// Readings of the rotation telemetry at its last cycle message (only new readings are shown)
+static uint64_t rotationshown = 0;
+// A controller of our watch-list has connected since the last cycle (device callback), ends the wait of "-e" early
+static bool saitektwarrived = false;
 
 // My return codes of this program to the caller of main
 #define osrc_axisnotzero	 0			// Trimwheel there, axis was turned and is not zero, so it's initialized and usable
@@ -128,28 +197,75 @@ static bool saitektwturned = false;
 #define osrc_err_param		 8			// Error while processing the command line parameters
 #define osrc_err_GameInp	12			// Error from Microsoft GameInput processing
 #define osrc_err_unknown	16			// Unknown error (initial value for osretcode)
+#define osrc_err_replay		20			// Fake build, --replay: the replayed session ended with another RC than recorded
+#define osrc_err_soak		24			// Fake build, --soak: memory, controller count or cycle cost not stable
 // If we find a Saitek Trimwheel, we return 0 (axis not zero) or 1 (axis is zero) to OS
 // Any other return to OS sets a returncode 4 or higher
 static int osretcode = osrc_err_unknown;	// Default: if not set otherwise, return code to OS is 16
 
-// Default readloops 86.400 (one day's seconds)
+// Default run time 86.400 seconds (one day)
 static const int readldflt = (24*60*60);
+// Max. cycle period in msecs (-p)
+static const int periodmax = 60000;
 
 // To check function results by SUCCEEDED()
 HRESULT retresult;
 
-// Variables for processing GameInputDeviceInfo structure
-static int memsize, vid, pid, rev, ifc, col = 0;
-
-// Variables for processing axes, switches, buttons
-static int nbraxes, nbrswch, nbrbutt = 0;
 
 // Default: no verbosity
 static int verbolvl = 0;
+// Debug levels: code of a debug level above TWLOG_MAXLVL (CMake option SAITEKTW_MAXDBGLVL, see twlog.h) isn't compiled
+// into the program at all, up to TWLOG_MAXLVL the runtime verbosity (-v, -vv, ...) decides
+// IFDBG(n) { ... } : block of debug level n (#DBGn messages), must not be followed by "else"
+#define IFDBG(lvl) if constexpr ((lvl) <= TWLOG_MAXLVL) if (verbolvl >= (lvl))
+// DBGON(n) : the same as condition, for "else if" chains
+#define DBGON(lvl) (((lvl) <= TWLOG_MAXLVL) && (verbolvl >= (lvl)))
 // while-cycle message suppression, default: messages supressed
 static bool cyclemessages=true;
 // Get axes, switches, buttons not only from Saitek Trimwheel but all controllers
 static bool allcontrollers=false;
+// Event-driven mode: wait for GameInput readings (reading callback) instead of a fixed Sleep()
+static bool eventmode=false;
+// Drain mode: walk the reading history with GetNextReading instead of sampling GetCurrentReading only
+static bool drainmode=false;
+// Readings evaluated and readings skipped as unchanged (same sequence number as in the last cycle) since program start
+static uint64_t rdgprocessed, rdgskipped = 0;
+// Controllers with a changed state (devreg_diffstate) summed over all cycles
+static uint64_t statechanged = 0;
+// Drain mode: readings processed and dropped (history overflow) in this cycle and since program start
+static int drainprocessed, draindropped = 0;
+static uint64_t drainprocessedtotal, draindroppedtotal = 0;
+// Console messages of the cycle loop: wait (default) or drop new messages if the ring buffer of twlog is full
+static Twlogpolicy logpolicy = TWLOG_BLOCK;
+// Trace mode: write every evaluated reading and device event to a binary trace file
+static bool tracemode=false;
+static const char* tracefilename = NULL;
+// JSON mode: NDJSON events on stdout, messages on stderr
+static bool jsonmode=false;
+// Statistics mode: time the phases of the cycle loop, report at exit and every statsinterval seconds (0 = only at exit)
+static bool statsmode=false;
+static int statsinterval=0;
+// Adaptive mode: cycle period by the policy of twpoll.h instead of the fixed period of -p/-v
+static bool adaptivemode=false;
+static Twpollpolicy pollpolicy = { TWPOLL_FASTDFLT, TWPOLL_WINDOWDFLT, TWPOLL_IDLEDFLT };
+// Thread mode: GameInput is pumped by the dispatcher thread of twdispatch.h with this quota (usecs) per Dispatch()
+static bool threadmode=false;
+static uint64_t dispquota = TWDISPATCH_QUOTADFLT;
+// Rotation mode: don't exit when the Trimwheel is turned, show its rotation (twrotation.h) until the run time is up
+static bool rotationmode=false;
+static float rotationunits = TWROTATION_UNITSDFLT;
+static float rotationrange = TWROTATION_RANGEDFLT;
+#ifdef TW_FAKEGAMEINPUT
+// Replay mode (fake build): session of a trace file as GameInput input, and the RC the recording program ended with
+static const char* replayfilename = NULL;
+static int replaysession = 1;
+static int replayrc = -1;
+// Script or replay at real speed (fake build)
+static bool realtimemode = false;
+// Soak mode (fake build): simulated hours of churn, checked hour by hour
+static bool soakmode = false;
+static int soakhours = 24;
+#endif
 
 // Definition of exit key. temp stor for the user-pressed key
 static const int exitkey = 'Q';
@@ -168,14 +284,183 @@ static const int twbeepwheelturned = 523;		// Trimwheel there, can be turned (51
 void advance_cursor() {
   static int pos=0;
   char cursor[4]={'/','-','\\','|'};
-  printf("%c\b", cursor[pos]);
-  fflush(stdout);
+  twlog_printf("%c\b", cursor[pos]);	// flushed by the twlog writer thread
   pos = (pos+1) % 4;
 }
 
 
+// #############################################################################################################
+// Decode device information once when a controller connects
+// #############################################################################################################
+// Check device information for the given controller, according to
+// https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinputdevice/methods/igameinputdevice_getdeviceinfo
+// https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/structs/gameinputdeviceinfo
+// and copy what the cycle loop needs into our compact descriptor 'joydesc', kept in the device registry.
+// We have to find the Saitek ProFlight Cessna Trim Wheel (VID: 0x6A3, PID: 0xBD4), this is marked by 'watched'
+//
+static void decodedeviceinfo(IGameInputDevice* device, Devregdesc* joydesc, APP_LOCAL_DEVICE_ID* deviceid)
+{
+	memset(joydesc, 0, sizeof(*joydesc));
+	memset(deviceid, 0, sizeof(*deviceid));
+// Allocate pointer to structure joydevinfo of type GameInputDeviceInfo to receive address of device data block from GetDeviceInfo()
+// Has to be const as the device data block is owned by IGameInput object and must not be modified by application
+	const GameInputDeviceInfo *joydevinfo;
+	{
+		Twstatsscope statsscope(TWSTATS_DEVINFO);
+		joydevinfo = device->GetDeviceInfo();
+	}
+	++getdevinfocalls;
+// Valid address returned from GetDeviceInfo ?				
+	if (joydevinfo == NULL) {
+		twlog_printf("No pointer returned from GetDeviceInfo() to joydevptr \n");
+		return;
+	}
+// Then check if size of returned data block is large enough
+	joydesc->infosize = joydevinfo->infoSize;
+// Check returned structure at least as big as the first fields we want to process (should always happen)
+	if (joydesc->infosize < (uint32_t)GmInpDevInfSize ) {
+		IFDBG(1) {
+			twlog_printf("\t#DBG1 %s@%d GetDeviceInfo() gives structure too short in length (%i vs. SizeOf: %i)\n", __func__, __LINE__, 
+					joydesc->infosize, GmInpDevInfSize);
+		}
+		return;
+	}
+	IFDBG(1) {
+		twlog_printf("\t#DBG1 %s@%d structure length %i vs. SizeOf: %i)\n", __func__, __LINE__, joydesc->infosize, GmInpDevInfSize);
+	}
+	joydesc->valid = true;
+	*deviceid = joydevinfo->deviceId;
+	joydesc->vid = joydevinfo->vendorId;
+	joydesc->pid = joydevinfo->productId;
+	joydesc->rev = joydevinfo->revisionNumber;
+	joydesc->ifc = joydevinfo->interfaceNumber;
+	joydesc->col = joydevinfo->collectionNumber;
+	joydesc->nbraxes = joydevinfo->controllerAxisCount;
+	joydesc->nbrbutt = joydevinfo->controllerButtonCount;
+	joydesc->nbrswch = joydevinfo->controllerSwitchCount;
+// The only VID/PID comparison: find the profile of this controller (0 = none), the cycle loop works with the profile id
+	joydesc->profile = twprofile_find(Twknownprofiles(), joydesc->vid, joydesc->pid);
+	joydesc->watched = (joydesc->profile != 0);
+	twprofile_mincounts(Twknownprofiles(), joydesc);
+
+// #############################################################################################################
+// Not working: get device name from GameInput DeviceInfo for this specific controller
+// #############################################################################################################
+
+// Not implemented by Microsoft in DirectInput API V.0 ; removed by Microsoft in DirectInput API V.1 !
+// Maybe a search in these two registry locations would have solved it:
+// 1. HKCU\System\CurrentControlSet\Control\MediaResources\Joystick\DINPUT.DLL\CurrentJoystickSettings : Joystick1OEMName
+// 2. HKCU\System\CurrentControlSet\Control\MediaProperties\PrivateProperties\Joystick\OEM\VID_...&PID_...\OEMName
+// but that's beyond the scope of this "check script", so I left my debug statements (verbosity level 3 : -vvv)
+//
+// Linkage to device name:
+// joydevinfo : pointer to device data block structure GameInputDeviceInfo			
+// dispnameptr : pointer to displayName data block, address from pointer GameInputDeviceInfo.displayName
+// displayName : pointer to structure of type GameInputString with 
+//					"uint32_t sizeInBytes" : string size, "uint32_t codePointCount" : number of unicode characters
+//					and "char cont* data" : UTF-8 encoded Unicode string
+// But ! It seems, displayName is always a Nullpointer (see also https://github.com/microsoft/GDK/issues/35)
+// So only if verbosity level 3 (-vvv) is selected: print the GamInputDeviceInfo structure
+	IFDBG(3) {
+		int singlechar;
+// Load a pointer with the starting address of the GameInputDeviceInfo structure (pointed by joydevinfo)
+// The pointer points to "unsigned char", so we can easily print each byte
+		unsigned char *joyptr = (unsigned char *) &(joydevinfo->infoSize);
+		twlog_printf("\t#DBG3 %s@%d Dumping structure GameInputDeviceInfo\n", __func__, __LINE__);
+		twlog_printf("\t#DBG3 %s@%d joydevinfo pts to %p, joyptr to %p\n", __func__, __LINE__, (void *) joydevinfo, (void *) joyptr);
+		for (int ix = 1 ; ix < GmInpDevInfSize ; ++ix) {
+			singlechar = joyptr[0];
+			twlog_printf("\t#DBG3 %s@%d ix=%03i joyptr=%p byte: dec=%03i, hex=[%020x], char=[%c]\n", __func__, __LINE__, ix-1, joyptr, singlechar, joyptr[0], joyptr[0]);
+			joyptr++;
+		}
+// Load a pointer with the address of the displayName structure
+		const GameInputString *dispnameptr = joydevinfo->displayName;
+		twlog_printf("\t#DBG3 %s@%d Dumping substructure GameInputDeviceInfo.displayName\n", __func__, __LINE__ );
+		twlog_printf("\t#DBG3 %s@%d dispnameptr (loaded from %p) points to %p\n", __func__, __LINE__, (void *) &(joydevinfo->displayName), (void *) dispnameptr);
+		if (dispnameptr != NULL) {
+			for (int ix = 1 ; ix < 8 ; ++ix) {
+				singlechar = (char) dispnameptr->data[0];
+				twlog_printf("\t#DBG3 %s@%d ix=%i dispnmptr=%p char=[%020x]\n", __func__, __LINE__, ix, dispnameptr, singlechar);
+				dispnameptr++;
+			}
+		} else {
+			twlog_printf("\t#DBG3 %s@%d dispnameptr is zero, displayName structure not accessible\n", __func__, __LINE__);
+		}
+	}
+}
+
 // #############################################################################################################
 // Start of asynchronous subroutine
+// #############################################################################################################
+// Trace mode "-T": one binary record per evaluated reading and per device event (see twtrace.h)
+// #############################################################################################################
+// The controller's index in the registry pool identifies it in the trace, it stays the same while it is connected
+static uint16_t traceindex(const Devregistry* reg, const Devregentry* entry)
+{
+	return (uint16_t)(entry - reg->pool);
+}
+
+// Trace the state the state handler has just read from 'reading' into the controller's state buffers
+static void tracereading(const Devregistry* reg, const Devregentry* entry, IGameInputReading* reading)
+{
+	if (tracemode) {
+		twtrace_reading(traceindex(reg, entry), entry->desc.vid, entry->desc.pid,
+			reading->GetSequenceNumber(GameInputKindController), reading->GetTimestamp(),
+			entry->axes, entry->desc.nbraxes, entry->buttons, entry->desc.nbrbutt);
+	}
+}
+
+// #############################################################################################################
+// Cycle messages: the state of the controllers that has changed since the last cycle
+// #############################################################################################################
+// devreg_diffstate has found the changed controllers and fields, we print only these fields
+// (a controller connected since the last cycle with all its fields, or "No Axes" etc. if it hasn't any)
+static void printchanges(const Devregistry* reg, const Devregchanges* changes)
+{
+	for (uint32_t chgctr = 0; chgctr < changes->count; ++chgctr) {
+		uint16_t poolidx = changes->changed[chgctr];
+		const Devregentry* entry = &reg->pool[poolidx];
+		uint8_t fields = devreg_changedfields(changes, poolidx);
+		twlog_printf("Controller %u (VID: 0x%04X, PID: 0x%04X):\t", entry->denseidx, entry->desc.vid, entry->desc.pid);
+// First print the values of all axes
+		if (fields & DEVREG_CHGAXES) {
+			if (entry->desc.nbraxes > 0) {
+				twlog_printf("  Axes - ");
+				for (uint32_t axctr = 0; axctr < entry->desc.nbraxes; ++axctr) {
+					twlog_printf("%d:%f ", axctr, entry->axes[axctr]);
+				} // end for axctr loop
+			} else {
+				twlog_printf(" No Axes ");
+			}
+		}
+// Second print the position of the switches (GameInputSwitchPosition, e.g. GameInputSwitchCenter = 0, GameInputSwitchUp = 1, ...)
+// see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/enums/gameinputswitchposition
+		if (fields & DEVREG_CHGSWITCHES) {
+			if (entry->desc.nbrswch > 0) {
+				twlog_printf("Switches - ");
+				for (uint32_t swctr = 0; swctr < entry->desc.nbrswch; ++swctr) {
+					twlog_printf("%d:%d ", swctr, entry->switches[swctr]);
+				} // end for swctr loop
+			} else {
+				twlog_printf(" No Swi  ");
+			}
+		}
+// Third print the pressed buttons (button n is bit n%64 of word n/64)
+		if (fields & DEVREG_CHGBUTTONS) {
+			if (entry->desc.nbrbutt > 0) {
+				twlog_printf("Buttons - ");
+				for (uint32_t btctr = 0; btctr < entry->desc.nbrbutt; ++btctr) {
+					if ((entry->buttons[btctr / 64] >> (btctr % 64)) & 1) twlog_printf("%d ", btctr);
+				} // end for btctr loop
+			} else {
+				twlog_printf(" No Buttn");
+			}
+		}
+// just to print newline
+		twlog_printf("\n");
+	}
+}
+
 // #############################################################################################################
 // see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/functions/gameinputdevicecallback
 // For status enumeration see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/enums/gameinputdevicestatus
@@ -185,32 +470,26 @@ void advance_cursor() {
 //
 // In every call, we receive this information:
 // - Callback-Token (given when this routine was registered by RegisterDeviceCallback)
-// - context = &joysticks = address of pointer 'joysticks'
+// - context = &joysticks = address of our device registry 'joysticks'
 //			(important informations that we have specified in RegisterDeviceCallback as parameter 5)
 // - IGameInputDevice* (pointer to a specific controller that has changed its state)
 // - Current state (connection and input status) of this controller
 // - Previous state (connection and input status) of this controller
 //
-// Our processing counts the number of devices given, then reallocates (or allocates if previously not allocated [pointer is null]) the device
+// Our processing adds a connected device to our device registry or removes a disconnected device from it.
+// The registry finds a device by hash tables, so no scan over all devices and no (re)allocation is needed
 //
-void CALLBACK deviceChangeCallback(GameInputCallbackToken callbackToken, void* context, IGameInputDevice* singledevice, uint64_t timestamp, GameInputDeviceStatus currentStatus, GameInputDeviceStatus previousStatus) 
-{ 
-// Print VID/PID of controller that has changed its status
-	const GameInputDeviceInfo *joydevchgd	 = NULL;
-	joydevchgd = singledevice->GetDeviceInfo();
-	int vidchgd = joydevchgd->vendorId;
-	int pidchgd = joydevchgd->productId;
-// Hex chars: "%#"" -> "0x" -> counts as 2 digits ! So  %#04X prints "0x" + 4 digits, e.g. 0x3456 ;
-// What not worked: As I want leading zeroes not leading spaces, I have to add a zero behing %#06 :  %#060x
-// And in big letters (A instead of a), I have to use big X instead of little x
-// But disadvantage: the prefix 0x is changed to uppercase 0X too, so I choose a clearer definition and changed it to 0x%04X : 0xABCD
-    printf("Callback Subroutine: device state change for VID: 0x%04X, PID: 0x%04X\n", vidchgd, pidchgd);
+// devicechange() does the registry work and returns the controller's trace index (TWTRACE_NODEVICE if it isn't
+// in the registry), so applydevicechange can trace its arguments for a later replay once the index is known.
+// With the dispatcher thread ("--dispatcher"), the callback runs on that thread and only hands its arguments over,
+// the main loop applies them by applydevicechange (see applydispatched)
 //
-	if ( verbolvl > 0 ) {
-		printf("\t#DBG1 %s@%d ### callbk sub: routine starting (async)\n", __func__, __LINE__);
-	}
-// Access main pgm's "joysticks" array (of controllers) by copying main-routine's 'joysticks' pointer to the function-local (!) pointer 'joyarray'
-	Joystruct* joyarray = (Joystruct*)context;
+static uint16_t devicechange(Devregistry* joyarray, IGameInputDevice* singledevice, uint64_t timestamp,
+		GameInputDeviceStatus currentStatus, GameInputDeviceStatus previousStatus,
+		const Devregdesc& joydescchgd, const APP_LOCAL_DEVICE_ID* joyidchgd)
+{
+	int vidchgd = joydescchgd.vid;
+	int pidchgd = joydescchgd.pid;
 // currentStatus :
 //		GameInputDeviceNoStatus = 0x00000000
 //		GameInputDeviceConnected = 0x00000001	<--- Checked in the "if"
@@ -220,43 +499,450 @@ void CALLBACK deviceChangeCallback(GameInputCallbackToken callbackToken, void* c
 // Bitwise check currentStatus: the "if" becomes true when its last bit (GameInputDeviceConnected) is set
 // meaning: the "if" executes its tree as a (new) device connects
 	if (currentStatus & GameInputDeviceConnected) {
-// Compare all actual devices with the delivered device that has changed its status
-		for (uint32_t devctrcompare = 0; devctrcompare < joyarray->deviceCount; ++devctrcompare) {
-// Check if the new contoller device is already in our list of controllers, if so, do nothing and return to caller
-			if ( verbolvl > 0 )	{
-				printf("\t#DBG1 %s@%d ### callbk sub: checking device %i\n", __func__, __LINE__, devctrcompare);
+// Without "-a", we register only controllers of our watch-list, so the cycle loop never sees the others
+		if (!allcontrollers && !joydescchgd.watched) {
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d ### callbk sub: routine leaving, joystick not on watch-list\n", __func__, __LINE__);
 			}
-			if (joyarray->devices[devctrcompare] == singledevice) {
-				if ( verbolvl > 0 ) {
-					printf("\t#DBG1 %s@%d ### callbk sub: routine leaving, joystick unchanged %i\n", __func__, __LINE__, devctrcompare);
-				}
-				return;
+			return TWTRACE_NODEVICE;
+		}
+// Check if the new contoller device is already in our registry of controllers, if so, do nothing and return to caller
+		Devregentry* knownentry = devreg_find(joyarray, singledevice);
+		if (knownentry != NULL) {
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d ### callbk sub: routine leaving, joystick unchanged\n", __func__, __LINE__);
 			}
-		} // end for-loop over controller devices
-// We have found a new device, so re-allocate our joystick list with the additional joystick definition
-
-// add 1 to number of controllers
-		++joyarray->deviceCount;
-		if ( verbolvl > 0 ) {
-			printf("\t#DBG1 %s@%d ### callbk sub: Joystick %i added\n", __func__, __LINE__,joyarray->deviceCount);
-		}
-// now realloc (resize) our list of controllers (add/change memory for the new controller)
-		joyarray->devices = (IGameInputDevice**)realloc(joyarray->devices, joyarray->deviceCount * sizeof(IGameInputDevice*));
-// and add the given new/changed device definition to the reallocated or newly allocated element of controller array
-// Array handling as of devicecount starts at 1 but array index starts at 0:
-// controller 1 to element 0, controller 2 to element 1 aso., therefore deviceCount-1)
-// Get GameInputDeviceInfo contents by IGameInputDevice.GetDeviceInfo() into structure joydevinfo
-		joyarray->devices[joyarray->deviceCount-1] = singledevice;
-	} else {
-		if ( verbolvl > 0 ) {
-			printf("\t#DBG1 %s@%d ### callbk sub: no change detected (currentStatus: %i)\n", __func__, __LINE__, currentStatus);
+			return traceindex(joyarray, knownentry);
 		}
+// The same controller (by its device id, stable over reconnects) under another device object: the disconnect of
+// its old object hasn't been reported (e.g. a quick USB reset), so the stale entry is removed first, the controller
+// must not be registered twice
+		Devregentry* staleentry = devreg_findid(joyarray, joyidchgd);
+		if (staleentry != NULL) {
+			if (tracemode) {
+				twtrace_event(traceindex(joyarray, staleentry), staleentry->desc.vid, staleentry->desc.pid,
+					TWTRACE_EV_DISCONNECTED, timestamp);
+			}
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d ### callbk sub: Joystick reconnected as a new device, stale entry removed\n", __func__, __LINE__);
+			}
+			devreg_remove(joyarray, staleentry->device);
+		}
+// We have found a new device, so add it to our registry (the registry holds a reference on the device)
+		Devregentry* newentry = devreg_insert(joyarray, singledevice, joyidchgd);
+		if (newentry == NULL) {
+			twlog_printf("Too many controllers (max. %i), VID: 0x%04X, PID: 0x%04X ignored\n", DEVREG_MAXDEVICES, vidchgd, pidchgd);
+			return TWTRACE_NODEVICE;
+		}
+// Keep the decoded device information, the cycle loop only works on this copy
+		newentry->desc = joydescchgd;
+// and clear the controller's state in the registry (its first cycle prints all of it)
+		devreg_resetstate(joyarray, newentry);
+		if (tracemode) {
+			twtrace_event(traceindex(joyarray, newentry), vidchgd, pidchgd, TWTRACE_EV_CONNECTED, timestamp);
+		}
+		if (joydescchgd.watched) {
+			saitektwarrived = true;
+			twrotation_restart(&saitektwrotation);
+		}
+		IFDBG(1) {
+			twlog_printf("\t#DBG1 %s@%d ### callbk sub: Joystick %i added\n", __func__, __LINE__,joyarray->deviceCount);
+		}
+		return traceindex(joyarray, newentry);
+	} else if (previousStatus & GameInputDeviceConnected) {
+// The device was connected before and has gone now, so remove it from our registry
+		Devregentry* goneentry = devreg_find(joyarray, singledevice);
+		if (goneentry == NULL) {
+			return TWTRACE_NODEVICE;
+		}
+		uint16_t goneindex = traceindex(joyarray, goneentry);
+		if (tracemode) {
+			twtrace_event(goneindex, goneentry->desc.vid, goneentry->desc.pid, TWTRACE_EV_DISCONNECTED, timestamp);
+		}
+		if (devreg_remove(joyarray, singledevice)) {
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d ### callbk sub: Joystick removed, %i left\n", __func__, __LINE__, joyarray->deviceCount);
+			}
+		}
+		return goneindex;
+	}
+	IFDBG(1) {
+		twlog_printf("\t#DBG1 %s@%d ### callbk sub: no change detected (currentStatus: %i)\n", __func__, __LINE__, currentStatus);
+	}
+	Devregentry* knownentry = devreg_find(joyarray, singledevice);
+	return (knownentry != NULL) ? traceindex(joyarray, knownentry) : TWTRACE_NODEVICE;
+}
+
+// Latency from a device event or reading to the main loop applying it (--stats, "event latency"): in manual dispatch,
+// the callback runs when the cycle loop calls Dispatch(), with the dispatcher thread when the main loop takes its event
+static void observed(uint64_t timestamp)
+{
+	if (twstats_active) {
+		uint64_t now = twclock_timestamp();
+		twstats_addns(TWSTATS_OBSERVE, (now > timestamp) ? (now - timestamp) * 1000 : 0);
+	}
+}
+
+static void applydevicechange(Devregistry* joyarray, IGameInputDevice* singledevice, uint64_t timestamp,
+		GameInputDeviceStatus currentStatus, GameInputDeviceStatus previousStatus)
+{
+	observed(timestamp);
+// Decode the device information of the controller that has changed its status (the only GetDeviceInfo call for it)
+// and print its VID/PID
+	Devregdesc joydescchgd;
+	APP_LOCAL_DEVICE_ID joyidchgd;
+	decodedeviceinfo(singledevice, &joydescchgd, &joyidchgd);
+// Hex chars: "%#"" -> "0x" -> counts as 2 digits ! So  %#04X prints "0x" + 4 digits, e.g. 0x3456 ;
+// What not worked: As I want leading zeroes not leading spaces, I have to add a zero behing %#06 :  %#060x
+// And in big letters (A instead of a), I have to use big X instead of little x
+// But disadvantage: the prefix 0x is changed to uppercase 0X too, so I choose a clearer definition and changed it to 0x%04X : 0xABCD
+    twlog_printf("Callback Subroutine: device state change for VID: 0x%04X, PID: 0x%04X\n", joydescchgd.vid, joydescchgd.pid);
+//
+	IFDBG(1) {
+		twlog_printf("\t#DBG1 %s@%d ### callbk sub: routine starting (async)\n", __func__, __LINE__);
 	}
-	if ( verbolvl > 0 ) {
-		printf("\t#DBG1 %s@%d ### callbk sub: routine leaving, normal end\n", __func__, __LINE__);
+	uint16_t device = devicechange(joyarray, singledevice, timestamp, currentStatus, previousStatus, joydescchgd, &joyidchgd);
+// Record and replay: the callback's arguments, so the fake GameInput build can replay this session (--replay)
+	if (tracemode) {
+		twtrace_callback(device, joydescchgd.vid, joydescchgd.pid, joydescchgd.nbraxes, joydescchgd.nbrbutt, joydescchgd.nbrswch,
+			(uint32_t)currentStatus, (uint32_t)previousStatus, timestamp);
 	}
+	IFDBG(1) {
+		twlog_printf("\t#DBG1 %s@%d ### callbk sub: routine leaving, normal end\n", __func__, __LINE__);
+	}
+}
+
+void CALLBACK deviceChangeCallback(GameInputCallbackToken callbackToken, void* context, IGameInputDevice* singledevice, uint64_t timestamp, GameInputDeviceStatus currentStatus, GameInputDeviceStatus previousStatus) 
+{ 
+// Dispatcher thread: hand the arguments over to the main loop, the device is kept by a reference until it has applied them
+	if (twdispatch_active) {
+		Twdispatchevent event = {};
+		event.kind = TWDISPATCH_DEVICE;
+		event.device = singledevice;
+		event.timestamp = timestamp;
+		event.currentstatus = currentStatus;
+		event.previousstatus = previousStatus;
+		singledevice->AddRef();
+		twdispatch_post(event);
+		return;
+	}
+// Access main pgm's "joysticks" registry (of controllers) by copying main-routine's 'joysticks' pointer to the function-local (!) pointer 'joyarray'
+	applydevicechange((Devregistry*)context, singledevice, timestamp, currentStatus, previousStatus);
 } 
 
+// #############################################################################################################
+// Reading callback (only registered in event-driven mode "-e")
+// #############################################################################################################
+// see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinput/methods/igameinput_registerreadingcallback
+//
+// As we run GameInput in "manual dispatch mode", this routine is called from within dispatcher->Dispatch(),
+// so it runs in our main thread and may set our static flags without any locking.
+// With the dispatcher thread, it runs on that thread and hands the reading over, applyreading runs in the main loop.
+// It is registered for all controllers, so we filter on the Trimwheel here by the 'watched' flag
+// that deviceChangeCallback has decoded into our device registry (context = &joysticks)
+//
+// The Trimwheel's axis has moved since the poll policy has last seen it: poll fast for a while (--adaptive)
+static void pollaxis(float axis)
+{
+	if (axis != saitektwpollaxis) {
+		twpoll_burst(twclock_timestamp());
+		saitektwpollaxis = axis;
+	}
+}
+
+static void applyreading(Devregistry* rdgregistry, IGameInputReading* reading, bool hasOverrunOccurred)
+{
+	observed(reading->GetTimestamp());
+	IGameInputDevice* readingdevice = NULL;
+// Which device has sent this reading ? GetDevice increments the device's reference count, so release it afterwards
+	reading->GetDevice(&readingdevice);
+	if (readingdevice == NULL) {
+		return;
+	}
+	Devregentry* rdgentry = devreg_find(rdgregistry, readingdevice);
+	bool istrimwheel = (rdgentry != NULL) && rdgentry->desc.watched;
+	readingdevice->Release();
+	if (!istrimwheel) {
+		return;
+	}
+// Read the state by the handler of the device's profile, its readiness detector decides if the Trimwheel is turned
+	float rdgaxis = 0;
+	bool rdgready = Twhandlertable<Twknownprofiles>::handlers[rdgentry->desc.profile](reading, rdgregistry, rdgentry, &rdgaxis);
+	tracereading(rdgregistry, rdgentry, reading);
+	pollaxis(rdgentry->axes[0]);
+	saitektwaxis = rdgentry->axes[0];
+	saitektwready = rdgentry->ready;
+	twrotation_update(&saitektwrotation, reading->GetSequenceNumber(GameInputKindController), reading->GetTimestamp(), rdgentry->axes[0]);
+	IFDBG(1) {
+		twlog_printf("\t#DBG1 %s@%d ### reading callbk: Trimwheel axis value %f%s\n", __func__, __LINE__, rdgentry->axes[0], hasOverrunOccurred ? " (overrun)" : "");
+	}
+	if (rdgready) {
+		if (tracemode && !saitektwturned) {
+			twtrace_event(traceindex(rdgregistry, rdgentry), rdgentry->desc.vid, rdgentry->desc.pid, TWTRACE_EV_TURNED, reading->GetTimestamp());
+		}
+		if (jsonmode && !saitektwturned) {
+			twjson_event("turned", reading->GetTimestamp(), rdgaxis, -1);
+		}
+		if (!saitektwturned) {
+			saitektwturnts = reading->GetTimestamp();
+		}
+		saitektwturned = true;
+		saitektwturnval = rdgaxis;
+		osretcode = osrc_axisnotzero;
+	}
+}
+
+void CALLBACK readingCallback(GameInputCallbackToken callbackToken, void* context, IGameInputReading* reading, bool hasOverrunOccurred)
+{
+	if (twdispatch_active) {
+		Twdispatchevent event = {};
+		event.kind = TWDISPATCH_READING;
+		event.reading = reading;
+		event.timestamp = reading->GetTimestamp();
+		event.overrun = hasOverrunOccurred;
+		reading->AddRef();
+		twdispatch_post(event);
+		return;
+	}
+	applyreading((Devregistry*)context, reading, hasOverrunOccurred);
+}
+
+// Dispatcher thread: apply the callbacks' events handed over since the last call, in their order.
+// This is the only place where the registry changes while the thread runs
+static void applydispatched(Devregistry* reg)
+{
+	Twdispatchevent event;
+	while (twdispatch_take(&event)) {
+		if (event.kind == TWDISPATCH_DEVICE) {
+			applydevicechange(reg, event.device, event.timestamp, event.currentstatus, event.previousstatus);
+			event.device->Release();
+		} else {
+			applyreading(reg, event.reading, event.overrun);
+			event.reading->Release();
+		}
+	}
+}
+
+#ifdef TW_FAKEGAMEINPUT
+// #############################################################################################################
+// Soak mode "--soak" (fake build): hours of hotplug churn, axis noise and keys on the virtual clock
+// #############################################################################################################
+// Each cycle adds to the numbers of its (virtual) hour, at the end we compare the last hour with the first:
+// - the registry never holds more controllers than connected (deviceCount bounded by the churn)
+// - the heap doesn't grow (the fake reconnects the same controllers every hour), apart from 64 KB of allocator noise
+//   (the state of the controllers lives in the registry itself, it allocates nothing)
+// - the mean cycle cost stays within twice the first hour's (plus 2 usecs for the noise of a busy machine)
+//
+#define SOAK_MAXHOURS	(7 * 24)
+struct Soakhour
+{
+	uint64_t cycles;
+	uint64_t cyclens;				// summed cost of the cycles (QueryPerformanceCounter of the fake build counts ns)
+	uint32_t maxdevices;			// highest deviceCount of the registry
+	size_t heapbytes;				// heap at the hour's last cycle
+};
+static Soakhour soakstats[SOAK_MAXHOURS];
+static uint64_t soakviolations = 0;		// cycles with more controllers in the registry than connected
+
+static void soakcycle(const Devregistry* reg, uint64_t cyclens, uint64_t elapsedmsecs)
+{
+	uint64_t hour = elapsedmsecs / 3600000;
+	Soakhour* stats = &soakstats[(hour < SOAK_MAXHOURS) ? hour : SOAK_MAXHOURS - 1];
+	++stats->cycles;
+	stats->cyclens += cyclens;
+	if (reg->deviceCount > stats->maxdevices) {
+		stats->maxdevices = reg->deviceCount;
+	}
+	if (reg->deviceCount > fakegi_connected()) {
+		++soakviolations;
+	}
+	stats->heapbytes = fakegi_heapbytes();
+}
+
+// Print the hours and check them, returns false if a check failed
+static bool soakreport()
+{
+	printf("Soak hour     cycles  mean cycle (usecs)  max controllers     heap bytes\n");
+	int hours = 0;
+	for (int hour = 0; (hour < SOAK_MAXHOURS) && (soakstats[hour].cycles > 0); ++hour) {
+		const Soakhour* stats = &soakstats[hour];
+		printf("  %7i %10llu %19.3f %16u %14zu\n", hour + 1, (unsigned long long)stats->cycles,
+			stats->cyclens / 1000.0 / stats->cycles, stats->maxdevices, stats->heapbytes);
+		hours = hour + 1;
+	}
+	bool ok = true;
+	if (soakviolations > 0) {
+		printf("Soak check failed: more controllers registered than connected in %llu cycles\n", (unsigned long long)soakviolations);
+		ok = false;
+	}
+	if (hours < 2) {
+		printf("Soak run too short for the heap and cycle cost checks\n");
+		return ok;
+	}
+	const Soakhour* first = &soakstats[0];
+	const Soakhour* last = &soakstats[hours - 1];
+	if (last->heapbytes > first->heapbytes + 65536) {
+		printf("Soak check failed: heap grew from %zu to %zu bytes\n", first->heapbytes, last->heapbytes);
+		ok = false;
+	}
+	uint64_t firstmean = first->cyclens / first->cycles;
+	uint64_t lastmean = last->cyclens / last->cycles;
+	if (lastmean > 2 * firstmean + 2000) {
+		printf("Soak check failed: mean cycle cost rose from %llu to %llu ns\n", (unsigned long long)firstmean, (unsigned long long)lastmean);
+		ok = false;
+	}
+	if (ok) {
+		printf("Soak checks passed: %i hours, controller count bounded, no heap growth, stable cycle cost\n", hours);
+	}
+	return ok;
+}
+#endif
+
+// The Trimwheel is turned and the cycle loop ends (with "--rotation", it goes on until the run time is up)
+static bool turnedexit()
+{
+	return saitektwturned && !rotationmode;
+}
+
+// #############################################################################################################
+// Wait for GameInput work instead of Sleep() (event-driven mode "-e")
+// #############################################################################################################
+// We block on the dispatcher's wait handle (signaled when GameInput has queued work for us) until the wait time
+// (GameInput timestamp) is reached. Each time it is signaled, we run the dispatcher so our callbacks get their chance to execute.
+// Returns true as soon as the reading callback has found the Trimwheel turned (not with "--rotation"), false after the wait time
+// or as soon as a controller of our watch-list has connected (so a long idle period of "--adaptive" doesn't delay it)
+// With the dispatcher thread (also without "-e"), we wait for the events it hands over and apply them instead
+//
+static bool waitforreading(IGameInputDispatcher* dispatcher, HANDLE dispwaithandle, uint64_t deadline, Devregistry* reg)
+{
+	if (twdispatch_active) {
+		while (twdispatch_waituntil(deadline)) {
+			applydispatched(reg);
+			if (turnedexit()) {
+				return true;
+			}
+			if (saitektwarrived) {
+				saitektwarrived = false;
+				return false;
+			}
+		}
+		return turnedexit();
+	}
+	while (twclock_timestamp() < deadline) {
+		DWORD waitret = twclock_waituntil(dispwaithandle, deadline);
+		if (waitret != WAIT_OBJECT_0) {
+			if (waitret != WAIT_TIMEOUT) {		// should not happen, but never spin around a broken handle
+				twclock_sleepuntil(deadline);
+			}
+			return turnedexit();
+		}
+// Dispatch() returns true as long as work items remain in the queue
+		while (dispatcher->Dispatch(0)) {
+		}
+		if (turnedexit()) {
+			return true;
+		}
+		if (saitektwarrived) {
+			saitektwarrived = false;
+			return false;
+		}
+	}
+	return turnedexit();
+}
+
+// #############################################################################################################
+// Drain the reading history of one device (drain mode "-d")
+// #############################################################################################################
+// see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinput/methods/igameinput_getnextreading
+//
+// GameInput keeps a history of readings per device. Starting at the last reading we have processed (*lastreading),
+// we walk forward by GetNextReading until we reach the current reading (or the history has no newer one),
+// so a short turn of the wheel between two cycles isn't lost even if the axis is back to zero at the next GetCurrentReading.
+// If our reference has fallen out of the history (more readings between two cycles than the history holds), the walk
+// goes on from the oldest reading still there. Readings missing in the sequence numbers are counted as dropped.
+// Afterwards the current reading becomes the reference for the next cycle (we keep a reference on it).
+//
+// Each walked reading is evaluated by the state handler of the device's profile (see twprofiles.h)
+// and goes into the rotation telemetry (only the Trimwheel's readings are drained).
+// Returns true if any of the walked readings was "ready" (Trimwheel: its detector decided turned), its value is returned in *turnval
+// and its GameInput timestamp in *turnts
+//
+// The oldest reading of the device's history, by GetPreviousReading from 'current' (returned with a reference of its own)
+static IGameInputReading* oldestreading(IGameInput* gminputptr, IGameInputDevice* device, IGameInputReading* current)
+{
+	IGameInputReading* oldest = current;
+	oldest->AddRef();
+	IGameInputReading* previous = NULL;
+	while (SUCCEEDED(gminputptr->GetPreviousReading(oldest, GameInputKindController, device, &previous))) {
+		oldest->Release();
+		oldest = previous;
+	}
+	return oldest;
+}
+
+static bool drainreadings(IGameInput* gminputptr, Devregistry* reg, Devregentry* entry,
+		IGameInputReading* current, float* turnval, uint64_t* turnts, int* processed, int* dropped)
+{
+	bool axisturned = false;
+	float readyval = 0;
+	Twstatehandler statehandler = Twhandlertable<Twknownprofiles>::handlers[entry->desc.profile];
+	IGameInputDevice* device = entry->device;
+	IGameInputReading** lastreading = &entry->lastreading;
+	*processed = 0;
+	*dropped = 0;
+	uint64_t currseq = current->GetSequenceNumber(GameInputKindController);
+	IGameInputReading* walkreading = *lastreading;
+	if (walkreading != NULL) {
+		uint64_t prevseq = walkreading->GetSequenceNumber(GameInputKindController);
+		walkreading->AddRef();			// keep the loop's reference handling symmetric: each walked reading is released once
+		while (prevseq < currseq) {
+			IGameInputReading* nextreading = NULL;
+			HRESULT nextresult = gminputptr->GetNextReading(walkreading, GameInputKindController, device, &nextreading);
+			walkreading->Release();
+			walkreading = NULL;
+// Our reference is no longer in the history: on with the oldest reading there, the ones before it are lost
+			if (nextresult == GAMEINPUT_E_REFERENCE_READING_TOO_OLD) {
+				nextreading = oldestreading(gminputptr, device, current);
+			} else if (! SUCCEEDED(nextresult)) {
+				break;		// GAMEINPUT_E_READING_NOT_FOUND : no newer reading, queue is empty
+			}
+			uint64_t nextseq = nextreading->GetSequenceNumber(GameInputKindController);
+			if (nextseq > prevseq + 1) {
+				*dropped += (int)(nextseq - prevseq - 1);
+			}
+			prevseq = nextseq;
+			++*processed;
+			if (statehandler(nextreading, reg, entry, &readyval) && !axisturned) {
+				axisturned = true;
+				*turnval = readyval;
+				*turnts = nextreading->GetTimestamp();
+			}
+			twrotation_update(&saitektwrotation, nextseq, nextreading->GetTimestamp(), entry->axes[0]);
+// The current reading itself is traced by the cycle loop
+			if (nextseq < currseq) {
+				tracereading(reg, entry, nextreading);
+			}
+			walkreading = nextreading;
+		}
+		if (walkreading != NULL) {
+			walkreading->Release();
+		}
+		(*lastreading)->Release();
+	} else {
+// No reference yet (first cycle of this device): only the current reading can be processed
+		*processed = 1;
+		if (statehandler(current, reg, entry, &readyval)) {
+			axisturned = true;
+			*turnval = readyval;
+			*turnts = current->GetTimestamp();
+		}
+		twrotation_update(&saitektwrotation, currseq, current->GetTimestamp(), entry->axes[0]);
+	}
+	current->AddRef();
+	*lastreading = current;
+	return axisturned;
+}
+
 // #############################################################################################################
 // Start of main program entry
 // #############################################################################################################
@@ -281,11 +967,21 @@ int main(int argc, char** argv)
 
 // Just to get information about the compile time at compilation (#pragma message) and execution (printf)
 #pragma message ("***** " COMP_TYP " V." MYSTRING(COMP_VER) " Compile " __FILE__ " at " __DATE__ " " __TIME__ " *****\n")   
+// JSON mode has to be known before the first message, as stdout then carries only the events
+	for (int index = 1; index < argc; index++) {
+		if (strcmp(argv[index], "--json") == 0) {
+			jsonmode = true;
+		}
+	}
+	if (jsonmode && !twjson_open()) {
+		fprintf(stderr, "JSON mode not available, stdout can't be duplicated\n");
+		jsonmode = false;
+	}
 	printf("***** Running %s,\nBinary build date: %s @ %s by %s %d *****\n\n", \
 		  argv[0], __DATE__, __TIME__, COMP_TYP, COMP_VER);
 
 // Now let us start the application
- 	if ( verbolvl > 0 ) {
+ 	IFDBG(1) {
     	printf("\t#DBG1 %s@%d # Starting main()\n", __func__, __LINE__);
   	}	
 
@@ -299,15 +995,16 @@ int main(int argc, char** argv)
   or https://www.gnu.org/software/libc/manual/html_node/Example-of-Getopt.html (the sample I used here)
   The "main" function has to be defined with arguments "(int argc, char** argv)" (char** is a pointer to a pointer list)
 */
- 	if ( verbolvl > 0 ) {
+ 	IFDBG(1) {
     	printf("\t#DBG1 %s@%d # Process commandline parameters by getopt.c\n", __func__, __LINE__);
   	}	
 
-// Sleeptime in msecs for while-loop. Real readloop count is calculated before for-readloopctr loop
+// Cycle period in msecs for the for-readloopctr loop, which runs until the deadline of 'runsecs' seconds
 	int waitmsec = 1000 ;		// Loop in 1 second cycles
 	int waitmsvb = 2000 ;		// Loop in 2 second cycles (verbose flag)
-	int readloops = readldflt;	// default loop length: 24 hours = 86.400 Seconds
-	int userloops = 0;			// user specified loop length in cycles
+	int userperiod = 0;			// user specified cycle period in msecs (-p), wins over -v
+	int runsecs = readldflt;	// default run time: 24 hours = 86.400 Seconds
+	int usersecs = 0;			// user specified run time in seconds
 /*
   Variables defined for and by getopt.c (https://www.gnu.org/software/libc/manual/html_node/Using-Getopt.html)
   Call : getopt(int argc, char* const *argv, const char* options)
@@ -316,15 +1013,33 @@ int main(int argc, char** argv)
   options = string with allowed commandline parameters. Colon after parameter means: parameter must have a following string value
 */  
 	int cmdline_arg = 0;      // Returns the next commandline parameter from getopt prefixed by "-", else a value of -1
+// Long options (getopt_long), "val" is returned like a short option character
+	static const struct option longopts[] = {
+		{ "json", no_argument, NULL, 'j' },		// NDJSON events, already processed before the first message
+		{ "stats", optional_argument, NULL, 'S' },	// phase timing statistics, optionally every N seconds ("--stats=N")
+		{ "adaptive", optional_argument, NULL, 'A' },	// adaptive cycle period ("--adaptive=fast,window,idle")
+		{ "dispatcher", optional_argument, NULL, 'U' },	// dispatcher thread, optionally its quota ("--dispatcher=usecs")
+		{ "ready", required_argument, NULL, 'Y' },	// thresholds of the readiness detector ("--ready=deadband,positions,travel[,hold]")
+		{ "rotation", optional_argument, NULL, 'M' },	// rotation telemetry, optionally axis units per revolution ("--rotation=units")
+#ifdef TW_FAKEGAMEINPUT
+		{ "script", required_argument, NULL, 'F' },	// fake build: device events of the fake GameInput
+		{ "replay", required_argument, NULL, 'R' },	// fake build: replay a session of a trace file
+		{ "session", required_argument, NULL, 'N' },	// fake build: number of the session to replay
+		{ "realtime", no_argument, NULL, 'W' },		// fake build: script or replay at real speed
+		{ "soak", optional_argument, NULL, 'K' },	// fake build: simulated day of churn ("--soak=hours")
+#endif
+		{ NULL, 0, NULL, 0 }
+	};
 	int opterr = 0;           // getopt.c behaviour regarding error handling; 0 = silent but return "?" in case of error", not 0 = print msg
 // int optopt in getopt.h     commandline parameter not specified in third parameter of getopt call, i.e. parameter not allowed
 // int optind in getopt.h     set by getopt.c to the index of the next elemnt in argv. At end: points to first unprocessed argv element
 // char* optarg in getopt.h   set by getopt.c to the option value behind the processed commandline parameter (e.g. "1" for "-v 1")
 
 /* Now parse the given-to-main commandline parameters */
-/* Implemented: "-h" = help; "-v" = verbosity (lvl increased by multiple occurences); "-c ###" = cycle ### seconds */
+/* Implemented: "-h" = help; "-v" = verbosity (lvl increased by multiple occurences); "-c ###" = cycle ### seconds;
+   "-p ###" = cycle period ### msecs */
 /* The colon after an option requests a value behind an option character */
-	while ((cmdline_arg = getopt (argc, argv, "hvsc:at")) != -1) 	{
+	while ((cmdline_arg = getopt_long (argc, argv, "hvsc:p:atedoT:", longopts, NULL)) != -1) 	{
 // As we don't have here a valid verbolvl, I leave this debugging statement as comment:
 // printf("### Entering next getopts loop (while), cmdline_arg = %d = %c\n", cmdline_arg, cmdline_arg);
     	switch (cmdline_arg) {
@@ -335,20 +1050,46 @@ int main(int argc, char** argv)
            		"-h : this help\n"
 				"-a : process all controllers (axis, switches, buttons), not only trimwheel\n"
            		"-c <###> : cycle for ### seconds (otherwise default: %i) until exit key %c pressed\n"
+           		"-p <###> : one cycle every ### msecs (1...%i, otherwise default: %i)\n"
+           		"-d : drain, evaluate every trimwheel reading since the last cycle, not only the current one\n"
+           		"-e : event-driven, exit as soon as the trimwheel reports a turned axis\n"
+           		"-o : drop new cycle messages instead of waiting if the console is too slow\n"
            		"-s : silent loop, don't write cycle messages\n"
-				"-t : play tone when trimwheel should be turned and on exit"
-           		"-v : debugging msgs, level increased by multiple occurences; changes loop-wait from %ims to %ims\n"
+           		"-T <file> : append every reading and device event to binary trace <file> (see twtracedecode)\n"
+				"-t : play tone when trimwheel should be turned and on exit\n"
+           		"--stats[=N] : print p50/p99/max time of each cycle phase at exit (and every N seconds)\n"
+           		"--adaptive[=fast,window,idle] : cycle every <fast> ms for <window> ms after the trimwheel appeared or moved,\n"
+           		"    then back off to the period of -p, or to <idle> ms while it is absent (default %i,%i,%i)\n"
+           		"--dispatcher[=usecs] : GameInput callbacks on a thread of its own, Dispatch() quota in usecs (default %i)\n"
+           		"--ready=deadband,positions,travel[,hold] : trimwheel turned when its axis has run through <positions> positions\n"
+           		"    (steps above <deadband>) and <travel> in sum since connect, or has held a position at least <travel>\n"
+           		"    away from 0 for <hold> msecs (default %.2f,%i,%.2f,%i)\n"
+           		"--rotation[=units[,range]] : don't exit when the trimwheel is turned, show its revolutions and rev/s\n"
+           		"    (<units> of the axis per revolution, default %.1f; <range> of the axis values, default %.1f for 0...1)\n"
+           		"--json : one JSON line per event (detected, appeared, disappeared, turned, timeout, exit) on stdout\n"
+#ifdef TW_FAKEGAMEINPUT
+           		"--script <file> : fake GameInput build, connects/disconnects and axis values from <file>\n"
+           		"--replay <file> : fake GameInput build, replay a session of trace <file> (-T), check its RC\n"
+           		"--session <n>|all : session to replay (default 1) or all, --realtime : script or replay at real speed\n"
+           		"--soak[=hours] : fake GameInput build, simulate 24 (or <hours>) hours of hotplug churn and check for leaks\n"
+#endif
+           		"-v : debugging msgs, level increased by multiple occurences; changes cycle period from %ims to %ims\n"
            		"Retcode: 0 = axis not zero (OK); 1 = axis zero; 4 = help ; 8 = parameter error, >8  = other errors\n",
-				saitektwvid, saitektwpid, waitmsec, waitmsvb, readldflt, exitkey
+				saitektwvid, saitektwpid, readldflt, exitkey, periodmax, waitmsec,
+				TWPOLL_FASTDFLT, TWPOLL_WINDOWDFLT, TWPOLL_IDLEDFLT, TWDISPATCH_QUOTADFLT,
+				TWREADY_DEADBANDDFLT, TWREADY_POSITIONSDFLT, TWREADY_TRAVELDFLT, TWREADY_HOLDDFLT, TWROTATION_UNITSDFLT,
+				TWROTATION_RANGEDFLT, waitmsec, waitmsvb
 			);
 			osretcode = osrc_helpcalled;
         	return osretcode; // !!! Attention !!! Early return to OS
         	break;    // break switch-branch, never reached because of return to OS
 		case 'v':	                   // Option -v -> Verbosity, each occurence increases verbosity by 1 up to max. 9)
 			waitmsec = waitmsvb;
-        	if (verbolvl < 9) {
+        	if (verbolvl < TWLOG_MAXLVL) {		// max. 9, or less if the build has less debug levels compiled in
         		verbolvl = ++verbolvl;   // variable optarg definition in getopt.h, returned from compiled getopt function
-        		printf("Verbosity increased to %i, loop sleep time set to %i msecs\n", verbolvl, waitmsec);
+        		printf("Verbosity increased to %i, cycle period set to %i msecs\n", verbolvl, waitmsec);
+        	} else {
+        		printf("Verbosity kept at %i, the maximum debug level of this build\n", verbolvl);
         	}
         	break;    // break switch-branch
       	case 's':                     // Option -s -> suppress cycle related messages
@@ -356,24 +1097,164 @@ int main(int argc, char** argv)
         	cyclemessages=false;
         	break;    // break switch-branch
       	case 'c':                     // Option -c ### -> cycle loop for ### seconds
-	        userloops=atoi(optarg);   // optarg defined by getopt.h, returned from getopt
-        	if ((userloops > 0) && (userloops <= readloops)) {
-				readloops=userloops;
-        		printf("Cycles set to %i\n", readloops);
+	        usersecs=atoi(optarg);    // optarg defined by getopt.h, returned from getopt
+        	if ((usersecs > 0) && (usersecs <= runsecs)) {
+				runsecs=usersecs;
+        		printf("Run time set to %i seconds\n", runsecs);
+			} else {
+        		printf("Run time out of range (0...%i), kept %i seconds\n", runsecs, runsecs);
+			}
+        	break;    // break switch-branch
+      	case 'p':                     // Option -p ### -> one cycle every ### msecs
+	        userperiod=atoi(optarg);  // optarg defined by getopt.h, returned from getopt
+        	if ((userperiod > 0) && (userperiod <= periodmax)) {
+        		printf("Cycle period set to %i msecs\n", userperiod);
 			} else {
-        		printf("Cycles out of range (0...%i), kept %i\n", readloops, readloops);
+        		fprintf(stderr, "Option -p requires a period of 1...%i msecs. Try -h !\n", periodmax);
+				osretcode = osrc_err_param;
+				return osretcode; // !!! Attention !!! Early return to OS
 			}
         	break;    // break switch-branch
       	case 'a':                     // Option -a -> process all controllers
         	printf("Processing information of all controllers\n");
         	allcontrollers=true;
         	break;    // break switch-branch
+      	case 'd':                     // Option -d -> drain the reading history each cycle
+        	printf("Drain: evaluating all trimwheel readings between cycles\n");
+        	drainmode=true;
+        	break;    // break switch-branch
+      	case 'e':                     // Option -e -> event-driven, wake up on GameInput readings
+        	printf("Event-driven: waiting for trimwheel readings instead of sleeping\n");
+        	eventmode=true;
+        	break;    // break switch-branch
+      	case 'o':                     // Option -o -> drop new console messages on overflow
+        	printf("Overflow: dropping new cycle messages if the console is too slow\n");
+        	logpolicy=TWLOG_DROPNEW;
+        	break;    // break switch-branch
+      	case 'T':                     // Option -T <file> -> binary trace of readings and device events
+	        tracefilename=optarg;     // optarg defined by getopt.h, returned from getopt
+        	printf("Trace of readings and device events to %s\n", tracefilename);
+        	tracemode=true;
+        	break;    // break switch-branch
+      	case 'j':                     // Option --json -> NDJSON events (stdout already switched above)
+        	printf("JSON events on stdout, messages on stderr\n");
+        	break;    // break switch-branch
+      	case 'S':                     // Option --stats[=N] -> phase timing statistics
+        	statsmode=true;
+        	if (optarg != NULL) {
+        		statsinterval=atoi(optarg);
+        	}
+        	printf("Phase timing statistics at exit");
+        	if (statsinterval > 0) {
+        		printf(" and every %i seconds", statsinterval);
+        	}
+        	printf("\n");
+        	break;    // break switch-branch
+      	case 'A':                     // Option --adaptive[=fast,window,idle] -> adaptive cycle period
+        	adaptivemode=true;
+        	if (optarg != NULL) {
+        		int fast = 0, window = -1, idle = 0;
+        		if ((sscanf(optarg, "%i,%i,%i", &fast, &window, &idle) != 3) || (fast < 1) || (fast > periodmax)
+        			|| (window < 0) || (idle < fast) || (idle > periodmax)) {
+          			fprintf(stderr, "Option --adaptive requires <fast>,<window>,<idle> msecs with 1 <= fast <= idle <= %i. Try -h !\n", periodmax);
+					osretcode = osrc_err_param;
+					return osretcode; // !!! Attention !!! Early return to OS
+        		}
+        		pollpolicy.fastmsecs = fast;
+        		pollpolicy.windowmsecs = window;
+        		pollpolicy.idlemsecs = idle;
+        	}
+        	printf("Adaptive cycle period: every %u msecs for %u msecs after the trimwheel appeared or moved, up to %u msecs while absent\n",
+        		pollpolicy.fastmsecs, pollpolicy.windowmsecs, pollpolicy.idlemsecs);
+        	break;    // break switch-branch
+      	case 'Y':                     // Option --ready=deadband,positions,travel[,hold] -> thresholds of the readiness detector
+        	{
+        		float deadband = -1, travel = -1;
+        		int positions = 0;
+        		int hold = TWREADY_HOLDDFLT;
+        		int values = sscanf(optarg, "%f,%i,%f,%i", &deadband, &positions, &travel, &hold);
+        		if ((values < 3) || (deadband < 0) || (positions < 1) || (travel < 0) || (hold < 0)) {
+          			fprintf(stderr, "Option --ready requires <deadband>,<positions>,<travel>[,<hold>] with deadband >= 0, positions >= 1, travel >= 0, hold >= 0. Try -h !\n");
+					osretcode = osrc_err_param;
+					return osretcode; // !!! Attention !!! Early return to OS
+        		}
+        		twready_config.deadband = deadband;
+        		twready_config.minpositions = positions;
+        		twready_config.mintravel = travel;
+        		twready_config.holdmsecs = hold;
+        	}
+        	printf("Readiness: trimwheel turned after %u positions (steps above %.3f) and a travel of %.3f, or a position held for %u msecs\n",
+        		twready_config.minpositions, twready_config.deadband, twready_config.mintravel, twready_config.holdmsecs);
+        	break;    // break switch-branch
+      	case 'M':                     // Option --rotation[=units[,range]] -> rotation telemetry, don't exit when turned
+        	rotationmode=true;
+        	if (optarg != NULL) {
+        		int fields = sscanf(optarg, "%f,%f", &rotationunits, &rotationrange);
+        		if (fields == 1) {
+        			rotationrange = TWROTATION_RANGEDFLT;
+        		}
+        		if ((fields < 1) || !(rotationunits > 0) || !(rotationrange > 0)) {
+          			fprintf(stderr, "Option --rotation requires axis units per revolution > 0 and an axis range > 0. Try -h !\n");
+					osretcode = osrc_err_param;
+					return osretcode; // !!! Attention !!! Early return to OS
+        		}
+        	}
+        	printf("Rotation telemetry: running on after the trimwheel is turned, %.3f axis units per revolution, axis range %.3f\n",
+        		rotationunits, rotationrange);
+        	break;    // break switch-branch
+      	case 'U':                     // Option --dispatcher[=usecs] -> dispatcher thread
+        	threadmode=true;
+        	if (optarg != NULL) {
+        		int quota = atoi(optarg);
+        		if (quota < 1) {
+          			fprintf(stderr, "Option --dispatcher requires a quota of at least 1 usec. Try -h !\n");
+					osretcode = osrc_err_param;
+					return osretcode; // !!! Attention !!! Early return to OS
+        		}
+        		dispquota = quota;
+        	}
+        	printf("Dispatcher thread with a quota of %llu usecs per Dispatch()\n", (unsigned long long)dispquota);
+        	break;    // break switch-branch
+#ifdef TW_FAKEGAMEINPUT
+      	case 'F':                     // Option --script <file> -> events of the fake GameInput (fake build only)
+        	printf("Fake GameInput events from script %s\n", optarg);
+        	if (!fakegi_loadscript(optarg)) {
+				osretcode = osrc_err_param;
+				return osretcode; // !!! Attention !!! Early return to OS
+        	}
+        	break;    // break switch-branch
+      	case 'R':                     // Option --replay <file> -> replay a traced session (fake build only)
+        	replayfilename = optarg;
+        	break;    // break switch-branch
+      	case 'N':                     // Option --session <n>|all -> session of the replayed trace file, 0 for all
+        	replaysession = (strcmp(optarg, "all") == 0) ? 0 : atoi(optarg);
+        	if ((replaysession < 1) && (strcmp(optarg, "all") != 0)) {
+          		fprintf(stderr, "Option --session requires a session number >= 1 or \"all\". Try -h !\n");
+				osretcode = osrc_err_param;
+				return osretcode; // !!! Attention !!! Early return to OS
+        	}
+        	break;    // break switch-branch
+      	case 'W':                     // Option --realtime -> script or replay at real speed
+        	realtimemode = true;
+        	break;    // break switch-branch
+      	case 'K':                     // Option --soak[=hours] -> soak run on the virtual clock
+        	soakmode = true;
+        	if (optarg != NULL) {
+        		soakhours = atoi(optarg);
+        	}
+        	if ((soakhours < 1) || (soakhours > SOAK_MAXHOURS)) {
+          		fprintf(stderr, "Option --soak requires 1...%i hours. Try -h !\n", SOAK_MAXHOURS);
+				osretcode = osrc_err_param;
+				return osretcode; // !!! Attention !!! Early return to OS
+        	}
+        	break;    // break switch-branch
+#endif
       	case 't':                     // Option -a -> process all controllers
         	printf("Play tones on sound device for trimwheel available/turned\n");
         	twbeep=true;
         	break;    // break switch-branch
       	case '?':                     // Any other commandline parameter error
-        	if (optopt == 'v' || optopt == 'f') {         // optopt: Parameter in error, here -v without following number
+        	if (optopt == 'c' || optopt == 'p' || optopt == 'T') {    // optopt: Parameter in error, here -c, -p or -T without following value
           		fprintf(stderr, "Option -%c requires an argument. Try -h !\n", optopt);
         	} else if (isprint (optopt)) {    // here we found a parameter not specified in the third getopt argument (string, see above)
           		fprintf(stderr, "Unknown option '-%c'. Try -h !\n", optopt);
@@ -390,8 +1271,76 @@ int main(int argc, char** argv)
         	break;    // break switch-branch, never reached because of return to OS
     	} // end switch
   	} // end while
-
-	if ( verbolvl > 0 ) {
+// -p wins over the longer period of -v, whatever the order of the options
+	if (userperiod > 0) {
+		waitmsec = userperiod;
+	}
+	twpoll_init(adaptivemode ? &pollpolicy : NULL, waitmsec);
+	twrotation_init(&saitektwrotation, rotationunits, rotationrange);
+
+#ifdef TW_FAKEGAMEINPUT
+// Replay: the session's device callbacks and readings become the events of the fake GameInput
+	if (replayfilename != NULL) {
+		int sessions = 0;
+		uint64_t recordedms = 0;
+// All sessions: each one replayed by a child from here on, this process only shows the summary of their RCs
+		if (replaysession == 0) {
+			LARGE_INTEGER replaystart, replayend, replayfreq;
+			QueryPerformanceFrequency(&replayfreq);
+			QueryPerformanceCounter(&replaystart);
+			replaysession = fakegi_forksessions(replayfilename, &sessions);
+			if (replaysession < 0) {
+				osretcode = osrc_err_param;
+				return osretcode; // !!! Attention !!! Early return to OS
+			}
+			if (replaysession == 0) {
+				QueryPerformanceCounter(&replayend);
+				double replaysecs = (double)(replayend.QuadPart - replaystart.QuadPart) / replayfreq.QuadPart;
+				int samerc = 0;
+				printf("Replay of all %i sessions from trace %s in %.3f secs (%.0f per sec)\n", sessions, replayfilename,
+					replaysecs, (replaysecs > 0) ? sessions / replaysecs : 0.0);
+				for (int session = 1; session <= sessions; ++session) {
+					int sessionrc = fakegi_sessionrc(session);
+					if (sessionrc == osrc_err_replay) {
+						printf("Replay: session %i ended with another RC than recorded\n", session);
+					} else if ((sessionrc < 0) || (sessionrc == osrc_err_param)) {
+						printf("Replay: session %i couldn't be replayed (RC=%i)\n", session, sessionrc);
+					} else {
+						++samerc;
+					}
+				}
+				printf("Replay: %i of %i sessions with the same RC as recorded, %i mismatches\n", samerc, sessions,
+					sessions - samerc);
+				osretcode = (samerc == sessions) ? 0 : osrc_err_replay;
+				printf("End program, RC=%i\n", osretcode);
+				return osretcode; // !!! Attention !!! Early return to OS
+			}
+		}
+		if (!fakegi_loadtrace(replayfilename, replaysession, &replayrc, &recordedms, &sessions)) {
+			osretcode = osrc_err_param;
+			return osretcode; // !!! Attention !!! Early return to OS
+		}
+		printf("Replay of session %i of %i from trace %s, recorded RC=%i%s\n", replaysession, sessions, replayfilename, replayrc,
+			realtimemode ? ", at real speed" : "");
+// Without -c the replay runs as long as the recorded session (not a day of cycles for a session without a turn),
+// one second more, so the cycle that ended the recording is in the run time on the real clock too
+		if ((usersecs <= 0) && (recordedms > 0)) {
+			runsecs = (int)(recordedms / 1000) + 1;
+		}
+	}
+// Real speed: a slow console or pipe delays the detection as it would on Windows
+	if (realtimemode) {
+		fakegi_realtime();
+	}
+// Soak: the churn script, cycling for the hours, and the cycle timing of --stats for the cost check
+	if (soakmode) {
+		fakegi_soakscript(soakhours);
+		runsecs = soakhours * 3600;
+		statsmode = true;
+		printf("Soak run over %i hours (virtual time): %lli cycles\n", soakhours, (long long)runsecs * 1000 / waitmsec);
+	}
+#endif
+	IFDBG(1) {
     	printf("Unprocessed commmandline parameters (%d parameters):\n", optind);
     	for (int index = optind; index < argc; index++) printf ("Non-option argument [%s]\n", argv[index]);
   	}
@@ -400,10 +1349,11 @@ int main(int argc, char** argv)
 // Setup Microsoft GameInput V.0 interface
 // #############################################################################################################
 
-// Define joysticks as structure and initialize to zero both subfields (deviceCount, pointer to array of pointers to the specific devinces)
-	Joystruct joysticks = {0};
-	if ( verbolvl > 1 ) {
-		printf("\t#DBG2 %s@%d Structure 'joysticks' allocated, size is %zu (expect 16 as 64bit ptr is 8bit aligned !)\n", __func__, __LINE__, sizeof(joysticks));
+// Define joysticks as our device registry and initialize it to "no controllers" (static as it is too large for the stack)
+	static Devregistry joysticks;
+	devreg_init(&joysticks);
+	IFDBG(2) {
+		printf("\t#DBG2 %s@%d Structure 'joysticks' allocated, size is %zu (pool of %i controllers)\n", __func__, __LINE__, sizeof(joysticks), DEVREG_MAXDEVICES);
   	}
 
 // The following two statements define the access to the device input stream
@@ -412,7 +1362,7 @@ int main(int argc, char** argv)
 // Create pointer 'gminputptr' for later use to access object of class IGameInput (per-process singleton instance to access the device input stream)
 // see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinput/igameinput
 	IGameInput* gminputptr;
-	if ( verbolvl > 1 ) {
+	IFDBG(2) {
 		printf("\t#DBG2 %s@%d Pointer 'gminputptr' to IGameInput allocated, size is %zu\n", __func__, __LINE__, sizeof(gminputptr));
   	}
 
@@ -425,9 +1375,11 @@ int main(int argc, char** argv)
 		osretcode = osrc_err_GameInp;
 		return osretcode; // !!! Attention !!! Early return to OS
 	}
-	if ( verbolvl > 1 ) {
+	IFDBG(2) {
 		printf("\t#DBG2 %s@%d Created instance 'IGameInput', struc size is %zu, 'gminputptr', ptr points to %p\n", __func__, __LINE__, sizeof(IGameInput), (void*)gminputptr);
   	}
+// Shortest sleep or wait of the cycle loop: the period, or the burst period of --adaptive if that is shorter
+	twclock_init(gminputptr, (adaptivemode && (pollpolicy.fastmsecs < (uint32_t)waitmsec)) ? pollpolicy.fastmsecs : waitmsec);
 // The following three statements define the Callback-Interface Subroutine, that is called asynchron (= out of order)
 // each time the device definitions are changed (e.g. another controller added)
 
@@ -443,9 +1395,21 @@ int main(int argc, char** argv)
 	if (! SUCCEEDED(retresult)) {
 		printf("Error from CreateDispatcher: 0x%x\n",retresult);
 		osretcode = osrc_err_GameInp;
+		twclock_exit();
 		return osretcode; // !!! Attention !!! Early return to OS
 	}
 
+// Trace mode: open the trace file before the device callback is registered, so the first connects are traced too
+// A trace file that can't be opened must not stop the Trimwheel detection, so we just continue without trace
+	if (tracemode && !twtrace_open(tracefilename)) {
+		printf("Trace file %s can't be opened or is no trace file, continuing without trace\n", tracefilename);
+		tracemode = false;
+	}
+// A session of the trace starts here, a replay of it starts its virtual clock at this timestamp
+	if (tracemode) {
+		twtrace_event(TWTRACE_NODEVICE, 0, 0, TWTRACE_EV_START, twclock_timestamp());
+	}
+
 // Create object instance "callbackId" of type GameInputCallbackToken (defined in GameInput.h as "typedef uint64_t GameInputCallbackToken;")
 // Device callbacks provide an asynchronous way to get informed about device status changes (e.g. device connects/disconnects)
 	GameInputCallbackToken callbackId;
@@ -458,42 +1422,90 @@ int main(int argc, char** argv)
 // - Limit to kind/type "Controllers"
 // - No Limit on device states
 // - enumerate sychronously ("blocking" RegisterDeviceCallback until all callbacks are processed)
-// - relevant information for callback function - give the address of our "joysticks pointer to pointer array" to the async subroutine
+// - relevant information for callback function - give the address of our "joysticks" device registry to the async subroutine
 // - name of asynch subroutine: deviceChangeCallback (subroutine defined above)
 // - token identifying the registered callback function (if we have to cancel or unregister this callback function)
 
-	if ( verbolvl > 0 ) {
+	IFDBG(1) {
 		printf("\t#DBG1 %s@%d Registering async callback procedure 'deviceChangeCallback'\n", __func__, __LINE__);
 	}
 	gminputptr->RegisterDeviceCallback(0, GameInputKindController, GameInputDeviceAnyStatus, GameInputBlockingEnumeration, &joysticks, deviceChangeCallback, &callbackId);
-	if ( verbolvl > 0 ) {
+	IFDBG(1) {
 		printf("\t#DBG1 %s@%d Registering async callback done, should have run the callbk routine\n", __func__, __LINE__);
 	}
 
-// Define array of one controllers buttons as up to 64 button states
-	bool buttons[64];
-// Define array of one controllers switches array as enumerator of up to 64 switch states
-// (e.g. GameInputSwitchCenter = 0, GameInputSwitchUp = 1, ...)
-// see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/enums/gameinputswitchposition
-	GameInputSwitchPosition switches[64];
+// Event-driven mode: register a second callback "readingCallback" for every new controller axis reading
+// Parameter:
+// - 0 = no specific device selected (we filter the Trimwheel's VID/PID inside the callback)
+// - Limit to kind/type "controller axes" as the Trimwheel has nothing else
+// - analog threshold 0.0 : every axis change creates a reading
+// - relevant information for callback function - the address of our "joysticks" device registry
+// Additionally, we need the dispatcher's wait handle, that is signaled as soon as GameInput has work for us
+	GameInputCallbackToken readingcbId = 0;
+	HANDLE dispwaithandle = NULL;
+	if (eventmode) {
+		retresult = gminputptr->RegisterReadingCallback(0, GameInputKindControllerAxis, 0.0f, &joysticks, readingCallback, &readingcbId);
+		if (SUCCEEDED(retresult)) {
+			retresult = dispatcher->OpenWaitHandle(&dispwaithandle);
+		}
+		if (! SUCCEEDED(retresult) || (dispwaithandle == NULL)) {
+			printf("Event-driven mode not available (0x%x), falling back to cycle sleep\n", retresult);
+			eventmode = false;
+		} else if (DBGON(1)) {
+			printf("\t#DBG1 %s@%d Reading callback registered, dispatcher wait handle %p\n", __func__, __LINE__, (void*)dispwaithandle);
+		}
+	}
 
-// Define array of one controllers axes as up to 64 axes floating point values
-	float axes[64];
+// Dispatcher thread: from now on, GameInput is pumped by the thread and the callbacks hand their events over
+// (the blocking enumeration of RegisterDeviceCallback has already filled the registry in the main thread)
+	if (threadmode && !twdispatch_start(dispatcher, dispquota)) {
+		printf("Dispatcher thread not available, dispatching in the cycle loop\n");
+		threadmode = false;
+	}
 
-	printf("Starting Cycle-Loop for up to %i cycles with sleep %i msecs\n", readloops,waitmsec);
+// The state of all controllers lives in the device registry, one row per controller (see devregistry.h).
+// In the cycle loop, we point to the axes floating point values of one controller by:
+	float* axes;
+// and after all controllers, we compare all of them with the last cycle at once (printchanges)
+	static Devregchanges statechanges;
+
+	printf("Starting Cycle-Loop for up to %i seconds with a cycle every %i msecs\n", runsecs, waitmsec);
+// Start of the cycle loop, for our statistics at program end
+	ULONGLONG startmsecs = twclock_msecs();
+// Deadlines on the GameInput timestamp (monotonic, microseconds): the end of the run and the start of the next cycle.
+// Waiting until a deadline instead of sleeping a whole period compensates the time spent in the cycle itself
+	uint64_t runstart = twclock_timestamp();
+	uint64_t rundeadline = runstart + (uint64_t)runsecs * 1000000;
+	uint64_t cycledeadline = runstart;
+	int cyclesrun = 0;			// cycles of the for-readloopctr loop
+	uint64_t overruns = 0;		// cycles that took longer than the period
+	ULONGLONG statsmsecs = startmsecs;		// last periodic statistics report
+	if (statsmode) {
+		twstats_init();
+	}
 	printf("Press exit-key '%c' to interrupt if you don't like to run it a whole day ;-)\n", exitkey);
+// From here on, messages are written by the twlog writer thread, so a slow console doesn't slow down the detection
+	if (!twlog_start(logpolicy)) {
+		printf("Asynchronous console output not available, writing messages directly\n");
+	}
 
 // #############################################################################################################
 // Main processing Loop
 // #############################################################################################################
 
-// Cycle loop every second (-v : every two seconds)
-	for (int readloopctr = 1 ; readloopctr <= readloops ; readloopctr++)	{
+// Cycle loop every second (-v : every two seconds, -p : every given msecs) until the run deadline
+	for (int readloopctr = 1 ; ; readloopctr++)	{
 		saitektwfound = false;		// check for Saitek Trimwheel in this cycle
+		saitektwarrived = false;	// this cycle sees all controllers connected until now
+		cyclesrun = readloopctr;
+		twstats_begin();			// phase timing (--stats): the phases are chained from here, see twstats.h
 		if (cyclemessages) {
-			printf("\n*** Cycle %i of %i, exit='%c' ***\n", readloopctr, readloops, exitkey);
-		} else if ( verbolvl > 0 ) {
-			printf("\n\t#DBG1 %s@%d *** while-Cycle %i ***\n", __func__, __LINE__, readloopctr);
+			uint64_t elapsedms = (twclock_timestamp() - runstart) / 1000;
+			twlog_printf("\n*** Cycle %i at %llu.%03llu of %i secs, exit='%c' ***\n", readloopctr,
+				(unsigned long long)(elapsedms / 1000), (unsigned long long)(elapsedms % 1000), runsecs, exitkey);
+			twstats_skip();
+		} else if (DBGON(1)) {
+			twlog_printf("\n\t#DBG1 %s@%d *** while-Cycle %i ***\n", __func__, __LINE__, readloopctr);
 		} else {				// no cycle messages and no verbosity (totally silent):
 			advance_cursor();	// show a spinning wheel (afterwards cursor on last wheel character)
 		}
@@ -506,12 +1518,18 @@ int main(int argc, char** argv)
 // and that's what we do here.
 // Return value: true if work items are pending in the dispatcher's queue, false if no work items remain
 // Returns at the time that the queue is flushed
-		if ( verbolvl > 1 ) {
-			printf("\t#DBG2 %s@%d Calling GameInput dispatcher\n", __func__, __LINE__);
+		IFDBG(2) {
+			twlog_printf("\t#DBG2 %s@%d Calling GameInput dispatcher\n", __func__, __LINE__);
 		}
-		bool dispretc = dispatcher->Dispatch(0);
-		if ( verbolvl > 0 ) {
-			printf("\t#DBG1 %s@%d GameInput dispatcher work to do: %s\n", __func__, __LINE__, dispretc ? "yes" : "no");
+		bool dispretc = false;
+		if (threadmode) {
+			applydispatched(&joysticks);		// the dispatcher thread pumps GameInput, we apply what it has handed over
+		} else {
+			dispretc = dispatcher->Dispatch(0);
+		}
+		twstats_mark(TWSTATS_DISPATCH);
+		IFDBG(1) {
+			twlog_printf("\t#DBG1 %s@%d GameInput dispatcher work to do: %s\n", __func__, __LINE__, dispretc ? "yes" : "no");
 		}
 
 // #############################################################################################################
@@ -520,18 +1538,15 @@ int main(int argc, char** argv)
 
 // Now let's start the processing of the "GameInput stream" for a specific controller device,
 // a continuous data stream that consists of every action (buttons, switches, axis) on all filtered devices
-		if ( verbolvl > 0 ) {
-			printf("\t#DBG1 %s@%d Starting for-Loop over %i Joystick devices\n", __func__, __LINE__, joysticks.deviceCount);
+		IFDBG(1) {
+			twlog_printf("\t#DBG1 %s@%d Starting for-Loop over %i Joystick devices\n", __func__, __LINE__, joysticks.deviceCount);
 		}
 		for (uint32_t devctr = 0; devctr < joysticks.deviceCount; ++devctr)	{
-// Assume current device VID / PID unknown			
-			vid=0;
-			pid=0;
 // Define "reading" as instance of class IGameInputReading and capture/process controllers raw input data from the controllers...
 // Every input state change received from a device is captured in an IGameInputReading instance. 
 			IGameInputReading* reading;
-			if ( verbolvl > 1 ) {
-				printf("\t#DBG2 %s@%d Pointer 'reading' to IGameInputReading allocated, size is %zu\n", __func__, __LINE__, sizeof(gminputptr));
+			IFDBG(2) {
+				twlog_printf("\t#DBG2 %s@%d Pointer 'reading' to IGameInputReading allocated, size is %zu\n", __func__, __LINE__, sizeof(gminputptr));
   			}
 
 // #############################################################################################################
@@ -544,7 +1559,7 @@ int main(int argc, char** argv)
 // (another possible filter for Saitek Trimwheel would be "GameInputKindControllerAxis - Controller input from sticks")
 // Optional filter is 'joysticks.devices[devctr]', so information is returned only for the specific controller in our joysticks list
 //
-// The joysticks list is a pointer array addressed by pointer 'joysticks.devices' and is built by the first call of our callback routine
+// The joysticks registry keeps the dense pointer list 'joysticks.devices' and is built by the first call of our callback routine
 // As we specified 'GameInputBlockingEnumeration' for 'RegisterDeviceCallback',  an initial call for the callback routine
 // is made for every controller device at 'RegisterDeviceCallback', so our callback routine can build our pointer array
 
@@ -557,210 +1572,188 @@ int main(int argc, char** argv)
 // Location: C:\Program Files (x86)\Windows Kits\10\Include\10.0.22621.0\shared\winerror.h
 // Probably from other (nested) #include
 //
-			if (SUCCEEDED(gminputptr->GetCurrentReading(GameInputKindController, joysticks.devices[devctr], &reading)))	{
-				if ( verbolvl > 1 ) {
-					printf("\t#DBG2 %s@%d Created instance 'IGameInputReading', struc size is %zu, 'reading' ptr points to %p\n", __func__, __LINE__, sizeof(IGameInputReading), (void*)reading);
-				}
-				if ( cyclemessages) {
-					printf("--- Processing Controller %d ---\n", devctr);
+			HRESULT rdgresult = gminputptr->GetCurrentReading(GameInputKindController, joysticks.devices[devctr]->device, &reading);
+			twstats_mark(TWSTATS_READING);
+			if (SUCCEEDED(rdgresult))	{
+				IFDBG(2) {
+					twlog_printf("\t#DBG2 %s@%d Created instance 'IGameInputReading', struc size is %zu, 'reading' ptr points to %p\n", __func__, __LINE__, sizeof(IGameInputReading), (void*)reading);
 				}
-// Check device information for actual controller joysticks.devices[i], according to
-// https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinputdevice/methods/igameinputdevice_getdeviceinfo
-// https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/structs/gameinputdeviceinfo
-// We have to find the Saitek ProFlight Cessna Trim Wheel (VID: 0x6A3, PID: 0xBD4)
-				if ( verbolvl > 0 ) {
-					printf("\t#DBG1 %s@%d Now GetDeviceInfo for ctrl %i\n", __func__, __LINE__, devctr);
+				IFDBG(2) {
+					twlog_printf("\t#DBG2 %s@%d --- Processing Controller %d ---\n", __func__, __LINE__, devctr);
 				}
-// Get GameInputDeviceInfo contents by IGameInputDevice.GetDeviceInfo() into structure joydevinfo
-				joydevinfo = NULL;
-				joydevinfo = joysticks.devices[devctr]->GetDeviceInfo();
-// Valid address returned from GetDeviceInfo ?				
-				if (joydevinfo != NULL) {
-// Then check if size of returned data block is large enough
-					memsize = joydevinfo->infoSize;
-// Check returned structure at least as big as the first fields we want to process (should always happen)
-					if (memsize >= GmInpDevInfSize ) {
-						if ( verbolvl > 0 ) {
-							printf("\t#DBG1 %s@%d structure length %i vs. SizeOf: %i)\n", __func__, __LINE__, memsize, GmInpDevInfSize);
-						}
-						vid = joydevinfo->vendorId;
-						pid = joydevinfo->productId;
-						rev = joydevinfo->revisionNumber;
-						ifc = joydevinfo->interfaceNumber;
-						col = joydevinfo->collectionNumber;
-
-// #############################################################################################################
-// Not working: get device name from GameInput DeviceInfo for this specific controller
-// #############################################################################################################
-
-// Not implemented by Microsoft in DirectInput API V.0 ; removed by Microsoft in DirectInput API V.1 !
-// Maybe a search in these two registry locations would have solved it:
-// 1. HKCU\System\CurrentControlSet\Control\MediaResources\Joystick\DINPUT.DLL\CurrentJoystickSettings : Joystick1OEMName
-// 2. HKCU\System\CurrentControlSet\Control\MediaProperties\PrivateProperties\Joystick\OEM\VID_...&PID_...\OEMName
-// but that's beyond the scope of this "check script", so I left my debug statements (verbosity level 3 : -vvv)
-//
-// Linkage to device name:
-// joydevinfo : pointer to device data block structure GameInputDeviceInfo			
-// dispnameptr : pointer to displayName data block, address from pointer GameInputDeviceInfo.displayName
-// displayName : pointer to structure of type GameInputString with 
-//					"uint32_t sizeInBytes" : string size, "uint32_t codePointCount" : number of unicode characters
-//					and "char cont* data" : UTF-8 encoded Unicode string
-// But ! It seems, displayName is always a Nullpointer (see also https://github.com/microsoft/GDK/issues/35)
-// So only if verbosity level 3 (-vvv) is selected: print the GamInputDeviceInfo structure
-						if ( verbolvl > 2 ) {
-							int singlechar;
-// Load a pointer with the starting address of the GameInputDeviceInfo structure (pointed by joydevinfo)
-// The pointer points to "unsigned char", so we can easily print each byte
-							unsigned char *joyptr = (unsigned char *) &(joydevinfo->infoSize);
-							printf("\t#DBG3 %s@%d Dumping structure GameInputDeviceInfo\n", __func__, __LINE__);
-							printf("\t#DBG3 %s@%d joydevinfo pts to %p, joyptr to %p\n", __func__, __LINE__, (void *) joydevinfo, (void *) joyptr);
-							for (int ix = 1 ; ix < GmInpDevInfSize ; ++ix) {
-								singlechar = joyptr[0];
-								printf("\t#DBG3 %s@%d ix=%03i joyptr=%p byte: dec=%03i, hex=[%020x], char=[%c]\n", __func__, __LINE__, ix-1, joyptr, singlechar, joyptr[0], joyptr[0]);
-								joyptr++;
-							}
-// Load a pointer with the address of the displayName structure
-							const GameInputString *dispnameptr = joydevinfo->displayName;
-							printf("\t#DBG3 %s@%d Dumping substructure GameInputDeviceInfo.displayName\n", __func__, __LINE__ );
-							printf("\t#DBG3 %s@%d dispnameptr (loaded from %p) points to %p\n", __func__, __LINE__, (void *) &(joydevinfo->displayName), (void *) dispnameptr);
-							if (dispnameptr != NULL) {
-								for (int ix = 1 ; ix < 8 ; ++ix) {
-									singlechar = (char) dispnameptr->data[0];
-									printf("\t#DBG3 %s@%d ix=%i dispnmptr=%p char=[%020x]\n", __func__, __LINE__, ix, dispnameptr, singlechar);
-									dispnameptr++;
-								}
-							} else {
-								printf("\t#DBG3 %s@%d dispnameptr is zero, displayName structure not accessible\n", __func__, __LINE__);
-							}
-						}
-
-// #############################################################################################################
-// Some special processing for Saitek Trimwheel VID_06A&PID_0BD4 
-// #############################################################################################################
-
-// We have found the Saitek Trimwheel by VID/PID ?
-						if ( verbolvl > 0 ) {
-							printf("\t#DBG1 %s@%d InfoSize: %i, VID: 0x%04X, PID: 0x%04X, REV: 0x%04X, IFC: 0x%04X, COL: 0x%04X\n", __func__, __LINE__, 
-									memsize, vid, pid, rev, ifc, col);
-						}
-					} else {
-						if ( verbolvl > 0 ) {
-							printf("\t#DBG1 %s@%d GetDeviceInfo() gives structure too short in length (%i vs. SizeOf: %i)\n", __func__, __LINE__, 
-									memsize, GmInpDevInfSize);
-						}
-						printf("Cannot get information for Ctrl %i)\n", devctr);
+// Device information for actual controller joysticks.devices[i] was decoded once by deviceChangeCallback
+// when the controller connected (see decodedeviceinfo), so no GetDeviceInfo() per cycle is needed anymore
+				const Devregdesc* joydesc = &joysticks.devices[devctr]->desc;
+				if (joydesc->valid) {
+					IFDBG(1) {
+						twlog_printf("\t#DBG1 %s@%d InfoSize: %i, VID: 0x%04X, PID: 0x%04X, REV: 0x%04X, IFC: 0x%04X, COL: 0x%04X\n", __func__, __LINE__, 
+								joydesc->infosize, joydesc->vid, joydesc->pid, joydesc->rev, joydesc->ifc, joydesc->col);
 					}
 				} else {
-					printf("No pointer returned from GetDeviceInfo() to joydevptr \n");
+					twlog_printf("Cannot get information for Ctrl %i)\n", devctr);
 				}
+// Is this our Saitek Trimwheel ? (flag also decoded at connect time)
+				bool twdevice = joydesc->watched;
 
-				if ( verbolvl > 0 ) {
-					printf("\t#DBG1 %s@%d Get axes, switches and buttons for ctrl %i\n", __func__, __LINE__, devctr);
+				IFDBG(1) {
+					twlog_printf("\t#DBG1 %s@%d Get axes, switches and buttons for ctrl %i\n", __func__, __LINE__, devctr);
 				}
 // Now some special processing for our Saitek Trimwheel				
 // Only if allcontrollers-flag set or (in any case) Saitek Trimwheel
-				if ( allcontrollers || ((vid == saitektwvid) && (pid == saitektwpid)) ) {
-					if ( (vid == saitektwvid) && (pid == saitektwpid) ) {
+// (without allcontrollers-flag, the registry only holds controllers of our watch-list anyway)
+				if ( allcontrollers || twdevice ) {
+					if ( twdevice ) {
 						if (!saitektwfound) {
 							saitektwfound = true ;					// Mark Trimwheel found in this cycle
 							if (!saitektwthere) {					// The Trimwheel wasn't there until now
 								saitektwthere = true ;				// so we remember its presence for the following cycles (until it may be unplugged)
 // On first cycle, the Trimwheel is "detected", from second cycle onward it "appears"
 								if (readloopctr > 1) {
-									printf("*** Saitek Trimwheel device appeared, VID: 0x%04X, PID: 0x%04X ***\n", vid, pid);
+									twlog_printf("*** Saitek Trimwheel device appeared, VID: 0x%04X, PID: 0x%04X ***\n", joydesc->vid, joydesc->pid);
 								} else {
-									printf("*** Saitek Trimwheel device detected, VID: 0x%04X, PID: 0x%04X ***\n", vid, pid);
+									twlog_printf("*** Saitek Trimwheel device detected, VID: 0x%04X, PID: 0x%04X ***\n", joydesc->vid, joydesc->pid);
+								}
+								if (tracemode) {
+									twtrace_event(traceindex(&joysticks, joysticks.devices[devctr]), joydesc->vid, joydesc->pid,
+										(readloopctr > 1) ? TWTRACE_EV_APPEARED : TWTRACE_EV_DETECTED, reading->GetTimestamp());
+								}
+								if (jsonmode) {
+									twjson_event((readloopctr > 1) ? "appeared" : "detected", reading->GetTimestamp(),
+										joysticks.devices[devctr]->axes[0], -1);
 								}
 								if (twbeep) {
-  									Beep(twbeepfrqfound,500);		// trimwheel ready (first time or again) for axis check: short beep on primary sound device
+									{
+										Twstatsscope statsscope(TWSTATS_BEEP);
+  										twclock_beep(twbeepfrqfound,500);		// trimwheel ready (first time or again) for axis check: short beep on primary sound device
+									}
+									twstats_skip();			// the tone isn't part of the next phase
 								}
+// The user is about to turn the wheel: poll fast for a while (--adaptive)
+								twpoll_burst(twclock_timestamp());
 							}
 						}
 					}
-// Only if set by flag: print a line with VID/PID and no linefeed, replenished by axes/buttons/switches values in the following statements					
-					if (cyclemessages) {
-						printf("Controller %i (VID: 0x%04X, PID: 0x%04X):\t", devctr, vid, pid);
+// Nothing changed since the last cycle ? Every new reading of a device gets a new sequence number, see
+// https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinputreading/methods/igameinputreading_getsequencenumber
+// If it's still the same reading as in the last cycle, we skip state extraction, printing and readiness check
+// (the readiness of this reading has already been checked, otherwise we wouldn't be here anymore), unless the
+// Trimwheel's position has now held long enough to count as turned (see twready.h)
+					Devregentry* seqentry = joysticks.devices[devctr];
+					uint64_t rdgseq = reading->GetSequenceNumber(GameInputKindController);
+					if (seqentry->seqvalid && (rdgseq == seqentry->lastseq)
+						&& !(twdevice && twready_hold(&seqentry->ready, twclock_timestamp()))) {
+						++rdgskipped;
+						IFDBG(2) {
+							twlog_printf("\t#DBG2 %s@%d Ctrl %i unchanged, sequence %llu\n", __func__, __LINE__, devctr, (unsigned long long)rdgseq);
+						}
+						reading->Release();
+						continue;	// next controller
+					}
+					seqentry->seqvalid = true;
+					seqentry->lastseq = rdgseq;
+					seqentry->lasttimestamp = reading->GetTimestamp();
+					++rdgprocessed;
+					IFDBG(2) {
+						twlog_printf("\t#DBG2 %s@%d Ctrl %i new reading, sequence %llu, timestamp %llu\n", __func__, __LINE__, devctr,
+							(unsigned long long)rdgseq, (unsigned long long)seqentry->lasttimestamp);
+					}
 
 // #############################################################################################################
 // Get axes, buttons, switches positions for this specific controller
 // #############################################################################################################
-					}
 // see https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinputreading/methods/igameinputreading_getcontrolleraxisstate
 // Capture the axes, switches and buttons of the specific oysticks.devices[i]" controller into our own arrays
 //
 //
-// First get the state of axes, switches, buttons in our arrays.
-// We give the size of the array in parm1 and get back our array with values in parm2
-					reading->GetControllerAxisState(ARRAYSIZE(axes), axes);
-					reading->GetControllerSwitchState(ARRAYSIZE(switches), switches);
-					reading->GetControllerButtonState(ARRAYSIZE(buttons), buttons);
-// Seccond get the real number of axes, switches, buttons
-// According to the microsoft documentation, this should be done before getting the state to define the array size, but:
-// - the Saitek Trimwheel has just one axis and no buttons or switches
-// - information for other controllers is optional, it's a "Saitek Trimwheel Checker"
-// - Windows has a limit of 8 axes and 128 buttons per device
-// - many Games are limited to 8 axes and 32...64 buttons for each device
-					nbraxes = reading->GetControllerAxisCount();
-					nbrswch = reading->GetControllerSwitchCount();
-					nbrbutt = reading->GetControllerButtonCount();
-// If not suppressed: print what we have captured from the GameInput input stream for this specific controller
-					if (cyclemessages) {
-// First print the values of all axes
-						if (nbraxes > 0) {
-							printf("  Axes - ");
-							for (uint32_t axctr = 0; axctr < nbraxes; ++axctr) {
-								printf("%d:%f ", axctr, axes[axctr]);
-							} // end for axctr loop
-						} else {
-						printf (" No Axes ");
+// First take the real number of axes, switches, buttons from the device information decoded at connect time
+// (as the microsoft documentation recommends, before getting the state), e.g. the Saitek Trimwheel has just one axis
+// and no buttons or switches, so we copy just one float from GameInput.
+					Devregentry* joyentry = joysticks.devices[devctr];
+					axes = joyentry->axes;
+// Drain mode: evaluate the Trimwheel's readings between the last cycle and this one first, so its readiness detector
+// sees them in their order (the current reading again below is ignored by the detector, see twready.h).
+// Has to be done before we release the current reading, as it becomes the reference for the next cycle
+					bool drainturned = false;
+					float drainval = 0;
+					uint64_t draints = 0;
+					if ( drainmode && twdevice ) {
+						drainturned = drainreadings(gminputptr, &joysticks, joyentry, reading,
+							&drainval, &draints, &drainprocessed, &draindropped);
+						drainprocessedtotal += drainprocessed;
+						draindroppedtotal += draindropped;
+						twstats_mark(TWSTATS_DRAIN);
+						if (cyclemessages) {
+							twlog_printf("Trimwheel readings processed: %i, dropped: %i\n", drainprocessed, draindropped);
+							twstats_skip();
 						}
-// Second print the position of the switches
-						if (nbrswch > 0) {
-							printf("Switches - ");
-							for (uint32_t swctr = 0; swctr < nbrswch; ++swctr) {
-								printf("%d:%d ", swctr, switches[swctr]);
-							} // end for swctr loop
-						} else {
-							printf (" No Swi  ");
-						}
-// Third print the position of the buttons
-						if (nbrbutt > 0) {
-							printf("Buttons - ");
-							for (uint32_t btctr = 0; btctr < nbrbutt; ++btctr) {
-								if (buttons[btctr]) printf("%d ", btctr);
-							} // end for btctr loop
-						} else {
-							printf (" No Buttn");
-						}
-// puts just to print newline
-						puts("");
 					}
+// Second get the state of axes, switches, buttons into the controller's rows of the registry's state arrays.
+// This is done by the state handler of the controller's profile (twprofiles.h), instantiated by the compiler per profile
+// with the profile's fixed counts and deciding axis, or the generic handler for controllers without profile.
+// For a profile, it tells us also if the controller is "ready" (Trimwheel: its readiness detector has seen the wheel
+// turned) and its deciding axis value
+					float profilereadyval = 0;
+					bool profileready = Twhandlertable<Twknownprofiles>::handlers[joydesc->profile](reading, &joysticks, joyentry, &profilereadyval);
+// The current reading is the latest one: its position counts also if it has held long enough until now (a turn
+// between two cycles is a single position without drain mode, see twready.h)
+					if (!profileready && (joydesc->profile != 0) && twready_hold(&joyentry->ready, twclock_timestamp())) {
+						profileready = true;
+						profilereadyval = joyentry->ready.value;
+					}
+					twstats_mark(TWSTATS_STATE);
+					tracereading(&joysticks, joyentry, reading);
+// What we have captured is printed after all controllers, if it has changed (see printchanges)
 // Release the instance "reading" of class IGameInputReading used for this cycle
 					reading->Release();
 
 // Now processing the Saitek Trimwheel if found: has only axes[0]
-					if ( (vid == saitektwvid) && (pid == saitektwpid) ) {
-						if ( verbolvl > 0 ) {
-							printf("\t#DBG1 %s@%d Saitek Trimwheel found, VID: 0x%04X, PID: 0x%04X, axis value: %f\n", __func__, __LINE__, vid, pid, axes[0]);
+					if ( twdevice ) {
+// The wheel is moving: poll fast for a while (--adaptive)
+						pollaxis(axes[0]);
+						saitektwaxis = axes[0];
+						saitektwready = joyentry->ready;
+						twrotation_update(&saitektwrotation, rdgseq, joyentry->lasttimestamp, axes[0]);
+						if (cyclemessages && (saitektwrotation.readings != rotationshown)) {
+							rotationshown = saitektwrotation.readings;
+							twlog_printf("Trimwheel rotation: %+.2f revolutions (%.2f turned, %llu wraps), %.2f rev/s\n",
+								saitektwrotation.rotation, saitektwrotation.turned, (unsigned long long)saitektwrotation.wraps,
+								twrotation_rate(&saitektwrotation, twclock_timestamp()));
+						}
+						IFDBG(1) {
+							twlog_printf("\t#DBG1 %s@%d Saitek Trimwheel found, VID: 0x%04X, PID: 0x%04X, axis value: %f, readiness confidence %.2f\n",
+								__func__, __LINE__, joydesc->vid, joydesc->pid, axes[0], joyentry->ready.confidence);
 						}
-// We have found axis[0] (the only axis of the Trimwheel) turned (as its initial state at program start is zero and we have a non-zero state)
-						if ( axes[0] != 0 ) {
+// We have found axis[0] (the only axis of the Trimwheel) turned: its readiness detector has seen it move through enough
+// positions and travel since connect (the axis is zero at boot until the wheel is turned), see twready.h.
+// In drain mode, the detector has seen the readings since the last cycle too, the first turned one counts.
+// The events are only written once, the cycles go on after it with "--rotation"
+						if ( profileready || drainturned ) {
 							osretcode = osrc_axisnotzero;		// Trimwheel axis not equal 0 : wheel is initialized and turned
+							if (!saitektwturned) {
+								saitektwturnval = drainturned ? drainval : profilereadyval;
+								saitektwturnts = drainturned ? draints : joyentry->lasttimestamp;
+								if (tracemode) {
+									twtrace_event(traceindex(&joysticks, joyentry), joydesc->vid, joydesc->pid, TWTRACE_EV_TURNED, saitektwturnts);
+								}
+								if (jsonmode) {
+									twjson_event("turned", saitektwturnts, saitektwturnval, -1);
+								}
+							}
 							saitektwturned = true;
-							if ( verbolvl > 0 ) {
-								printf("\t#DBG1 %s@%d Saitek Trimwheel seems initialized, osretcode=%i\n", __func__, __LINE__, osretcode);
+							IFDBG(1) {
+								twlog_printf("\t#DBG1 %s@%d Saitek Trimwheel seems initialized, osretcode=%i\n", __func__, __LINE__, osretcode);
 							}
 						} else {
-							osretcode = osrc_axisiszero;		// Trimwheel axis equal 0 : uncertain about wheel initialized
-							if ( verbolvl > 0 ) {
-								printf("\t#DBG1 %s@%d Saitek Trimwheel axis is zero, osretcode=%i\n", __func__, __LINE__, osretcode);
+							osretcode = osrc_axisiszero;		// Trimwheel axis not turned (yet) : uncertain about wheel initialized
+							IFDBG(1) {
+								twlog_printf("\t#DBG1 %s@%d Saitek Trimwheel not turned yet, osretcode=%i\n", __func__, __LINE__, osretcode);
 							}
 						}
 					}
 				}
 			} else {			// GetCurrendReading was not successful for any reason
 				if ( cyclemessages) {
-					printf("GetCurrentReading without success for Game controller %d\n", devctr);
+					twlog_printf("GetCurrentReading without success for Game controller %d\n", devctr);
 				}
 			}
 
@@ -769,17 +1762,30 @@ int main(int argc, char** argv)
 // https://learn.microsoft.com/en-us/gaming/gdk/docs/reference/input/gameinput/interfaces/igameinputrawdevicereport/igameinputrawdevicereport
 // -> Note: This interface is not yet implemented.
 /*
-			retresult = gminputptr->GetCurrentReading(GameInputKindRawDeviceReport, joysticks.devices[devctr], &reading);
-			printf("Raw data by 'GetCurrentReading(GameInputKindRawDeviceReport', HRESULT=%x\n", retresult);
+			retresult = gminputptr->GetCurrentReading(GameInputKindRawDeviceReport, joysticks.devices[devctr]->device, &reading);
+			twlog_printf("Raw data by 'GetCurrentReading(GameInputKindRawDeviceReport', HRESULT=%x\n", retresult);
 */			
 
 		} // end for devctr loop
 // At this point, we have processed all controllers for this cycle
 
-// exit for-readloopctr loop (cycle loop) if Saitek Trimwheel found to be turned (Trimwheel turned once leads always to exit)
-		if (saitektwturned) {
-			if ( verbolvl > 0 ) {
-				printf("\t#DBG1 %s@%d Leaving for-readloopctr loop for Trimwheel axis not equal to zero\n", __func__, __LINE__);
+// Change detection: compare the state of all controllers with the last cycle at once (SIMD, see devregistry.h),
+// so only the controllers and fields that have changed are printed
+		statechanged += devreg_diffstate(&joysticks, &statechanges);
+		devreg_commitstate(&joysticks, &statechanges);
+		twstats_mark(TWSTATS_DIFF);
+// If not suppressed: print what we have captured from the GameInput input stream for the changed controllers
+		if (cyclemessages && (statechanges.count > 0)) {
+			printchanges(&joysticks, &statechanges);
+			twstats_mark(TWSTATS_PRINT);
+		}
+
+// exit for-readloopctr loop (cycle loop) if Saitek Trimwheel found to be turned (Trimwheel turned once leads always to exit,
+// except with "--rotation")
+		if (turnedexit()) {
+			twstats_end();
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d Leaving for-readloopctr loop for Trimwheel axis not equal to zero\n", __func__, __LINE__);
 			}
 			break; // exit for-readloopctr loop
 		}
@@ -787,42 +1793,210 @@ int main(int argc, char** argv)
 // if in this cycle no controller was a Saitek Trimwheel
 		if (!saitektwfound) {
 			if (saitektwthere) {		// Saitek Trimwheel was there in the previous cycle but in this cycle disappeared
-				printf("*** Saitek Trimwheel device disappeared (VID: 0x%04X, PID: 0x%04X) ***\n", saitektwvid, saitektwpid);
+				twlog_printf("*** Saitek Trimwheel device disappeared (VID: 0x%04X, PID: 0x%04X) ***\n", saitektwvid, saitektwpid);
+				if (tracemode) {
+					twtrace_event(TWTRACE_NODEVICE, saitektwvid, saitektwpid, TWTRACE_EV_DISAPPEARED, twclock_timestamp());
+				}
+				if (jsonmode) {
+					twjson_event("disappeared", twclock_timestamp(), saitektwaxis, -1);
+				}
 				saitektwthere = false ;
 			} else {				// Saitek Trimwheel wasn't there in the previous cycle and in this cycle too
-				printf("*** Saitek Trimwheel device not found (VID: 0x%04X, PID: 0x%04X) ***\n", saitektwvid, saitektwpid);
+				twlog_printf("*** Saitek Trimwheel device not found (VID: 0x%04X, PID: 0x%04X) ***\n", saitektwvid, saitektwpid);
+				if (tracemode) {
+					twtrace_event(TWTRACE_NODEVICE, saitektwvid, saitektwpid, TWTRACE_EV_NOTFOUND, twclock_timestamp());
+				}
 			}
+			twstats_skip();
 		}
 
 // exit for-readloopctr loop if exit key pressed
 		bool exitkeyflag = false;
 		while ( _kbhit() ) { // as long as there are keycodes in the input buffer
 			keypressed = toupper(_getch());
-			if ( verbolvl > 0 ) {
-				printf("\t#DBG1 %s@%d Key pressed: %i = '%c'\n", __func__, __LINE__, keypressed, keypressed);
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d Key pressed: %i = '%c'\n", __func__, __LINE__, keypressed, keypressed);
 			}
 			if (keypressed == exitkey) {
 				exitkeyflag = true;
-				printf("Exit-key '%c' detected, stopping loop\n",keypressed);
+				twlog_printf("Exit-key '%c' detected, stopping loop\n",keypressed);
 			}
 		}
+		twstats_mark(TWSTATS_KBHIT);
+// End of the cycle's work, the wait isn't part of the cycle time
+		uint64_t cyclens = twstats_end();
+#ifdef TW_FAKEGAMEINPUT
+		if (soakmode && twstats_active) {
+			soakcycle(&joysticks, cyclens, twclock_msecs() - startmsecs);
+		}
+#else
+		(void)cyclens;
+#endif
 		if (exitkeyflag) {
-			if ( verbolvl > 0 ) {
-				printf("\t#DBG1 %s@%d leaving for-readloopctr loop for exit-key, osretcode=%i\n", __func__, __LINE__, keypressed, keypressed, osretcode);
+			IFDBG(1) {
+				twlog_printf("\t#DBG1 %s@%d leaving for-readloopctr loop for exit-key, osretcode=%i\n", __func__, __LINE__, keypressed, keypressed, osretcode);
 			}
 			break; // exit for-readloopctr loop 
 		}
 
-// Wait a short moment, just not to overload our system
-		if ( verbolvl > 1 ) {
-			printf("\t#DBG2 %s@%d Sleeping for %i msecs\n", __func__, __LINE__, waitmsec);
+// Statistics every statsinterval seconds (--stats=N)
+		if (statsmode && (statsinterval > 0) && (twclock_msecs() - statsmsecs >= (ULONGLONG)statsinterval * 1000)) {
+			statsmsecs = twclock_msecs();
+			twstats_report();
+		}
+
+// Wait for the next cycle: until one period after the start of this cycle, but not beyond the end of the run.
+// A cycle that took longer than its period (slow console, tones) skips the missed starts instead of
+// running them back to back, so the cycles stay in their period.
+// The period is fixed (-p/-v) or depends on the Trimwheel's presence and movement (--adaptive)
+		uint64_t cycleperiod = twpoll_period(cycledeadline, saitektwthere);
+		cycledeadline += cycleperiod;
+		uint64_t now = twclock_timestamp();
+		if (now > cycledeadline) {
+			cycledeadline += (now - cycledeadline + cycleperiod - 1) / cycleperiod * cycleperiod;
+			overruns++;
+		}
+		if (now >= rundeadline) {
+			break; // exit for-readloopctr loop, run time is up
+		}
+		uint64_t wakeup = (cycledeadline < rundeadline) ? cycledeadline : rundeadline;
+		IFDBG(2) {
+			twlog_printf("\t#DBG2 %s@%d %s for %llu usecs\n", __func__, __LINE__, (eventmode || threadmode) ? "Waiting for readings" : "Sleeping",
+				(unsigned long long)(wakeup - now));
+		}
+		if (eventmode || threadmode) {
+// Event-driven: returns early if the reading callback has seen the Trimwheel turned
+// Dispatcher thread: returns early for it too, or when the thread has seen the Trimwheel connect
+			if (waitforreading(dispatcher, dispwaithandle, wakeup, &joysticks)) {
+				twlog_printf("*** Saitek Trimwheel turned, axis value: %f ***\n", saitektwturnval);
+				break; // exit for-readloopctr loop
+			}
+// Woken up early by a connecting Trimwheel: the next cycle starts now, the following ones count from here
+			uint64_t woken = twclock_timestamp();
+			if (woken < wakeup) {
+				cycledeadline = woken;
+				continue;
+			}
+		} else {
+			twclock_sleepuntil(wakeup);
+		}
+		if (wakeup == rundeadline) {
+			break; // exit for-readloopctr loop, run time is up
 		}
-		Sleep(waitmsec); // Wait 500 msecs
 	} // end for readloopctr loop
+	uint64_t runend = twclock_timestamp();
+// The callbacks run in the main thread again (and the thread must be joined before we return)
+	if (threadmode) {
+		twdispatch_stop();
+	}
+// JSON mode: all cycles done without the Trimwheel turned (and not stopped by exit key)
+	if (jsonmode && !saitektwturned && (keypressed != exitkey)) {
+		twjson_event("timeout", twclock_timestamp(), saitektwaxis, -1);
+	}
+// Write the pending messages, back to direct console output (a slow console or pipe may take a while for them)
+	uint64_t logstopts = twclock_timestamp();
+	twlog_stop();
+	logstopts = twclock_timestamp() - logstopts;
+	if (twlog_dropped() > 0) {
+		printf("Console messages dropped (-o): %llu\n", (unsigned long long)twlog_dropped());
+	}
+// Cycle schedule: cycles run, how often a cycle took longer than its period and how often we woke up for them
+	double runhours = (runend - runstart) / 3600000000.0;
+	uint64_t wakeupsperhour = (runhours > 0) ? (uint64_t)(twclock_wakeups() / runhours + 0.5) : 0;
+	printf("Cycles: %i in %.3f secs, period %i msecs%s, overruns: %llu, wakeups: %llu (%llu per hour)\n", cyclesrun,
+		(runend - runstart) / 1000000.0, waitmsec, adaptivemode ? " (adaptive)" : "", (unsigned long long)overruns,
+		(unsigned long long)twclock_wakeups(), (unsigned long long)wakeupsperhour);
+	if (threadmode) {
+		printf("Dispatcher thread: %llu Dispatch() calls, %llu events handed over (max. %llu queued of %i, %llu waits on a full queue)\n",
+			(unsigned long long)twdispatch_calls(), (unsigned long long)twdispatch_posted(),
+			(unsigned long long)twdispatch_maxqueued(), TWDISPATCH_RING, (unsigned long long)twdispatch_fullwaits());
+	}
+	if (adaptivemode) {
+		printf("Adaptive polling: %llu bursts of %u msecs at %u msecs period, idle period up to %u msecs\n",
+			(unsigned long long)twpoll_bursts(), pollpolicy.windowmsecs, pollpolicy.fastmsecs, pollpolicy.idlemsecs);
+	}
+// Statistics of the cycle loop phases, the memory of the device registry and the schedule (for benchmarks, see README)
+	if (statsmode) {
+		twstats_report();
+		printf("Device registry: %u controllers, %zu bytes fixed, %zu bytes of them controller state (change detection: %s)\n",
+			joysticks.deviceCount, sizeof(joysticks), devreg_statebytes(), devreg_simdname());
+		if (jsonmode) {
+			Twstatssummary summary;
+			for (int phase = 0; phase < TWSTATS_PHASES; ++phase) {
+				if (twstats_summary((Twstatsphase)phase, &summary)) {
+					twjson_stats(summary.name, summary.samples, summary.meanns, summary.p50ns, summary.p99ns, summary.maxns);
+				}
+			}
+			twjson_memory(joysticks.deviceCount, sizeof(joysticks), devreg_statebytes());
+			twjson_schedule(cyclesrun, twclock_wakeups(), wakeupsperhour, overruns, twpoll_bursts());
+		}
+	}
 // Play tone if trimwheel seems turned ("not zero") and ok
 	if (twbeep && (osretcode == osrc_axisnotzero)) {
-		Beep(twbeepwheelturned,500) ;	// trimwheel seems initialized and was turned
+		twclock_beep(twbeepwheelturned,500) ;	// trimwheel seems initialized and was turned
+	}
+// How often did we need GetDeviceInfo() ? Only once per controller connect (formerly once per controller and cycle)
+	ULONGLONG runmsecs = twclock_msecs() - startmsecs;
+	IFDBG(1) {
+		printf("\t#DBG1 %s@%d GetDeviceInfo calls: %llu in %llu msecs (%.1f per hour)\n", __func__, __LINE__,
+			(unsigned long long)getdevinfocalls, (unsigned long long)runmsecs, (runmsecs > 0) ? getdevinfocalls * 3600000.0 / runmsecs : 0.0);
 	}
+// Readings evaluated vs. skipped as unchanged
+	printf("Readings processed: %llu, skipped (unchanged): %llu, controllers with a changed state: %llu\n",
+		(unsigned long long)rdgprocessed, (unsigned long long)rdgskipped, (unsigned long long)statechanged);
+// Readiness detector of the Trimwheel: what it has seen until it decided (or until the end)
+	if (saitektwready.readings > 0) {
+		printf("Trimwheel readiness: %s, confidence %.2f (%u readings, %u positions, travel %.3f)\n",
+			saitektwready.ready ? "turned" : "not turned", saitektwready.confidence, saitektwready.readings,
+			saitektwready.positions, saitektwready.travel);
+	}
+// Rotation telemetry of the Trimwheel: all readings we have evaluated, with a ring of fixed size
+	if (saitektwrotation.readings > 0) {
+		printf("Trimwheel rotation: %.2f revolutions turned (net %+.2f, %llu wraps), peak %.2f rev/s (%llu readings, %zu bytes of state)\n",
+			saitektwrotation.turned, saitektwrotation.rotation, (unsigned long long)saitektwrotation.wraps, saitektwrotation.peakrate,
+			(unsigned long long)saitektwrotation.readings, sizeof(saitektwrotation));
+	}
+// Drain mode: summary of the processed readings
+	if (drainmode) {
+		printf("Trimwheel readings processed: %llu, dropped: %llu\n", (unsigned long long)drainprocessedtotal, (unsigned long long)draindroppedtotal);
+	}
+// Detection latency: from the GameInput timestamp of the reading with the turned wheel (the input itself)
+// to the end of the program, i.e. what the calling .bat script waits for RC=0 after the wheel has been turned
+	uint64_t exitts = twclock_timestamp();
+// Trace mode: the session ends with our RC, then cut the pre-allocated rest of the trace file
+	if (tracemode) {
+		twtrace_exit(osretcode, exitts);
+		twtrace_close();
+		printf("Trace records written to %s: %llu", tracefilename, (unsigned long long)twtrace_written());
+		if (twtrace_lost() > 0) {
+			printf(", lost (trace file can't grow): %llu", (unsigned long long)twtrace_lost());
+		}
+		printf("\n");
+	}
+	if (saitektwturned) {
+		printf("Detection latency: %.3f msecs (turned reading to program end, %.3f msecs of them for the pending console messages)\n",
+			(exitts - saitektwturnts) / 1000.0, logstopts / 1000.0);
+	}
+// JSON mode: last event with the return code
+	if (jsonmode) {
+		twjson_event("exit", exitts, saitektwturned ? saitektwturnval : saitektwaxis, osretcode);
+	}
+#ifdef TW_FAKEGAMEINPUT
+// Replay: the detection must come to the same result as in the recorded session
+	if ((replayfilename != NULL) && (replayrc >= 0)) {
+		if (osretcode == replayrc) {
+			printf("Replay: same RC as recorded\n");
+		} else {
+			printf("Replay: RC=%i, but the recorded session ended with RC=%i\n", osretcode, replayrc);
+			osretcode = osrc_err_replay;
+		}
+	}
+// Soak: the hours and their checks
+	if (soakmode && !soakreport()) {
+		osretcode = osrc_err_soak;
+	}
+#endif
+	twclock_exit();
 // Return to OS
 	printf("End program, RC=%i\n", osretcode) ;
 	return osretcode;
@@ -0,0 +1,484 @@
+/*
+	devregistry.cpp
+
+	Device registry for SaitekTrimwheel.cpp, see devregistry.h
+
+	Both hash tables use linear probing. On removal, the following entries of the probe chain
+	are shifted back ("backward shift deletion"), so we need no tombstones and lookups
+	never degrade over a long run with many connects/disconnects.
+
+	The state compare treats each state array as rows of bytes (one row per pool index) and sets a bit per row
+	that differs from its snapshot. With rows of at least one vector, a row's vectors are XORed into one and tested,
+	with shorter rows one vector compares several rows at once and the byte mask of the compare is split per row.
+	AVX2 is only used if the CPU (and the OS) supports it, SSE2 is part of x64.
+*/
+
+#include "devregistry.h"
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if (DEVREG_SIMD > 0) && (defined(_M_X64) || defined(__x86_64__))
+#define DEVREG_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+// MSVC compiles AVX2 intrinsics in any function, gcc/clang only in functions for this target
+#define DEVREG_AVX2FUNC
+#else
+#define DEVREG_AVX2FUNC __attribute__((target("avx2")))
+#endif
+#endif
+
+// Hash of a device pointer: objects are at least 16 byte aligned, so drop the low bits before mixing
+static uint32_t hashptr(const IGameInputDevice* device)
+{
+	uint64_t key = ((uint64_t)(uintptr_t)device) >> 4;
+	key *= 0x9E3779B97F4A7C15ull;			// Fibonacci hashing
+	return (uint32_t)(key >> 32) & (DEVREG_TABLESIZE - 1);
+}
+
+// Hash of a device id: the id is a hash value created by Windows, but ids of the same make may share their first
+// bytes (the fake's do), so all 32 bytes are mixed
+static uint32_t hashid(const APP_LOCAL_DEVICE_ID* deviceid)
+{
+	uint64_t words[sizeof(APP_LOCAL_DEVICE_ID) / 8];
+	memcpy(words, deviceid, sizeof(words));
+	uint64_t key = 0;
+	for (uint64_t word : words) {
+		key = (key ^ word) * 0x9E3779B97F4A7C15ull;
+	}
+	return (uint32_t)(key >> 32) & (DEVREG_TABLESIZE - 1);
+}
+
+static bool sameid(const APP_LOCAL_DEVICE_ID* id1, const APP_LOCAL_DEVICE_ID* id2)
+{
+	return memcmp(id1, id2, sizeof(APP_LOCAL_DEVICE_ID)) == 0;
+}
+
+// Home slot of a pool entry in one of the two tables
+static uint32_t homeslot(const Devregistry* reg, const uint16_t* table, uint16_t poolidx)
+{
+	if (table == reg->byptr) {
+		return hashptr(reg->pool[poolidx].device);
+	}
+	return hashid(&reg->pool[poolidx].deviceid);
+}
+
+// Remove the pool index at 'slot' from a table and close the gap in its probe chain
+static void tableerase(Devregistry* reg, uint16_t* table, uint32_t slot)
+{
+	uint32_t next = slot;
+	for (;;) {
+		table[slot] = DEVREG_EMPTY;
+		for (;;) {
+			next = (next + 1) & (DEVREG_TABLESIZE - 1);
+			if (table[next] == DEVREG_EMPTY) {
+				return;
+			}
+// Shift the entry back only if its home slot isn't cyclically between the gap and its current slot
+			uint32_t home = homeslot(reg, table, table[next]);
+			if (((next - home) & (DEVREG_TABLESIZE - 1)) >= ((next - slot) & (DEVREG_TABLESIZE - 1))) {
+				break;
+			}
+		}
+		table[slot] = table[next];
+		slot = next;
+	}
+}
+
+void devreg_init(Devregistry* reg)
+{
+	reg->deviceCount = 0;
+	for (uint32_t ix = 0; ix < DEVREG_MAXDEVICES; ++ix) {
+// Hand out low pool indexes first
+		reg->freelist[ix] = (uint16_t)(DEVREG_MAXDEVICES - 1 - ix);
+		reg->devices[ix] = NULL;
+		reg->pool[ix].axes = reg->axes[ix];
+		reg->pool[ix].switches = reg->switches[ix];
+		reg->pool[ix].buttons = reg->buttons[ix];
+	}
+	memset(reg->axes, 0, sizeof(reg->axes));
+	memset(reg->prevaxes, 0, sizeof(reg->prevaxes));
+	memset(reg->buttons, 0, sizeof(reg->buttons));
+	memset(reg->prevbuttons, 0, sizeof(reg->prevbuttons));
+	memset(reg->switches, 0, sizeof(reg->switches));
+	memset(reg->prevswitches, 0, sizeof(reg->prevswitches));
+	memset(reg->fresh, 0, sizeof(reg->fresh));
+	reg->freecount = DEVREG_MAXDEVICES;
+	reg->poolend = 0;
+	for (uint32_t ix = 0; ix < DEVREG_TABLESIZE; ++ix) {
+		reg->byptr[ix] = DEVREG_EMPTY;
+		reg->byid[ix] = DEVREG_EMPTY;
+	}
+}
+
+Devregentry* devreg_find(const Devregistry* reg, const IGameInputDevice* device)
+{
+	for (uint32_t slot = hashptr(device); reg->byptr[slot] != DEVREG_EMPTY; slot = (slot + 1) & (DEVREG_TABLESIZE - 1)) {
+		if (reg->pool[reg->byptr[slot]].device == device) {
+			return (Devregentry*)&reg->pool[reg->byptr[slot]];
+		}
+	}
+	return NULL;
+}
+
+Devregentry* devreg_findid(const Devregistry* reg, const APP_LOCAL_DEVICE_ID* deviceid)
+{
+	for (uint32_t slot = hashid(deviceid); reg->byid[slot] != DEVREG_EMPTY; slot = (slot + 1) & (DEVREG_TABLESIZE - 1)) {
+		if (sameid(&reg->pool[reg->byid[slot]].deviceid, deviceid)) {
+			return (Devregentry*)&reg->pool[reg->byid[slot]];
+		}
+	}
+	return NULL;
+}
+
+Devregentry* devreg_insert(Devregistry* reg, IGameInputDevice* device, const APP_LOCAL_DEVICE_ID* deviceid)
+{
+	Devregentry* entry = devreg_find(reg, device);
+	if (entry != NULL) {
+		return entry;
+	}
+	if (reg->freecount == 0) {
+		return NULL;
+	}
+	uint16_t poolidx = reg->freelist[--reg->freecount];
+	entry = &reg->pool[poolidx];
+	entry->device = device;
+	entry->deviceid = *deviceid;
+	entry->lastreading = NULL;
+	entry->lastseq = 0;
+	entry->lasttimestamp = 0;
+	entry->seqvalid = false;
+	entry->denseidx = reg->deviceCount;
+	reg->devices[reg->deviceCount++] = entry;
+	if (poolidx >= reg->poolend) {
+		reg->poolend = poolidx + 1u;
+	}
+	device->AddRef();
+
+	uint32_t slot = hashptr(device);
+	while (reg->byptr[slot] != DEVREG_EMPTY) {
+		slot = (slot + 1) & (DEVREG_TABLESIZE - 1);
+	}
+	reg->byptr[slot] = poolidx;
+	slot = hashid(deviceid);
+	while (reg->byid[slot] != DEVREG_EMPTY) {
+		slot = (slot + 1) & (DEVREG_TABLESIZE - 1);
+	}
+	reg->byid[slot] = poolidx;
+	return entry;
+}
+
+// Zero the state rows of a pool entry and their snapshot: the whole rows, so the bytes beyond the controller's counts
+// never differ from the snapshot, and a freed row below poolend compares equal until it is used again
+static void clearrows(Devregistry* reg, uint32_t poolidx)
+{
+	memset(reg->axes[poolidx], 0, sizeof(reg->axes[poolidx]));
+	memset(reg->prevaxes[poolidx], 0, sizeof(reg->prevaxes[poolidx]));
+	memset(reg->buttons[poolidx], 0, sizeof(reg->buttons[poolidx]));
+	memset(reg->prevbuttons[poolidx], 0, sizeof(reg->prevbuttons[poolidx]));
+	memset(reg->switches[poolidx], 0, sizeof(reg->switches[poolidx]));
+	memset(reg->prevswitches[poolidx], 0, sizeof(reg->prevswitches[poolidx]));
+}
+
+void devreg_resetstate(Devregistry* reg, Devregentry* entry)
+{
+	if (entry->desc.nbraxes > DEVREG_MAXAXES) {
+		entry->desc.nbraxes = DEVREG_MAXAXES;
+	}
+	if (entry->desc.nbrbutt > DEVREG_MAXBUTTONS) {
+		entry->desc.nbrbutt = DEVREG_MAXBUTTONS;
+	}
+	if (entry->desc.nbrswch > DEVREG_MAXSWITCHES) {
+		entry->desc.nbrswch = DEVREG_MAXSWITCHES;
+	}
+	uint32_t poolidx = (uint32_t)(entry - reg->pool);
+	clearrows(reg, poolidx);
+	reg->fresh[poolidx / 64] |= 1ull << (poolidx % 64);
+	twready_reset(&entry->ready);
+}
+
+size_t devreg_statebytes()
+{
+	return sizeof(((Devregistry*)0)->axes) + sizeof(((Devregistry*)0)->prevaxes) + sizeof(((Devregistry*)0)->buttons)
+		+ sizeof(((Devregistry*)0)->prevbuttons) + sizeof(((Devregistry*)0)->switches) + sizeof(((Devregistry*)0)->prevswitches);
+}
+
+void devreg_packbuttons(const bool* buttons, uint32_t count, uint64_t* bits)
+{
+	for (uint32_t word = 0; word < (count + 63) / 64; ++word) {
+		uint64_t wordbits = 0;
+		uint32_t wordend = (count - word * 64 < 64) ? count - word * 64 : 64;
+		for (uint32_t bit = 0; bit < wordend; ++bit) {
+			wordbits |= (uint64_t)(buttons[word * 64 + bit] ? 1 : 0) << bit;
+		}
+		bits[word] = wordbits;
+	}
+}
+
+void devreg_packswitches(const GameInputSwitchPosition* switches, uint32_t count, uint8_t* bytes)
+{
+	for (uint32_t ix = 0; ix < count; ++ix) {
+		bytes[ix] = (uint8_t)switches[ix];
+	}
+}
+
+// #############################################################################################################
+// State compare
+// #############################################################################################################
+// Each function sets bit 'row' in 'bits' for each of the rows 'firstrow'...'rows'-1 of 'rowbytes' bytes
+// that differs between 'cur' and 'prev'. The row size is a template parameter, so the compiler unrolls the loops
+template <size_t rowbytes>
+static void diffrows_scalar(const uint8_t* cur, const uint8_t* prev, uint32_t firstrow, uint32_t rows, uint64_t* bits)
+{
+	for (uint32_t row = firstrow; row < rows; ++row) {
+		uint64_t acc = 0;
+		for (size_t offset = 0; offset < rowbytes; offset += sizeof(uint64_t)) {
+			uint64_t curword, prevword;
+			memcpy(&curword, cur + row * rowbytes + offset, sizeof(uint64_t));
+			memcpy(&prevword, prev + row * rowbytes + offset, sizeof(uint64_t));
+			acc |= curword ^ prevword;
+		}
+		if (acc != 0) {
+			bits[row / 64] |= 1ull << (row % 64);
+		}
+	}
+}
+
+#ifdef DEVREG_X64
+template <size_t rowbytes>
+static void diffrows_sse2(const uint8_t* cur, const uint8_t* prev, uint32_t firstrow, uint32_t rows, uint64_t* bits)
+{
+	uint32_t row = firstrow;
+	if constexpr (rowbytes >= 16) {
+		for (; row < rows; ++row) {
+			__m128i acc = _mm_setzero_si128();
+			for (size_t offset = 0; offset < rowbytes; offset += 16) {
+				__m128i curvec = _mm_load_si128((const __m128i*)(cur + row * rowbytes + offset));
+				__m128i prevvec = _mm_load_si128((const __m128i*)(prev + row * rowbytes + offset));
+				acc = _mm_or_si128(acc, _mm_xor_si128(curvec, prevvec));
+			}
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF) {
+				bits[row / 64] |= 1ull << (row % 64);
+			}
+		}
+	} else {
+// Rows of 8 bytes: two rows per compare, one half of the byte mask each
+		for (; row + 2 <= rows; row += 2) {
+			__m128i curvec = _mm_load_si128((const __m128i*)(cur + row * rowbytes));
+			__m128i prevvec = _mm_load_si128((const __m128i*)(prev + row * rowbytes));
+			uint32_t equal = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(curvec, prevvec));
+			uint64_t rowbits = (((equal & 0xFF) != 0xFF) ? 1 : 0) | (((equal >> 8) != 0xFF) ? 2 : 0);
+			bits[row / 64] |= rowbits << (row % 64);
+		}
+		diffrows_scalar<rowbytes>(cur, prev, row, rows, bits);
+	}
+}
+
+template <size_t rowbytes>
+DEVREG_AVX2FUNC static void diffrows_avx2(const uint8_t* cur, const uint8_t* prev, uint32_t firstrow, uint32_t rows, uint64_t* bits)
+{
+	uint32_t row = firstrow;
+	if constexpr (rowbytes >= 32) {
+		for (; row < rows; ++row) {
+			__m256i acc = _mm256_setzero_si256();
+			for (size_t offset = 0; offset < rowbytes; offset += 32) {
+				__m256i curvec = _mm256_load_si256((const __m256i*)(cur + row * rowbytes + offset));
+				__m256i prevvec = _mm256_load_si256((const __m256i*)(prev + row * rowbytes + offset));
+				acc = _mm256_or_si256(acc, _mm256_xor_si256(curvec, prevvec));
+			}
+			if (!_mm256_testz_si256(acc, acc)) {
+				bits[row / 64] |= 1ull << (row % 64);
+			}
+		}
+	} else {
+// Rows of 8 or 16 bytes: 4 or 2 rows per compare, 'rowbytes' bits of the byte mask each
+		constexpr uint32_t rowspervec = 32 / rowbytes;
+		constexpr uint64_t rowmask = (1ull << rowbytes) - 1;
+		for (; row + rowspervec <= rows; row += rowspervec) {
+			__m256i curvec = _mm256_load_si256((const __m256i*)(cur + row * rowbytes));
+			__m256i prevvec = _mm256_load_si256((const __m256i*)(prev + row * rowbytes));
+			uint64_t equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(curvec, prevvec));
+			uint64_t rowbits = 0;
+			for (uint32_t vecrow = 0; vecrow < rowspervec; ++vecrow) {
+				rowbits |= (uint64_t)(((equal >> (vecrow * rowbytes)) & rowmask) != rowmask) << vecrow;
+			}
+			bits[row / 64] |= rowbits << (row % 64);
+		}
+		diffrows_scalar<rowbytes>(cur, prev, row, rows, bits);
+	}
+}
+
+static int cpulevel()
+{
+#if DEVREG_SIMD >= 2
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 1);
+	bool osxsave = (regs[2] & (1 << 27)) != 0;
+	__cpuidex(regs, 7, 0);
+	if (osxsave && ((regs[1] & (1 << 5)) != 0) && ((_xgetbv(0) & 6) == 6)) {
+		return 2;
+	}
+#else
+	if (__builtin_cpu_supports("avx2")) {
+		return 2;
+	}
+#endif
+#endif
+	return 1;
+}
+#else
+static int cpulevel()
+{
+	return 0;
+}
+#endif
+
+// Index of the lowest set bit of a non-zero word
+static uint32_t lowestbit(uint64_t word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(word);
+#endif
+}
+
+// Row sizes of the three state arrays
+static constexpr size_t axesrow = sizeof(((Devregistry*)0)->axes[0]);
+static constexpr size_t buttonsrow = sizeof(((Devregistry*)0)->buttons[0]);
+static constexpr size_t switchesrow = sizeof(((Devregistry*)0)->switches[0]);
+
+typedef void (*Diffrowsfunc)(const uint8_t* cur, const uint8_t* prev, uint32_t firstrow, uint32_t rows, uint64_t* bits);
+
+// The compare functions of the three arrays, chosen on the first call
+static Diffrowsfunc diffaxes = NULL;
+static Diffrowsfunc diffbuttons = NULL;
+static Diffrowsfunc diffswitches = NULL;
+static int simdlevel = 0;
+
+static void choosediffrows()
+{
+	simdlevel = cpulevel();
+#ifdef DEVREG_X64
+	if (simdlevel >= 2) {
+		diffaxes = diffrows_avx2<axesrow>;
+		diffbuttons = diffrows_avx2<buttonsrow>;
+		diffswitches = diffrows_avx2<switchesrow>;
+		return;
+	}
+	diffaxes = diffrows_sse2<axesrow>;
+	diffbuttons = diffrows_sse2<buttonsrow>;
+	diffswitches = diffrows_sse2<switchesrow>;
+#else
+	diffaxes = diffrows_scalar<axesrow>;
+	diffbuttons = diffrows_scalar<buttonsrow>;
+	diffswitches = diffrows_scalar<switchesrow>;
+#endif
+}
+
+const char* devreg_simdname()
+{
+	if (diffaxes == NULL) {
+		choosediffrows();
+	}
+	static const char* names[] = { "scalar", "SSE2", "AVX2" };
+	return names[simdlevel];
+}
+
+uint32_t devreg_diffstate(const Devregistry* reg, Devregchanges* changes)
+{
+	if (diffaxes == NULL) {
+		choosediffrows();
+	}
+// Rows up to the highest pool index in use, whole 64 bit words of the result
+	uint32_t words = (reg->poolend + 63) / 64;
+	memset(changes->axes, 0, words * sizeof(uint64_t));
+	memset(changes->buttons, 0, words * sizeof(uint64_t));
+	memset(changes->switches, 0, words * sizeof(uint64_t));
+	diffaxes((const uint8_t*)reg->axes, (const uint8_t*)reg->prevaxes, 0, reg->poolend, changes->axes);
+	diffbuttons((const uint8_t*)reg->buttons, (const uint8_t*)reg->prevbuttons, 0, reg->poolend, changes->buttons);
+	diffswitches(reg->switches[0], reg->prevswitches[0], 0, reg->poolend, changes->switches);
+	changes->count = 0;
+	for (uint32_t word = 0; word < words; ++word) {
+		changes->axes[word] |= reg->fresh[word];
+		changes->buttons[word] |= reg->fresh[word];
+		changes->switches[word] |= reg->fresh[word];
+		uint64_t anybits = changes->axes[word] | changes->buttons[word] | changes->switches[word];
+		while (anybits != 0) {
+			changes->changed[changes->count++] = (uint16_t)(word * 64 + lowestbit(anybits));
+			anybits &= anybits - 1;
+		}
+	}
+	return changes->count;
+}
+
+uint8_t devreg_changedfields(const Devregchanges* changes, uint16_t poolidx)
+{
+	uint32_t word = poolidx / 64;
+	uint32_t bit = poolidx % 64;
+	return (uint8_t)((((changes->axes[word] >> bit) & 1) ? DEVREG_CHGAXES : 0)
+		| (((changes->buttons[word] >> bit) & 1) ? DEVREG_CHGBUTTONS : 0)
+		| (((changes->switches[word] >> bit) & 1) ? DEVREG_CHGSWITCHES : 0));
+}
+
+void devreg_commitstate(Devregistry* reg, const Devregchanges* changes)
+{
+	for (uint32_t ix = 0; ix < changes->count; ++ix) {
+		uint16_t poolidx = changes->changed[ix];
+		uint8_t fields = devreg_changedfields(changes, poolidx);
+		if (fields & DEVREG_CHGAXES) {
+			memcpy(reg->prevaxes[poolidx], reg->axes[poolidx], sizeof(reg->axes[poolidx]));
+		}
+		if (fields & DEVREG_CHGBUTTONS) {
+			memcpy(reg->prevbuttons[poolidx], reg->buttons[poolidx], sizeof(reg->buttons[poolidx]));
+		}
+		if (fields & DEVREG_CHGSWITCHES) {
+			memcpy(reg->prevswitches[poolidx], reg->switches[poolidx], sizeof(reg->switches[poolidx]));
+		}
+	}
+	memset(reg->fresh, 0, sizeof(reg->fresh));
+}
+
+bool devreg_remove(Devregistry* reg, IGameInputDevice* device)
+{
+	uint32_t slot = hashptr(device);
+	while ((reg->byptr[slot] != DEVREG_EMPTY) && (reg->pool[reg->byptr[slot]].device != device)) {
+		slot = (slot + 1) & (DEVREG_TABLESIZE - 1);
+	}
+	if (reg->byptr[slot] == DEVREG_EMPTY) {
+		return false;
+	}
+	uint16_t poolidx = reg->byptr[slot];
+	Devregentry* entry = &reg->pool[poolidx];
+	tableerase(reg, reg->byptr, slot);
+
+	slot = hashid(&entry->deviceid);
+	while (reg->byid[slot] != poolidx) {
+		slot = (slot + 1) & (DEVREG_TABLESIZE - 1);
+	}
+	tableerase(reg, reg->byid, slot);
+
+// Close the gap in the dense list with its last entry
+	Devregentry* lastentry = reg->devices[--reg->deviceCount];
+	reg->devices[entry->denseidx] = lastentry;
+	lastentry->denseidx = entry->denseidx;
+	reg->devices[reg->deviceCount] = NULL;
+
+	if (entry->lastreading != NULL) {
+		entry->lastreading->Release();
+		entry->lastreading = NULL;
+	}
+	entry->device->Release();
+	entry->device = NULL;
+	clearrows(reg, poolidx);
+	reg->fresh[poolidx / 64] &= ~(1ull << (poolidx % 64));
+	reg->freelist[reg->freecount++] = poolidx;
+	return true;
+}
@@ -0,0 +1,174 @@
+/*
+	devregistry.h
+
+	Device registry for SaitekTrimwheel.cpp, published under MIT license like the main program.
+
+	Keeps the controllers reported by GameInput's device callback in a fixed-size pool
+	and finds them by two open-addressing hash tables (linear probing):
+	* by IGameInputDevice pointer (as given to deviceChangeCallback)
+	* by APP_LOCAL_DEVICE_ID (GameInputDeviceInfo.deviceId, stable over reconnects)
+	Insert, lookup and removal are O(1), the registry itself allocates nothing.
+	For the cycle loop, the registered devices are additionally kept in a dense pointer list
+	(devices[0] ... devices[deviceCount-1]), removal moves the last entry into the freed position.
+
+	The state of all controllers is kept structure-of-arrays, one row per pool entry: a float array for the axes,
+	a bitset for the buttons and a byte array for the switches, each with a copy of the last cycle (snapshot).
+	devreg_diffstate() compares the whole arrays against the snapshot, with SSE2/AVX2 (see CMake option
+	SAITEKTW_SIMD) or scalar, and returns the controllers and fields that have changed, so the cycle loop only
+	touches these; devreg_commitstate() then copies the changed rows into the snapshot.
+	A controller with more than DEVREG_MAXAXES axes, DEVREG_MAXBUTTONS buttons or DEVREG_MAXSWITCHES switches
+	is read up to these counts.
+
+	Modifications:
+	replaces the realloc'd pointer array "Joystruct" of SaitekTrimwheel.cpp
+*/
+#pragma once
+
+#include "GameInput.h"
+#include "twready.h"
+
+// Max. number of controllers registered at the same time (Windows itself supports far less game controllers)
+// CMake option SAITEKTW_MAXDEVICES sets it for scaling benchmarks with thousands of fake controllers
+#ifndef DEVREG_MAXDEVICES
+#define DEVREG_MAXDEVICES	256
+#endif
+// Slots of each hash table, power of 2 and twice the pool size, so probe chains stay short
+#define DEVREG_TABLESIZE	(2 * DEVREG_MAXDEVICES)
+// Marks an empty hash table slot
+#define DEVREG_EMPTY		0xFFFF
+
+// State of one controller kept in the registry (row sizes are powers of 2 of at least 8 bytes for the SIMD compare)
+#ifndef DEVREG_MAXAXES
+#define DEVREG_MAXAXES		16
+#endif
+#ifndef DEVREG_MAXBUTTONS
+#define DEVREG_MAXBUTTONS	128
+#endif
+#ifndef DEVREG_MAXSWITCHES
+#define DEVREG_MAXSWITCHES	8
+#endif
+#define DEVREG_BUTTONWORDS	(DEVREG_MAXBUTTONS / 64)
+// Words of a bitset with one bit per pool entry
+#define DEVREG_POOLWORDS	((DEVREG_MAXDEVICES + 63) / 64)
+// Highest SIMD level of devreg_diffstate: 0 = scalar, 1 = SSE2, 2 = AVX2 if the CPU has it (CMake option SAITEKTW_SIMD)
+#ifndef DEVREG_SIMD
+#define DEVREG_SIMD			2
+#endif
+
+static_assert((DEVREG_MAXDEVICES & (DEVREG_MAXDEVICES - 1)) == 0, "DEVREG_MAXDEVICES must be a power of 2");
+static_assert(DEVREG_TABLESIZE <= DEVREG_EMPTY, "pool indexes must fit into the uint16_t hash table slots");
+static_assert((DEVREG_MAXAXES >= 2) && ((DEVREG_MAXAXES & (DEVREG_MAXAXES - 1)) == 0), "DEVREG_MAXAXES must be a power of 2 of at least 2");
+static_assert((DEVREG_MAXBUTTONS >= 64) && ((DEVREG_MAXBUTTONS & (DEVREG_MAXBUTTONS - 1)) == 0), "DEVREG_MAXBUTTONS must be a power of 2 of at least 64");
+static_assert((DEVREG_MAXSWITCHES >= 8) && ((DEVREG_MAXSWITCHES & (DEVREG_MAXSWITCHES - 1)) == 0), "DEVREG_MAXSWITCHES must be a power of 2 of at least 8");
+
+// Fields of a controller's state, see devreg_changedfields
+#define DEVREG_CHGAXES		0x01
+#define DEVREG_CHGBUTTONS	0x02
+#define DEVREG_CHGSWITCHES	0x04
+
+// Compact copy of the controller's GameInputDeviceInfo, decoded once when the controller connects
+struct Devregdesc
+{
+	uint32_t infosize;						// GameInputDeviceInfo.infoSize as returned by GetDeviceInfo()
+	uint16_t vid;							// Vendor-ID
+	uint16_t pid;							// Product-ID
+	uint16_t rev;							// revision number
+	uint8_t ifc;							// interface number
+	uint8_t col;							// collection number
+	uint32_t nbraxes;						// number of axes (max. DEVREG_MAXAXES once registered)
+	uint32_t nbrbutt;						// number of buttons (max. DEVREG_MAXBUTTONS)
+	uint32_t nbrswch;						// number of switches (max. DEVREG_MAXSWITCHES)
+	bool valid;								// false if GetDeviceInfo() returned nothing usable
+	bool watched;							// this is a device we are watching for (has a profile, see twprofiles.h)
+	uint8_t profile;						// profile id of the device (twprofiles.h), 0 = no profile
+};
+
+// One registered controller
+struct Devregentry
+{
+	IGameInputDevice* device;				// GameInput device object (we hold a reference while registered)
+	APP_LOCAL_DEVICE_ID deviceid;			// GameInput's app-local device id
+	Devregdesc desc;						// decoded device information (filled by the caller after devreg_insert)
+	IGameInputReading* lastreading;			// last processed reading (drain mode "-d"), NULL if none yet
+	uint32_t denseidx;						// position of this entry in the dense list Devregistry.devices
+	uint64_t lastseq;						// sequence number of the last evaluated reading (GameInputKindController)
+	uint64_t lasttimestamp;					// GameInput timestamp of the last evaluated reading
+	bool seqvalid;							// false until the first reading has been evaluated
+	float* axes;							// the entry's row of Devregistry.axes: desc.nbraxes axes (at least 1)
+	uint8_t* switches;						// row of Devregistry.switches: desc.nbrswch switches (GameInputSwitchPosition)
+	uint64_t* buttons;						// row of Devregistry.buttons: desc.nbrbutt buttons as bitset, button n in buttons[n/64] bit n%64
+	Twready ready;							// readiness detector of a controller with profile (twready.h)
+};
+
+// The registry itself, one instance per program (about 90 KB with 256 controllers, so better static than on the stack)
+struct Devregistry
+{
+	uint32_t deviceCount;							// number of registered controllers
+	Devregentry* devices[DEVREG_MAXDEVICES];		// dense list of registered controllers for the cycle loop
+	Devregentry pool[DEVREG_MAXDEVICES];			// storage of all entries
+	uint16_t freelist[DEVREG_MAXDEVICES];			// stack of unused pool indexes
+	uint32_t freecount;								// number of unused pool indexes on the stack
+	uint32_t poolend;								// highest pool index ever used + 1, devreg_diffstate compares up to here
+	uint16_t byptr[DEVREG_TABLESIZE];				// hash table by device pointer: pool index or DEVREG_EMPTY
+	uint16_t byid[DEVREG_TABLESIZE];				// hash table by device id: pool index or DEVREG_EMPTY
+// State of all controllers by pool index, and the snapshot devreg_diffstate compares with
+	alignas(64) float axes[DEVREG_MAXDEVICES][DEVREG_MAXAXES];
+	alignas(64) float prevaxes[DEVREG_MAXDEVICES][DEVREG_MAXAXES];
+	alignas(64) uint64_t buttons[DEVREG_MAXDEVICES][DEVREG_BUTTONWORDS];
+	alignas(64) uint64_t prevbuttons[DEVREG_MAXDEVICES][DEVREG_BUTTONWORDS];
+	alignas(64) uint8_t switches[DEVREG_MAXDEVICES][DEVREG_MAXSWITCHES];
+	alignas(64) uint8_t prevswitches[DEVREG_MAXDEVICES][DEVREG_MAXSWITCHES];
+	uint64_t fresh[DEVREG_POOLWORDS];				// connected since the last commit: all fields count as changed
+	bool buttonscratch[DEVREG_MAXBUTTONS];			// GameInput returns buttons as bool array, we pack them from here
+	GameInputSwitchPosition switchscratch[DEVREG_MAXSWITCHES];	// and switches as enum array
+};
+
+// Result of devreg_diffstate: one bit per pool index for each field, and the changed pool indexes in ascending order
+struct Devregchanges
+{
+	uint64_t axes[DEVREG_POOLWORDS];
+	uint64_t buttons[DEVREG_POOLWORDS];
+	uint64_t switches[DEVREG_POOLWORDS];
+	uint16_t changed[DEVREG_MAXDEVICES];			// pool indexes of the controllers with any changed field
+	uint32_t count;									// number of them
+};
+
+// Initialize an empty registry, has to be called once before any other function
+void devreg_init(Devregistry* reg);
+
+// Register a controller, returns the new (or already existing) entry, NULL if the pool is exhausted
+// A new entry takes a reference on the device (AddRef)
+Devregentry* devreg_insert(Devregistry* reg, IGameInputDevice* device, const APP_LOCAL_DEVICE_ID* deviceid);
+
+// Find a registered controller by its device pointer or its device id, NULL if not registered
+Devregentry* devreg_find(const Devregistry* reg, const IGameInputDevice* device);
+Devregentry* devreg_findid(const Devregistry* reg, const APP_LOCAL_DEVICE_ID* deviceid);
+
+// Clear the state of a new entry, after desc has been filled: limits the counts in desc to the registry's rows
+// and marks the entry as fresh, so its first devreg_diffstate reports all its fields; restarts its readiness detector
+void devreg_resetstate(Devregistry* reg, Devregentry* entry);
+
+// Bytes of the state arrays of all controllers including their snapshot (part of sizeof(Devregistry))
+size_t devreg_statebytes();
+
+// Pack a bool array of 'count' buttons into a bitset of (count+63)/64 words
+void devreg_packbuttons(const bool* buttons, uint32_t count, uint64_t* bits);
+
+// Narrow 'count' switch positions to bytes
+void devreg_packswitches(const GameInputSwitchPosition* switches, uint32_t count, uint8_t* bytes);
+
+// Compare the state of all controllers with the snapshot, returns the number of changed controllers
+uint32_t devreg_diffstate(const Devregistry* reg, Devregchanges* changes);
+
+// Changed fields of the controller at pool index 'poolidx' (DEVREG_CHGAXES | ...), 0 if unchanged
+uint8_t devreg_changedfields(const Devregchanges* changes, uint16_t poolidx);
+
+// Copy the changed rows into the snapshot and clear the fresh marks
+void devreg_commitstate(Devregistry* reg, const Devregchanges* changes);
+
+// SIMD level devreg_diffstate runs with: "AVX2", "SSE2" or "scalar"
+const char* devreg_simdname();
+
+// Remove a controller, releases its last reading and the device reference and zeroes its state rows and snapshot
+// Returns false if the device wasn't registered
+bool devreg_remove(Devregistry* reg, IGameInputDevice* device);
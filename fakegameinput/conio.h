@@ -0,0 +1,21 @@
+/*
+	conio.h
+
+	Stand-in for the MSVC runtime header of the same name, only used by the fake GameInput build
+	(CMake option SAITEKTW_FAKEGAMEINPUT, see fakegameinput.h), published under MIT license like the main program.
+
+	There is no console keyboard: _kbhit() and _getch() return the keys of the script's "key" lines
+	as soon as the virtual clock has reached them (fakegameinput.cpp).
+*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int _kbhit(void);
+int _getch(void);
+
+#ifdef __cplusplus
+}   // extern "C"
+#endif
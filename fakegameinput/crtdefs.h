@@ -0,0 +1,11 @@
+/*
+	crtdefs.h
+
+	Stand-in for the MSVC runtime header of the same name, only used by the fake GameInput build
+	(CMake option SAITEKTW_FAKEGAMEINPUT, see fakegameinput.h), published under MIT license like the main program.
+
+	getopt.h only needs size_t and friends from it.
+*/
+#pragma once
+
+#include <stddef.h>
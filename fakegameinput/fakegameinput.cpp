@@ -0,0 +1,1794 @@
+/*
+	fakegameinput.cpp
+
+	In-process fake of the Microsoft GameInput API V.0, see fakegameinput.h
+
+	The backend is a singleton (GameInputCreate returns always the same object). Scripted events are processed
+	in time order whenever the virtual clock advances (fakegi_advance): a connect creates a device object with its
+	first reading, an input event appends a new reading to the device's history, a disconnect drops the device.
+	Device and reading callbacks aren't called right away but queued as work items, which Dispatch() executes.
+	All objects are reference counted like COM objects: the backend holds a reference on each connected device,
+	a device on the readings of its history and each reading on its device.
+	A replayed trace (fakegi_loadtrace) is converted into the same events, a traced reading into one FAKEGI_READING
+	event that sets all inputs of the device at once.
+*/
+
+#include "GameInput.h"
+#include "fakegameinput.h"
+#include "twtrace.h"
+
+#include <windows.h>
+#include <conio.h>
+#include <timeapi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Fakedevice;
+class Fakereading;
+
+// #############################################################################################################
+// Script and virtual clock
+// #############################################################################################################
+
+enum Fakeeventkind
+{
+	FAKEGI_CONNECT,
+	FAKEGI_DISCONNECT,
+	FAKEGI_REPLUG,						// new device object, the old one's disconnect isn't reported
+	FAKEGI_AXIS,
+	FAKEGI_BUTTON,
+	FAKEGI_SWITCH,
+	FAKEGI_KEY,
+	FAKEGI_NOISE,						// axis 0, or button 0 of a device without axes
+	FAKEGI_READING						// replay: all inputs of a traced reading
+};
+
+struct Fakeevent
+{
+	uint64_t time;					// virtual time in usecs
+	Fakeeventkind kind;
+	int dev;						// script's device number
+	uint32_t index;					// axis/button/switch index, key code, replayed reading: index in fakerecords
+	float value;					// axis value, button 0/1, switch position
+	uint16_t vid;					// connect: device identity and input counts
+	uint16_t pid;
+	uint32_t axes;
+	uint32_t buttons;
+	uint32_t switches;
+	bool replay;					// connect: replayed, without a first reading
+};
+
+static std::vector<Fakeevent> fakescript;
+static size_t fakenext = 0;					// next script event to process
+static uint64_t fakeclock = 0;				// virtual time in usecs since program start
+static size_t fakehistory = FAKEGI_HISTORY;
+static std::deque<int> fakekeys;			// keys due for _kbhit/_getch
+static std::vector<Twtracerecord> fakerecords;	// replay: the traced readings
+// Replay at real speed: the real time of virtual time 0
+static bool fakerealtime = false;
+static std::chrono::steady_clock::time_point fakerealstart;
+
+static void fakegi_advance(uint64_t until);
+
+// #############################################################################################################
+// Callbacks and work items
+// #############################################################################################################
+
+enum Fakecallbackkind
+{
+	FAKEGI_CB_DEVICE,
+	FAKEGI_CB_READING
+};
+
+struct Fakecallback
+{
+	GameInputCallbackToken token;
+	Fakecallbackkind kind;
+	bool active;
+	IGameInputDevice* device;				// filter, NULL = all devices
+	GameInputKind inputkind;
+	GameInputDeviceStatus statusfilter;		// device callbacks
+	float threshold;						// reading callbacks: min. axis change
+	void* context;
+	GameInputDeviceCallback devicefunc;
+	GameInputReadingCallback readingfunc;
+};
+
+// A queued callback, holds a reference on its device or reading until it is executed
+struct Fakework
+{
+	GameInputCallbackToken token;
+	Fakedevice* device;
+	Fakereading* reading;
+	uint64_t timestamp;
+	GameInputDeviceStatus current;
+	GameInputDeviceStatus previous;
+};
+
+static std::vector<Fakecallback> fakecallbacks;
+static GameInputCallbackToken fakenexttoken = 1;
+static std::deque<Fakework> fakework;
+
+// The dispatcher's wait handle, signaled while work items are queued
+static int fakewaitmarker;
+static HANDLE const fakewaithandle = (HANDLE)&fakewaitmarker;
+
+// Dispatcher thread: its own wait handle, the work queue and the events are shared with it under fakelock.
+// 'fakethreads' counts the wait handles opened by other threads than the main thread, 'fakebusy' the work items
+// that are being executed by them
+static int fakethreadmarker;
+static HANDLE const fakethreadhandle = (HANDLE)&fakethreadmarker;
+static std::thread::id fakemainthread;
+static std::mutex fakelock;
+static std::condition_variable fakechanged;
+static int fakethreads = 0;
+static int fakebusy = 0;
+
+// #############################################################################################################
+// IGameInputReading
+// #############################################################################################################
+
+class Fakereading : public IGameInputReading
+{
+public:
+	Fakereading(Fakedevice* device, uint64_t sequence, uint64_t timestamp, const std::vector<float>& axes,
+		const std::vector<bool>& buttons, const std::vector<GameInputSwitchPosition>& switches);
+
+	uint64_t sequence;
+	uint64_t timestamp;
+	Fakedevice* device;
+	std::vector<float> axes;
+	std::vector<bool> buttons;
+	std::vector<GameInputSwitchPosition> switches;
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** ppvObj) override
+	{
+// Interface ids don't exist without the Windows SDK, nobody queries a reading anyway
+		*ppvObj = NULL;
+		return E_NOINTERFACE;
+	}
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return ++refs;
+	}
+	ULONG STDMETHODCALLTYPE Release() override;
+	GameInputKind STDMETHODCALLTYPE GetInputKind() override
+	{
+		return GameInputKindController;
+	}
+	uint64_t STDMETHODCALLTYPE GetSequenceNumber(GameInputKind inputKind) override
+	{
+		return (inputKind & GameInputKindController) ? sequence : 0;
+	}
+	uint64_t STDMETHODCALLTYPE GetTimestamp() override
+	{
+		return timestamp;
+	}
+	void STDMETHODCALLTYPE GetDevice(IGameInputDevice** device) override;
+	bool STDMETHODCALLTYPE GetRawReport(IGameInputRawDeviceReport** report) override
+	{
+		*report = NULL;
+		return false;
+	}
+	uint32_t STDMETHODCALLTYPE GetControllerAxisCount() override
+	{
+		return (uint32_t)axes.size();
+	}
+	uint32_t STDMETHODCALLTYPE GetControllerAxisState(uint32_t stateArrayCount, float* stateArray) override
+	{
+		uint32_t count = std::min(stateArrayCount, (uint32_t)axes.size());
+		std::copy(axes.begin(), axes.begin() + count, stateArray);
+		return count;
+	}
+	uint32_t STDMETHODCALLTYPE GetControllerButtonCount() override
+	{
+		return (uint32_t)buttons.size();
+	}
+	uint32_t STDMETHODCALLTYPE GetControllerButtonState(uint32_t stateArrayCount, bool* stateArray) override
+	{
+		uint32_t count = std::min(stateArrayCount, (uint32_t)buttons.size());
+		std::copy(buttons.begin(), buttons.begin() + count, stateArray);
+		return count;
+	}
+	uint32_t STDMETHODCALLTYPE GetControllerSwitchCount() override
+	{
+		return (uint32_t)switches.size();
+	}
+	uint32_t STDMETHODCALLTYPE GetControllerSwitchState(uint32_t stateArrayCount, GameInputSwitchPosition* stateArray) override
+	{
+		uint32_t count = std::min(stateArrayCount, (uint32_t)switches.size());
+		std::copy(switches.begin(), switches.begin() + count, stateArray);
+		return count;
+	}
+// Only controllers are scripted: no keyboard, mouse, touch, motion or gamepad states
+	uint32_t STDMETHODCALLTYPE GetKeyCount() override
+	{
+		return 0;
+	}
+	uint32_t STDMETHODCALLTYPE GetKeyState(uint32_t, GameInputKeyState*) override
+	{
+		return 0;
+	}
+	bool STDMETHODCALLTYPE GetMouseState(GameInputMouseState*) override
+	{
+		return false;
+	}
+	uint32_t STDMETHODCALLTYPE GetTouchCount() override
+	{
+		return 0;
+	}
+	uint32_t STDMETHODCALLTYPE GetTouchState(uint32_t, GameInputTouchState*) override
+	{
+		return 0;
+	}
+	bool STDMETHODCALLTYPE GetMotionState(GameInputMotionState*) override
+	{
+		return false;
+	}
+	bool STDMETHODCALLTYPE GetArcadeStickState(GameInputArcadeStickState*) override
+	{
+		return false;
+	}
+	bool STDMETHODCALLTYPE GetFlightStickState(GameInputFlightStickState*) override
+	{
+		return false;
+	}
+	bool STDMETHODCALLTYPE GetGamepadState(GameInputGamepadState*) override
+	{
+		return false;
+	}
+	bool STDMETHODCALLTYPE GetRacingWheelState(GameInputRacingWheelState*) override
+	{
+		return false;
+	}
+	bool STDMETHODCALLTYPE GetUiNavigationState(GameInputUiNavigationState*) override
+	{
+		return false;
+	}
+
+private:
+	virtual ~Fakereading();
+	std::atomic<ULONG> refs;			// interlocked like COM (GetDevice and Release on the dispatcher thread too)
+};
+
+// #############################################################################################################
+// IGameInputDevice
+// #############################################################################################################
+
+class Fakedevice : public IGameInputDevice
+{
+public:
+	Fakedevice(int scriptdev, uint16_t vid, uint16_t pid, uint32_t nbraxes, uint32_t nbrbutt, uint32_t nbrswch)
+		: scriptdev(scriptdev), connected(true), nextsequence(1),
+		  axes(nbraxes, 0.0f), buttons(nbrbutt, false), switches(nbrswch, GameInputSwitchCenter), refs(1)
+	{
+		memset(&info, 0, sizeof(info));
+		info.infoSize = sizeof(info);
+		info.vendorId = vid;
+		info.productId = pid;
+		info.revisionNumber = 0x0100;
+		info.usage.page = 0x01;					// HID generic desktop
+		info.usage.id = 0x04;					// joystick
+// The device id stays the same over reconnects of the same script device, like the real one for the same USB port
+		memcpy(info.deviceId.value, "FAKEGAMEINPUT", 13);
+		info.deviceId.value[30] = (BYTE)(scriptdev >> 8);
+		info.deviceId.value[31] = (BYTE)scriptdev;
+		info.deviceRootId = info.deviceId;
+		info.deviceFamily = GameInputFamilyHid;
+		info.supportedInput = GameInputKindController;
+		info.controllerAxisCount = nbraxes;
+		info.controllerButtonCount = nbrbutt;
+		info.controllerSwitchCount = nbrswch;
+	}
+
+	int scriptdev;
+	bool connected;
+	uint64_t nextsequence;
+	std::deque<Fakereading*> history;		// oldest first, the last one is the current reading
+	std::vector<float> axes;				// state of the next reading
+	std::vector<bool> buttons;
+	std::vector<GameInputSwitchPosition> switches;
+
+// Append a reading with the current state to the history, drops the oldest one if the history is full
+	Fakereading* addreading()
+	{
+		Fakereading* reading = new Fakereading(this, nextsequence++, fakeclock, axes, buttons, switches);
+		history.push_back(reading);
+		while (history.size() > fakehistory) {
+			history.front()->Release();
+			history.pop_front();
+		}
+		return reading;
+	}
+
+// Unplugged: the readings are gone with the device
+	void disconnect()
+	{
+		connected = false;
+		while (!history.empty()) {
+			history.front()->Release();
+			history.pop_front();
+		}
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** ppvObj) override
+	{
+		*ppvObj = NULL;
+		return E_NOINTERFACE;
+	}
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return ++refs;
+	}
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		ULONG left = --refs;
+		if (left == 0) {
+			delete this;
+		}
+		return left;
+	}
+	GameInputDeviceInfo const* STDMETHODCALLTYPE GetDeviceInfo() override
+	{
+		return &info;
+	}
+	GameInputDeviceStatus STDMETHODCALLTYPE GetDeviceStatus() override
+	{
+		return connected ? GameInputDeviceConnected : GameInputDeviceNoStatus;
+	}
+	void STDMETHODCALLTYPE GetBatteryState(GameInputBatteryState* state) override
+	{
+		memset(state, 0, sizeof(*state));
+	}
+// No force feedback, rumble, haptics or raw reports (most of it isn't implemented by GameInput V.0 either)
+	HRESULT STDMETHODCALLTYPE CreateForceFeedbackEffect(uint32_t, GameInputForceFeedbackParams const*,
+		IGameInputForceFeedbackEffect** effect) override
+	{
+		*effect = NULL;
+		return E_NOTIMPL;
+	}
+	bool STDMETHODCALLTYPE IsForceFeedbackMotorPoweredOn(uint32_t) override
+	{
+		return false;
+	}
+	void STDMETHODCALLTYPE SetForceFeedbackMotorGain(uint32_t, float) override
+	{
+	}
+	HRESULT STDMETHODCALLTYPE SetHapticMotorState(uint32_t, GameInputHapticFeedbackParams const*) override
+	{
+		return E_NOTIMPL;
+	}
+	void STDMETHODCALLTYPE SetRumbleState(GameInputRumbleParams const*) override
+	{
+	}
+	void STDMETHODCALLTYPE SetInputSynchronizationState(bool) override
+	{
+	}
+	void STDMETHODCALLTYPE SendInputSynchronizationHint() override
+	{
+	}
+	void STDMETHODCALLTYPE PowerOff() override
+	{
+	}
+	HRESULT STDMETHODCALLTYPE CreateRawDeviceReport(uint32_t, GameInputRawDeviceReportKind,
+		IGameInputRawDeviceReport** report) override
+	{
+		*report = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE GetRawDeviceFeature(uint32_t, IGameInputRawDeviceReport** report) override
+	{
+		*report = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE SetRawDeviceFeature(IGameInputRawDeviceReport*) override
+	{
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE SendRawDeviceOutput(IGameInputRawDeviceReport*) override
+	{
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE SendRawDeviceOutputWithResponse(IGameInputRawDeviceReport*,
+		IGameInputRawDeviceReport** responseReport) override
+	{
+		*responseReport = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE ExecuteRawDeviceIoControl(uint32_t, size_t, void const*, size_t, void*, size_t* outputSize) override
+	{
+		if (outputSize != NULL) {
+			*outputSize = 0;
+		}
+		return E_NOTIMPL;
+	}
+	bool STDMETHODCALLTYPE AcquireExclusiveRawDeviceAccess(uint64_t) override
+	{
+		return false;
+	}
+	void STDMETHODCALLTYPE ReleaseExclusiveRawDeviceAccess() override
+	{
+	}
+
+private:
+	virtual ~Fakedevice()
+	{
+	}
+	std::atomic<ULONG> refs;			// interlocked like COM, main loop and dispatcher thread release readings
+	GameInputDeviceInfo info;
+};
+
+Fakereading::Fakereading(Fakedevice* device, uint64_t sequence, uint64_t timestamp, const std::vector<float>& axes,
+		const std::vector<bool>& buttons, const std::vector<GameInputSwitchPosition>& switches)
+	: sequence(sequence), timestamp(timestamp), device(device), axes(axes), buttons(buttons), switches(switches), refs(1)
+{
+	device->AddRef();
+}
+
+Fakereading::~Fakereading()
+{
+	device->Release();
+}
+
+ULONG STDMETHODCALLTYPE Fakereading::Release()
+{
+	ULONG left = --refs;
+	if (left == 0) {
+		delete this;
+	}
+	return left;
+}
+
+void STDMETHODCALLTYPE Fakereading::GetDevice(IGameInputDevice** device)
+{
+	this->device->AddRef();
+	*device = this->device;
+}
+
+// The connected devices by script device number, the backend holds a reference on each
+static Fakedevice* fakedevices[FAKEGI_MAXDEVICES];
+static uint32_t fakeconnected = 0;
+
+// #############################################################################################################
+// Queue the callbacks of a device status change or a new reading
+// #############################################################################################################
+
+static void fakegi_queuedevice(Fakedevice* device, GameInputDeviceStatus current, GameInputDeviceStatus previous)
+{
+	for (const Fakecallback& callback : fakecallbacks) {
+		if (!callback.active || (callback.kind != FAKEGI_CB_DEVICE)
+			|| ((callback.device != NULL) && (callback.device != device))
+			|| !(callback.inputkind & GameInputKindController) || !((current ^ previous) & callback.statusfilter)) {
+			continue;
+		}
+		device->AddRef();
+		std::lock_guard<std::mutex> lock(fakelock);
+		fakework.push_back({ callback.token, device, NULL, fakeclock, current, previous });
+	}
+	fakechanged.notify_all();
+}
+
+// 'changed' is the kind of input that has changed, 'delta' the axis change
+static void fakegi_queuereading(Fakedevice* device, Fakereading* reading, GameInputKind changed, float delta)
+{
+	for (const Fakecallback& callback : fakecallbacks) {
+		if (!callback.active || (callback.kind != FAKEGI_CB_READING)
+			|| ((callback.device != NULL) && (callback.device != device)) || !(callback.inputkind & changed)) {
+			continue;
+		}
+		if ((changed == GameInputKindControllerAxis) && ((delta == 0) || (fabsf(delta) < callback.threshold))) {
+			continue;
+		}
+		reading->AddRef();
+		std::lock_guard<std::mutex> lock(fakelock);
+		fakework.push_back({ callback.token, NULL, reading, reading->timestamp, GameInputDeviceNoStatus, GameInputDeviceNoStatus });
+	}
+	fakechanged.notify_all();
+}
+
+// Work items queued and not yet taken by Dispatch()
+static bool fakegi_workqueued()
+{
+	std::lock_guard<std::mutex> lock(fakelock);
+	return !fakework.empty();
+}
+
+// Execute the oldest work item, returns false if there is none
+static bool fakegi_runwork()
+{
+	Fakework work;
+	{
+		std::lock_guard<std::mutex> lock(fakelock);
+		if (fakework.empty()) {
+			return false;
+		}
+		work = fakework.front();
+		fakework.pop_front();
+		++fakebusy;
+	}
+	for (const Fakecallback& callback : fakecallbacks) {
+		if ((callback.token != work.token) || !callback.active) {
+			continue;
+		}
+		if (callback.kind == FAKEGI_CB_DEVICE) {
+			callback.devicefunc(callback.token, callback.context, work.device, work.timestamp, work.current, work.previous);
+		} else {
+			callback.readingfunc(callback.token, callback.context, work.reading, false);
+		}
+		break;
+	}
+	if (work.device != NULL) {
+		work.device->Release();
+	}
+	if (work.reading != NULL) {
+		work.reading->Release();
+	}
+	{
+		std::lock_guard<std::mutex> lock(fakelock);
+		--fakebusy;
+	}
+	fakechanged.notify_all();
+	return true;
+}
+
+struct Fakehandle;
+static bool fakegi_eventset(Fakehandle* event);
+
+// With a dispatcher thread: wait until it has executed all queued work items (see fakegameinput.h), returns false
+// if event 'watched' (NULL: any event) is signaled before: the thread waits for the main thread then (e.g. its
+// handover queue is full), so the main thread must not wait for it
+static bool fakegi_quiesce(Fakehandle* watched)
+{
+	bool idle = false;
+	std::unique_lock<std::mutex> lock(fakelock);
+	fakechanged.wait(lock, [&] {
+		idle = (fakethreads == 0) || (fakework.empty() && (fakebusy == 0));
+		return idle || fakegi_eventset(watched);
+	});
+	return idle;
+}
+
+// #############################################################################################################
+// Process the script events up to virtual time 'until' and set the clock to it
+// #############################################################################################################
+
+static void fakegi_process(const Fakeevent& event)
+{
+	if (event.kind == FAKEGI_KEY) {
+		fakekeys.push_back((int)event.index);
+		return;
+	}
+	Fakedevice* device = fakedevices[event.dev];
+	if (event.kind == FAKEGI_CONNECT) {
+		if (device != NULL) {
+			return;							// already plugged in
+		}
+		device = new Fakedevice(event.dev, event.vid, event.pid, event.axes, event.buttons, event.switches);
+		fakedevices[event.dev] = device;
+		++fakeconnected;
+		if (!event.replay) {
+			device->addreading();
+		}
+		fakegi_queuedevice(device, GameInputDeviceConnected, GameInputDeviceNoStatus);
+		return;
+	}
+	if (device == NULL) {
+		return;								// input of a device that isn't plugged in
+	}
+	if (event.kind == FAKEGI_DISCONNECT) {
+		fakedevices[event.dev] = NULL;
+		--fakeconnected;
+		device->disconnect();
+		fakegi_queuedevice(device, GameInputDeviceNoStatus, GameInputDeviceConnected);
+		device->Release();
+		return;
+	}
+	if (event.kind == FAKEGI_REPLUG) {
+		const GameInputDeviceInfo* info = device->GetDeviceInfo();
+		Fakedevice* newdevice = new Fakedevice(event.dev, info->vendorId, info->productId, info->controllerAxisCount,
+			info->controllerButtonCount, info->controllerSwitchCount);
+		fakedevices[event.dev] = newdevice;
+		device->disconnect();
+		device->Release();
+		newdevice->addreading();
+		fakegi_queuedevice(newdevice, GameInputDeviceConnected, GameInputDeviceNoStatus);
+		return;
+	}
+	GameInputKind changed = GameInputKindUnknown;
+	float delta = 0;
+	if (event.kind == FAKEGI_READING) {
+// The whole traced state at once, the largest axis change decides on the reading callbacks' threshold
+		const Twtracerecord& record = fakerecords[event.index];
+		uint32_t nbraxes = std::min(std::min(record.nbraxes, (uint32_t)TWTRACE_AXES), (uint32_t)device->axes.size());
+		for (uint32_t axis = 0; axis < nbraxes; ++axis) {
+			float axisdelta = record.axes[axis] - device->axes[axis];
+			if (fabsf(axisdelta) > fabsf(delta)) {
+				delta = axisdelta;
+			}
+			device->axes[axis] = record.axes[axis];
+		}
+		uint32_t nbrbutt = std::min(std::min(record.nbrbutt, (uint32_t)(TWTRACE_BUTTONWORDS * 64)), (uint32_t)device->buttons.size());
+		for (uint32_t button = 0; button < nbrbutt; ++button) {
+			device->buttons[button] = ((record.buttons[button / 64] >> (button % 64)) & 1) != 0;
+		}
+		if (record.sequence > device->nextsequence) {
+			device->nextsequence = record.sequence;
+		}
+		changed = (delta != 0) ? GameInputKindControllerAxis : GameInputKindControllerButton;
+	} else if (((event.kind == FAKEGI_AXIS) && (event.index < device->axes.size()))
+		|| ((event.kind == FAKEGI_NOISE) && !device->axes.empty())) {
+		delta = event.value - device->axes[event.index];
+		device->axes[event.index] = event.value;
+		changed = GameInputKindControllerAxis;
+	} else if ((event.kind == FAKEGI_NOISE) && !device->buttons.empty()) {
+		device->buttons[0] = !device->buttons[0];
+		changed = GameInputKindControllerButton;
+	} else if ((event.kind == FAKEGI_BUTTON) && (event.index < device->buttons.size())) {
+		device->buttons[event.index] = (event.value != 0);
+		changed = GameInputKindControllerButton;
+	} else if ((event.kind == FAKEGI_SWITCH) && (event.index < device->switches.size())) {
+		device->switches[event.index] = (GameInputSwitchPosition)(int)event.value;
+		changed = GameInputKindControllerSwitch;
+	} else {
+		return;								// no such axis/button/switch
+	}
+	Fakereading* reading = device->addreading();
+	fakegi_queuereading(device, reading, changed, delta);
+}
+
+// Real speed: wait until the real time has reached virtual time 'time'
+static void fakegi_pace(uint64_t time)
+{
+	if (fakerealtime) {
+		std::this_thread::sleep_until(fakerealstart + std::chrono::microseconds(time));
+	}
+}
+
+// Real speed: the real time in usecs of the virtual clock, else 0
+static uint64_t fakegi_realnow()
+{
+	if (!fakerealtime) {
+		return 0;
+	}
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - fakerealstart).count();
+}
+
+static void fakegi_advance(uint64_t until)
+{
+// At real speed, a program that has been held up catches up with the real time (the events in between are due)
+	uint64_t realnow = fakegi_realnow();
+	if (realnow > until) {
+		until = realnow;
+	}
+	while ((fakenext < fakescript.size()) && (fakescript[fakenext].time <= until)) {
+		const Fakeevent& event = fakescript[fakenext++];
+		if (event.time > fakeclock) {
+			fakegi_pace(event.time);
+			fakeclock = event.time;
+		}
+		fakegi_process(event);
+		fakegi_quiesce(NULL);
+	}
+	if (until > fakeclock) {
+		fakegi_pace(until);
+		fakeclock = until;
+	}
+}
+
+// #############################################################################################################
+// IGameInputDispatcher
+// #############################################################################################################
+
+class Fakedispatcher : public IGameInputDispatcher
+{
+public:
+	Fakedispatcher() : refs(1)
+	{
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** ppvObj) override
+	{
+		*ppvObj = NULL;
+		return E_NOINTERFACE;
+	}
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return ++refs;
+	}
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		ULONG left = --refs;
+		if (left == 0) {
+			delete this;
+		}
+		return left;
+	}
+// Executes at least one work item, then more until the quota (real time) is used up.
+// Only the main thread moves the virtual clock, a dispatcher thread just executes what is queued
+	bool STDMETHODCALLTYPE Dispatch(uint64_t quotaInMicroseconds) override
+	{
+		if (std::this_thread::get_id() == fakemainthread) {
+			fakegi_advance(fakeclock);
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while (fakegi_runwork()) {
+			if (std::chrono::steady_clock::now() - start >= std::chrono::microseconds(quotaInMicroseconds)) {
+				break;
+			}
+		}
+		return fakegi_workqueued();
+	}
+// Another thread than the main thread gets the handle of a dispatcher thread (closed by CloseHandle)
+	HRESULT STDMETHODCALLTYPE OpenWaitHandle(HANDLE* waitHandle) override
+	{
+		if (std::this_thread::get_id() == fakemainthread) {
+			*waitHandle = fakewaithandle;
+			return S_OK;
+		}
+		std::lock_guard<std::mutex> lock(fakelock);
+		++fakethreads;
+		*waitHandle = fakethreadhandle;
+		return S_OK;
+	}
+
+private:
+	virtual ~Fakedispatcher()
+	{
+	}
+	std::atomic<ULONG> refs;
+};
+
+// #############################################################################################################
+// IGameInput
+// #############################################################################################################
+
+class Fakegameinput : public IGameInput
+{
+public:
+	Fakegameinput() : refs(0)
+	{
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** ppvObj) override
+	{
+		*ppvObj = NULL;
+		return E_NOINTERFACE;
+	}
+// The singleton lives until the program ends
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return ++refs;
+	}
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		return (refs > 0) ? --refs : 0;
+	}
+	uint64_t STDMETHODCALLTYPE GetCurrentTimestamp() override
+	{
+		uint64_t realnow = fakegi_realnow();
+		return (realnow > fakeclock) ? realnow : fakeclock;
+	}
+// Current reading of a device, without device the newest reading of all devices
+	HRESULT STDMETHODCALLTYPE GetCurrentReading(GameInputKind inputKind, IGameInputDevice* device, IGameInputReading** reading) override
+	{
+		*reading = NULL;
+		Fakereading* current = NULL;
+		if (device != NULL) {
+			Fakedevice* fakedev = static_cast<Fakedevice*>(device);
+			if (!fakedev->connected) {
+				return GAMEINPUT_E_DEVICE_DISCONNECTED;
+			}
+			if (!fakedev->history.empty()) {
+				current = fakedev->history.back();
+			}
+		} else {
+			for (Fakedevice* fakedev : fakedevices) {
+				if ((fakedev != NULL) && !fakedev->history.empty()
+					&& ((current == NULL) || (fakedev->history.back()->timestamp >= current->timestamp))) {
+					current = fakedev->history.back();
+				}
+			}
+		}
+		if ((current == NULL) || !(inputKind & GameInputKindController)) {
+			return GAMEINPUT_E_READING_NOT_FOUND;
+		}
+		current->AddRef();
+		*reading = current;
+		return S_OK;
+	}
+// The reading after the reference reading in the history of its device
+	HRESULT STDMETHODCALLTYPE GetNextReading(IGameInputReading* referenceReading, GameInputKind inputKind,
+		IGameInputDevice* device, IGameInputReading** reading) override
+	{
+		return stepreading(referenceReading, inputKind, device, reading, true);
+	}
+	HRESULT STDMETHODCALLTYPE GetPreviousReading(IGameInputReading* referenceReading, GameInputKind inputKind,
+		IGameInputDevice* device, IGameInputReading** reading) override
+	{
+		return stepreading(referenceReading, inputKind, device, reading, false);
+	}
+	HRESULT STDMETHODCALLTYPE GetTemporalReading(uint64_t, IGameInputDevice*, IGameInputReading** reading) override
+	{
+		*reading = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE RegisterReadingCallback(IGameInputDevice* device, GameInputKind inputKind, float analogThreshold,
+		void* context, GameInputReadingCallback callbackFunc, GameInputCallbackToken* callbackToken) override
+	{
+		Fakecallback callback = { fakenexttoken++, FAKEGI_CB_READING, true, device, inputKind, GameInputDeviceNoStatus,
+			analogThreshold, context, NULL, callbackFunc };
+		fakecallbacks.push_back(callback);
+		if (callbackToken != NULL) {
+			*callbackToken = callback.token;
+		}
+		return S_OK;
+	}
+// Enumeration: the connected devices are reported at once (blocking) or by the dispatcher (async)
+	HRESULT STDMETHODCALLTYPE RegisterDeviceCallback(IGameInputDevice* device, GameInputKind inputKind,
+		GameInputDeviceStatus statusFilter, GameInputEnumerationKind enumerationKind, void* context,
+		GameInputDeviceCallback callbackFunc, GameInputCallbackToken* callbackToken) override
+	{
+		Fakecallback callback = { fakenexttoken++, FAKEGI_CB_DEVICE, true, device, inputKind, statusFilter,
+			0.0f, context, callbackFunc, NULL };
+		fakecallbacks.push_back(callback);
+		if (callbackToken != NULL) {
+			*callbackToken = callback.token;
+		}
+		if (enumerationKind == GameInputNoEnumeration) {
+			return S_OK;
+		}
+		for (Fakedevice* fakedev : fakedevices) {
+			if ((fakedev == NULL) || ((device != NULL) && (device != fakedev))
+				|| !(inputKind & GameInputKindController) || !(statusFilter & GameInputDeviceConnected)) {
+				continue;
+			}
+			if (enumerationKind == GameInputBlockingEnumeration) {
+				callbackFunc(callback.token, context, fakedev, fakeclock, GameInputDeviceConnected, GameInputDeviceNoStatus);
+			} else {
+				fakedev->AddRef();
+				std::lock_guard<std::mutex> lock(fakelock);
+				fakework.push_back({ callback.token, fakedev, NULL, fakeclock, GameInputDeviceConnected, GameInputDeviceNoStatus });
+			}
+		}
+		return S_OK;
+	}
+// No guide button and no keyboard
+	HRESULT STDMETHODCALLTYPE RegisterGuideButtonCallback(IGameInputDevice*, void*,
+		GameInputGuideButtonCallback, GameInputCallbackToken* callbackToken) override
+	{
+		if (callbackToken != NULL) {
+			*callbackToken = GAMEINPUT_INVALID_CALLBACK_TOKEN_VALUE;
+		}
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE RegisterKeyboardLayoutCallback(IGameInputDevice*, void*,
+		GameInputKeyboardLayoutCallback, GameInputCallbackToken* callbackToken) override
+	{
+		if (callbackToken != NULL) {
+			*callbackToken = GAMEINPUT_INVALID_CALLBACK_TOKEN_VALUE;
+		}
+		return E_NOTIMPL;
+	}
+	void STDMETHODCALLTYPE StopCallback(GameInputCallbackToken callbackToken) override
+	{
+		for (Fakecallback& callback : fakecallbacks) {
+			if (callback.token == callbackToken) {
+				callback.active = false;
+			}
+		}
+	}
+	bool STDMETHODCALLTYPE UnregisterCallback(GameInputCallbackToken callbackToken, uint64_t) override
+	{
+		for (size_t index = 0; index < fakecallbacks.size(); ++index) {
+			if (fakecallbacks[index].token == callbackToken) {
+				fakecallbacks.erase(fakecallbacks.begin() + index);
+				return true;
+			}
+		}
+		return false;
+	}
+	HRESULT STDMETHODCALLTYPE CreateDispatcher(IGameInputDispatcher** dispatcher) override
+	{
+		*dispatcher = new Fakedispatcher();
+		return S_OK;
+	}
+	HRESULT STDMETHODCALLTYPE CreateAggregateDevice(GameInputKind, IGameInputDevice** device) override
+	{
+		*device = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE FindDeviceFromId(APP_LOCAL_DEVICE_ID const* value, IGameInputDevice** device) override
+	{
+		*device = NULL;
+		for (Fakedevice* fakedev : fakedevices) {
+			if ((fakedev != NULL) && (memcmp(&fakedev->GetDeviceInfo()->deviceId, value, sizeof(*value)) == 0)) {
+				fakedev->AddRef();
+				*device = fakedev;
+				return S_OK;
+			}
+		}
+		return GAMEINPUT_E_DEVICE_NOT_FOUND;
+	}
+	HRESULT STDMETHODCALLTYPE FindDeviceFromObject(IUnknown*, IGameInputDevice** device) override
+	{
+		*device = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE FindDeviceFromPlatformHandle(HANDLE, IGameInputDevice** device) override
+	{
+		*device = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE FindDeviceFromPlatformString(LPCWSTR, IGameInputDevice** device) override
+	{
+		*device = NULL;
+		return E_NOTIMPL;
+	}
+	HRESULT STDMETHODCALLTYPE EnableOemDeviceSupport(uint16_t, uint16_t, uint8_t, uint8_t) override
+	{
+		return S_OK;
+	}
+	void STDMETHODCALLTYPE SetFocusPolicy(GameInputFocusPolicy) override
+	{
+	}
+
+private:
+// GetNextReading (forward) / GetPreviousReading: the reference has to be still in its device's history
+	HRESULT stepreading(IGameInputReading* referenceReading, GameInputKind inputKind, IGameInputDevice* device,
+		IGameInputReading** reading, bool forward)
+	{
+		*reading = NULL;
+		Fakereading* reference = static_cast<Fakereading*>(referenceReading);
+		if ((device != NULL) && (device != reference->device)) {
+			return E_INVALIDARG;
+		}
+		Fakedevice* fakedev = reference->device;
+		if (!fakedev->connected) {
+			return GAMEINPUT_E_DEVICE_DISCONNECTED;
+		}
+		if (fakedev->history.empty() || (reference->sequence < fakedev->history.front()->sequence)) {
+			return GAMEINPUT_E_REFERENCE_READING_TOO_OLD;
+		}
+		Fakereading* found = NULL;
+		if (forward) {
+			for (Fakereading* candidate : fakedev->history) {
+				if (candidate->sequence > reference->sequence) {
+					found = candidate;
+					break;
+				}
+			}
+		} else {
+			for (Fakereading* candidate : fakedev->history) {
+				if (candidate->sequence >= reference->sequence) {
+					break;
+				}
+				found = candidate;
+			}
+		}
+		if ((found == NULL) || !(inputKind & GameInputKindController)) {
+			return GAMEINPUT_E_READING_NOT_FOUND;
+		}
+		found->AddRef();
+		*reading = found;
+		return S_OK;
+	}
+
+	std::atomic<ULONG> refs;
+};
+
+static Fakegameinput fakegameinput;
+
+STDAPI GameInputCreate(IGameInput** gameInput)
+{
+	fakemainthread = std::this_thread::get_id();
+	fakegi_advance(fakeclock);
+	fakegameinput.AddRef();
+	*gameInput = &fakegameinput;
+	return S_OK;
+}
+
+// #############################################################################################################
+// Script loader
+// #############################################################################################################
+
+static bool fakegi_scripterror(const char* filename, int linenbr, const char* message)
+{
+	fprintf(stderr, "Script %s line %i: %s\n", filename, linenbr, message);
+	return false;
+}
+
+// Merge events into the script, events of the same time keep their order
+static void fakegi_addevents(const std::vector<Fakeevent>& events)
+{
+	fakescript.insert(fakescript.begin() + fakenext, events.begin(), events.end());
+	std::stable_sort(fakescript.begin() + fakenext, fakescript.end(),
+		[](const Fakeevent& first, const Fakeevent& second) { return first.time < second.time; });
+}
+
+bool fakegi_loadscript(const char* filename)
+{
+	FILE* script = fopen(filename, "r");
+	if (script == NULL) {
+		fprintf(stderr, "Script %s can't be opened\n", filename);
+		return false;
+	}
+	std::vector<Fakeevent> events;
+	char line[256];
+	int linenbr = 0;
+	bool ok = true;
+	while (ok && (fgets(line, sizeof(line), script) != NULL)) {
+		++linenbr;
+		char* text = line;
+		while (isspace((unsigned char)*text)) {
+			++text;
+		}
+		if ((*text == '\0') || (*text == '#')) {
+			continue;
+		}
+		unsigned long history;
+		if (sscanf(text, "history %lu", &history) == 1) {
+			if (history == 0) {
+				ok = fakegi_scripterror(filename, linenbr, "history must hold at least one reading");
+			}
+			fakehistory = history;
+			continue;
+		}
+		Fakeevent event;
+		memset(&event, 0, sizeof(event));
+		unsigned long long msecs;
+		char verb[16];
+		int consumed = 0;
+		if (sscanf(text, "%llu %15s %n", &msecs, verb, &consumed) < 2) {
+			ok = fakegi_scripterror(filename, linenbr, "expected <ms> <event> ...");
+			continue;
+		}
+		event.time = msecs * 1000;
+		const char* args = text + consumed;
+		if (strcmp(verb, "key") == 0) {
+			event.kind = FAKEGI_KEY;
+			event.index = (uint32_t)(unsigned char)*args;
+			if (isspace((unsigned char)*args) || (*args == '\0')) {
+				ok = fakegi_scripterror(filename, linenbr, "key without character");
+				continue;
+			}
+			events.push_back(event);
+			continue;
+		}
+		if (sscanf(args, "%i", &event.dev) != 1) {
+			ok = fakegi_scripterror(filename, linenbr, "device number missing");
+			continue;
+		}
+		if ((event.dev < 0) || (event.dev >= FAKEGI_MAXDEVICES)) {
+			ok = fakegi_scripterror(filename, linenbr, "device number out of range");
+			continue;
+		}
+		if ((strcmp(verb, "synth") == 0) || (strcmp(verb, "noise") == 0)) {
+// Device ranges: <dev> <count> ...
+			int count;
+			int fields;
+			unsigned int vid, pid;
+			unsigned long long duration, step;
+			event.kind = (verb[0] == 's') ? FAKEGI_CONNECT : FAKEGI_NOISE;
+			if (event.kind == FAKEGI_CONNECT) {
+				event.axes = 1;
+				fields = sscanf(args, "%*i %i %i %i %u %u %u", &count, &vid, &pid, &event.axes, &event.buttons, &event.switches);
+				if (fields < 3) {
+					ok = fakegi_scripterror(filename, linenbr, "synth <dev> <count> <vid> <pid> [<axes> [<buttons> [<switches>]]]");
+					continue;
+				}
+				event.vid = (uint16_t)vid;
+				event.pid = (uint16_t)pid;
+			} else if ((sscanf(args, "%*i %i %llu %llu", &count, &duration, &step) != 3) || (step == 0)) {
+				ok = fakegi_scripterror(filename, linenbr, "noise <dev> <count> <duration> <step>, step > 0");
+				continue;
+			}
+			if ((count < 1) || (event.dev + count > FAKEGI_MAXDEVICES)) {
+				ok = fakegi_scripterror(filename, linenbr, "device count out of range");
+				continue;
+			}
+			int firstdev = event.dev;
+			for (event.dev = firstdev; event.dev < firstdev + count; ++event.dev) {
+				if (event.kind == FAKEGI_CONNECT) {
+					events.push_back(event);
+					continue;
+				}
+// Each device and step gets another value, so every reading differs from the one before
+				for (unsigned long long offset = 0; offset <= duration; offset += step) {
+					event.time = (msecs + offset) * 1000;
+					event.value = (float)((offset / step + event.dev) % 200) / 100.0f - 1.0f;
+					events.push_back(event);
+				}
+			}
+		} else if (strcmp(verb, "connect") == 0) {
+			unsigned int vid, pid;
+			event.kind = FAKEGI_CONNECT;
+			event.axes = 1;
+			int fields = sscanf(args, "%*i %i %i %u %u %u", &vid, &pid, &event.axes, &event.buttons, &event.switches);
+			if (fields < 2) {
+				ok = fakegi_scripterror(filename, linenbr, "connect <dev> <vid> <pid> [<axes> [<buttons> [<switches>]]]");
+				continue;
+			}
+			event.vid = (uint16_t)vid;
+			event.pid = (uint16_t)pid;
+			events.push_back(event);
+		} else if (strcmp(verb, "disconnect") == 0) {
+			event.kind = FAKEGI_DISCONNECT;
+			events.push_back(event);
+		} else if (strcmp(verb, "replug") == 0) {
+			event.kind = FAKEGI_REPLUG;
+			events.push_back(event);
+		} else if ((strcmp(verb, "axis") == 0) || (strcmp(verb, "button") == 0) || (strcmp(verb, "switch") == 0)) {
+			event.kind = (verb[0] == 'a') ? FAKEGI_AXIS : (verb[0] == 'b') ? FAKEGI_BUTTON : FAKEGI_SWITCH;
+			if (sscanf(args, "%*i %u %f", &event.index, &event.value) != 2) {
+				ok = fakegi_scripterror(filename, linenbr, "axis|button|switch <dev> <index> <value>");
+				continue;
+			}
+			events.push_back(event);
+		} else if (strcmp(verb, "ramp") == 0) {
+			float from, to;
+			unsigned long long duration, step;
+			event.kind = FAKEGI_AXIS;
+			if ((sscanf(args, "%*i %u %f %f %llu %llu", &event.index, &from, &to, &duration, &step) != 5) || (step == 0)) {
+				ok = fakegi_scripterror(filename, linenbr, "ramp <dev> <index> <from> <to> <duration> <step>, step > 0");
+				continue;
+			}
+			for (unsigned long long offset = 0; offset <= duration; offset += step) {
+				event.time = (msecs + offset) * 1000;
+				event.value = (duration > 0) ? from + (to - from) * (float)offset / (float)duration : to;
+				events.push_back(event);
+			}
+		} else {
+			ok = fakegi_scripterror(filename, linenbr, "unknown event");
+		}
+	}
+	fclose(script);
+	if (!ok) {
+		return false;
+	}
+	fakegi_addevents(events);
+	return true;
+}
+
+// #############################################################################################################
+// Trace loader (replay of a session recorded by "-T")
+// #############################################################################################################
+
+// Records of the trace file last read: the children of fakegi_forksessions() get them with the parent's memory
+static std::string tracename;
+static std::vector<Twtracerecord> tracerecords;
+// RC of each session's child (index session - 1) of fakegi_forksessions(), -1 if it didn't end normally
+static std::vector<int> sessionrcs;
+
+// Read the records of trace file 'filename', unless they are read already, returns false (with a message on stderr)
+// if the file can't be read or isn't a trace file
+static bool fakegi_readtrace(const char* filename)
+{
+	if (tracename == filename) {
+		return true;
+	}
+	FILE* tracefile = fopen(filename, "rb");
+	if (tracefile == NULL) {
+		fprintf(stderr, "Trace %s can't be opened\n", filename);
+		return false;
+	}
+	Twtraceheader header;
+	if ((fread(&header, sizeof(header), 1, tracefile) != 1)
+		|| (memcmp(header.magic, TWTRACE_MAGIC, sizeof(header.magic)) != 0)
+		|| (header.version != TWTRACE_VERSION) || (header.recordsize != sizeof(Twtracerecord))) {
+		fprintf(stderr, "Trace %s is no trace file of this version\n", filename);
+		fclose(tracefile);
+		return false;
+	}
+	tracerecords.resize((size_t)header.recordcount);
+	size_t got = tracerecords.empty() ? 0 : fread(tracerecords.data(), sizeof(Twtracerecord), tracerecords.size(), tracefile);
+	fclose(tracefile);
+	tracerecords.resize(got);
+	tracename = filename;
+	return true;
+}
+
+// Number of sessions (start events) of the trace read
+static int fakegi_tracesessions()
+{
+	int sessions = 0;
+	for (const Twtracerecord& record : tracerecords) {
+		if ((record.kind == TWTRACE_EVENT) && (record.event == TWTRACE_EV_START)) {
+			++sessions;
+		}
+	}
+	return sessions;
+}
+
+bool fakegi_loadtrace(const char* filename, int session, int* recordedrc, uint64_t* recordedms, int* sessions)
+{
+	*recordedrc = -1;
+	*recordedms = 0;
+	*sessions = 0;
+	if (!fakegi_readtrace(filename)) {
+		return false;
+	}
+	const std::vector<Twtracerecord>& records = tracerecords;
+// A session runs from its start event to the next one
+	size_t first = records.size();
+	size_t last = records.size();
+	for (size_t ix = 0; ix < records.size(); ++ix) {
+		if ((records[ix].kind == TWTRACE_EVENT) && (records[ix].event == TWTRACE_EV_START)) {
+			++*sessions;
+			if (*sessions == session) {
+				first = ix;
+			} else if (*sessions == session + 1) {
+				last = ix;
+			}
+		}
+	}
+	if (first >= records.size()) {
+		fprintf(stderr, "Trace %s has no session %i (%i sessions)\n", filename, session, *sessions);
+		return false;
+	}
+	uint64_t startts = records[first].timestamp;
+// The controllers by registry index of the recording program (its readings refer to them by this index),
+// and those it didn't keep in its registry (not on the watch-list) by VID/PID
+	std::map<uint16_t, int> registered;
+	std::vector<Fakeevent> unregistered;
+	bool used[FAKEGI_MAXDEVICES] = {};
+	std::vector<Fakeevent> events;
+	for (size_t ix = first + 1; ix < last; ++ix) {
+		const Twtracerecord& record = records[ix];
+		Fakeevent event;
+		memset(&event, 0, sizeof(event));
+		event.time = (record.timestamp > startts) ? record.timestamp - startts : 0;
+		if ((record.kind == TWTRACE_EVENT) && (record.event == TWTRACE_EV_EXIT)) {
+			*recordedrc = (int)record.sequence;
+			*recordedms = event.time / 1000;
+		} else if ((record.kind == TWTRACE_CALLBACK) && (record.event == TWTRACE_EV_CONNECTED)) {
+			if ((record.device != TWTRACE_NODEVICE) && (registered.count(record.device) != 0)) {
+				continue;						// already connected
+			}
+			event.dev = (int)(std::find(used, used + FAKEGI_MAXDEVICES, false) - used);
+			if (event.dev >= FAKEGI_MAXDEVICES) {
+				fprintf(stderr, "Trace %s: more than %i controllers connected\n", filename, FAKEGI_MAXDEVICES);
+				return false;
+			}
+			used[event.dev] = true;
+			event.kind = FAKEGI_CONNECT;
+			event.replay = true;
+			event.vid = record.vid;
+			event.pid = record.pid;
+			event.axes = record.nbraxes;
+			event.buttons = record.nbrbutt;
+			event.switches = (uint32_t)record.sequence;
+			if (record.device != TWTRACE_NODEVICE) {
+				registered[record.device] = event.dev;
+			} else {
+				unregistered.push_back(event);
+			}
+			events.push_back(event);
+		} else if ((record.kind == TWTRACE_CALLBACK) && (record.event == TWTRACE_EV_DISCONNECTED)) {
+			event.dev = -1;
+			if (record.device != TWTRACE_NODEVICE) {
+				std::map<uint16_t, int>::iterator found = registered.find(record.device);
+				if (found != registered.end()) {
+					event.dev = found->second;
+					registered.erase(found);
+				}
+			} else {
+				for (size_t unreg = 0; unreg < unregistered.size(); ++unreg) {
+					if ((unregistered[unreg].vid == record.vid) && (unregistered[unreg].pid == record.pid)) {
+						event.dev = unregistered[unreg].dev;
+						unregistered.erase(unregistered.begin() + unreg);
+						break;
+					}
+				}
+			}
+			if (event.dev < 0) {
+				continue;						// not connected in this session
+			}
+			used[event.dev] = false;
+			event.kind = FAKEGI_DISCONNECT;
+			events.push_back(event);
+		} else if (record.kind == TWTRACE_READING) {
+			std::map<uint16_t, int>::iterator found = registered.find(record.device);
+			if (found == registered.end()) {
+				continue;						// no connect of this controller in the session
+			}
+			event.kind = FAKEGI_READING;
+			event.dev = found->second;
+			event.index = (uint32_t)fakerecords.size();
+			fakerecords.push_back(record);
+			events.push_back(event);
+		}
+	}
+	fakegi_addevents(events);
+	return true;
+}
+
+int fakegi_forksessions(const char* filename, int* sessions)
+{
+	*sessions = 0;
+	sessionrcs.clear();
+	if (!fakegi_readtrace(filename)) {
+		return -1;
+	}
+	*sessions = fakegi_tracesessions();
+	if (*sessions == 0) {
+		fprintf(stderr, "Trace %s has no session\n", filename);
+		return -1;
+	}
+	for (int session = 1; session <= *sessions; ++session) {
+// Nothing of the program's output so far is written twice, by the child too
+		fflush(NULL);
+		pid_t child = fork();
+		if (child == 0) {
+			return session;
+		}
+		int status = 0;
+		if ((child < 0) || (waitpid(child, &status, 0) != child)) {
+			fprintf(stderr, "Replay of session %i can't be started: %s\n", session, strerror(errno));
+			sessionrcs.push_back(-1);
+			continue;
+		}
+		sessionrcs.push_back(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+	}
+	return 0;
+}
+
+int fakegi_sessionrc(int session)
+{
+	return ((session >= 1) && ((size_t)session <= sessionrcs.size())) ? sessionrcs[session - 1] : -1;
+}
+
+void fakegi_realtime()
+{
+	fakerealtime = true;
+	fakerealstart = std::chrono::steady_clock::now() - std::chrono::microseconds(fakeclock);
+}
+
+// #############################################################################################################
+// Soak run: a day (or more) of hotplug churn, axis noise and keys
+// #############################################################################################################
+
+// Linear congruential generator (Knuth's MMIX constants), the same sequence on every run
+static uint64_t soakrandom = 0x5A17E4;
+static uint32_t fakegi_soakrandom(uint32_t range)
+{
+	soakrandom = soakrandom * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (uint32_t)((soakrandom >> 33) % range);
+}
+
+// Connect event of soak device 'dev': device 0 is the Trimwheel, the others are joysticks
+static Fakeevent fakegi_soakconnect(int dev, uint64_t time)
+{
+	Fakeevent event;
+	memset(&event, 0, sizeof(event));
+	event.time = time;
+	event.kind = FAKEGI_CONNECT;
+	event.dev = dev;
+	event.vid = (dev == 0) ? 0x06A3 : 0x044F;
+	event.pid = (dev == 0) ? 0x0BD4 : 0xB10A;
+	event.axes = (dev == 0) ? 1 : 8;
+	event.buttons = (dev == 0) ? 0 : 32;
+	return event;
+}
+
+void fakegi_soakscript(int hours)
+{
+	const uint64_t second = 1000000;
+	const uint64_t hour = 3600 * second;
+	std::vector<Fakeevent> events;
+	Fakeevent event;
+	memset(&event, 0, sizeof(event));
+	for (int hournbr = 0; hournbr < hours; ++hournbr) {
+		uint64_t hourstart = hournbr * hour;
+// All controllers connected at the full hour (the churn of the hour before is over)
+		for (int dev = 0; dev < FAKEGI_SOAKDEVICES; ++dev) {
+			events.push_back(fakegi_soakconnect(dev, hourstart));
+		}
+// Two unplugs of some minutes, over before the end of the hour
+		for (int churn = 0; churn < 2; ++churn) {
+			event.dev = (int)fakegi_soakrandom(FAKEGI_SOAKDEVICES);
+			event.time = hourstart + (10 + fakegi_soakrandom(30)) * 60 * second + fakegi_soakrandom(60) * second;
+			event.kind = FAKEGI_DISCONNECT;
+			events.push_back(event);
+			events.push_back(fakegi_soakconnect(event.dev, event.time + (1 + fakegi_soakrandom(10)) * 60 * second));
+		}
+// Axis noise on the joysticks, the Trimwheel is never turned
+		event.kind = FAKEGI_AXIS;
+		for (uint64_t offset = second / 2; offset < hour; offset += second) {
+			event.time = hourstart + offset;
+			event.dev = 1 + (int)fakegi_soakrandom(FAKEGI_SOAKDEVICES - 1);
+			event.index = fakegi_soakrandom(8);
+			event.value = (float)fakegi_soakrandom(2001) / 1000.0f - 1.0f;
+			events.push_back(event);
+		}
+// A key that isn't the exit key, for the cycle loop's _kbhit drain
+		event.kind = FAKEGI_KEY;
+		event.time = hourstart + (45 * 60 + fakegi_soakrandom(60)) * second;
+		event.index = 'x';
+		events.push_back(event);
+		event.index = 0;
+	}
+	fakegi_addevents(events);
+}
+
+uint32_t fakegi_connected()
+{
+	return fakeconnected;
+}
+
+size_t fakegi_heapbytes()
+{
+	return mallinfo2().uordblks;
+}
+
+// #############################################################################################################
+// Win32 functions on the virtual clock (windows.h, conio.h, timeapi.h of this folder)
+// #############################################################################################################
+
+// The program name as set by the C library (glibc), enough for getopt.c's messages
+char** __argv = &program_invocation_name;
+
+void Sleep(DWORD milliseconds)
+{
+	fakegi_advance(fakeclock + (uint64_t)milliseconds * 1000);
+}
+
+ULONGLONG GetTickCount64(void)
+{
+	return fakeclock / 1000;
+}
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count)
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	count->QuadPart = (LONGLONG)now.tv_sec * 1000000000LL + now.tv_nsec;
+	return TRUE;
+}
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+	frequency->QuadPart = 1000000000LL;
+	return TRUE;
+}
+
+// Events (CreateEventA), they live in the handle table of the file functions below
+static bool fakegi_signaled(Fakehandle* event);
+static bool fakegi_isevent(HANDLE handle);
+
+// Waiting for the dispatcher jumps to the next scripted event until it has queued work or the time is up,
+// waiting for an event in the main thread jumps from event to event until it is signaled
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+	if ((handle == fakethreadhandle) || ((std::this_thread::get_id() != fakemainthread) && fakegi_isevent(handle))) {
+		return WaitForMultipleObjects(1, &handle, FALSE, milliseconds);
+	}
+	uint64_t deadline = (milliseconds == INFINITE) ? UINT64_MAX : fakeclock + (uint64_t)milliseconds * 1000;
+	if (fakegi_isevent(handle)) {
+		while (!fakegi_signaled((Fakehandle*)handle)) {
+// The work of the last scripted event first, the dispatcher thread may signal the event meanwhile
+			if (!fakegi_quiesce((Fakehandle*)handle)) {
+				continue;
+			}
+			if ((fakenext >= fakescript.size()) || (fakescript[fakenext].time > deadline)) {
+				if (milliseconds == INFINITE) {
+					return WAIT_FAILED;		// end of script: no more callbacks that could signal it
+				}
+				fakegi_advance(deadline);
+				return fakegi_signaled((Fakehandle*)handle) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+			}
+			fakegi_advance(fakescript[fakenext].time);
+		}
+		return WAIT_OBJECT_0;
+	}
+	if (handle != fakewaithandle) {
+		return WAIT_FAILED;
+	}
+	while (!fakegi_workqueued()) {
+		if ((fakenext >= fakescript.size()) || (fakescript[fakenext].time > deadline)) {
+			if (milliseconds == INFINITE) {
+				return WAIT_FAILED;			// end of script: nothing will ever signal the handle
+			}
+			fakegi_advance(deadline);
+			return WAIT_TIMEOUT;
+		}
+		fakegi_advance(fakescript[fakenext].time);
+	}
+	return WAIT_OBJECT_0;
+}
+
+BOOL Beep(DWORD, DWORD duration)
+{
+	Sleep(duration);
+	return TRUE;
+}
+
+// The virtual clock is exact to the microsecond, there is no timer resolution to set
+MMRESULT timeBeginPeriod(UINT)
+{
+	return TIMERR_NOERROR;
+}
+
+MMRESULT timeEndPeriod(UINT)
+{
+	return TIMERR_NOERROR;
+}
+
+int _kbhit(void)
+{
+	return fakekeys.empty() ? 0 : 1;
+}
+
+// Like the real one, _getch waits for a key: until the next scripted key
+int _getch(void)
+{
+	while (fakekeys.empty()) {
+		if (fakenext >= fakescript.size()) {
+			return 0;
+		}
+		fakegi_advance(fakescript[fakenext].time);
+	}
+	int key = fakekeys.front();
+	fakekeys.pop_front();
+	return key;
+}
+
+// #############################################################################################################
+// Win32 file functions by POSIX (twtrace.cpp)
+// #############################################################################################################
+
+struct Fakehandle
+{
+	int fd;
+	bool mapping;						// file mapping (shares the descriptor of its file)
+	uint64_t mapsize;					// size of the mapping
+	bool event;							// event (CreateEventA) instead of a file
+	bool manualreset;
+	bool signaled;
+};
+
+static std::set<Fakehandle*> fakeevents;			// the events, to tell them from the other handles
+
+static std::map<const void*, size_t> fakeviews;		// mapped views and their sizes for UnmapViewOfFile
+
+HANDLE CreateFileA(const char* filename, DWORD access, DWORD, void*, DWORD disposition, DWORD, HANDLE)
+{
+	int flags = ((access & GENERIC_WRITE) != 0) ? O_RDWR : O_RDONLY;
+	if (disposition == OPEN_ALWAYS) {
+		flags |= O_CREAT;
+	} else if (disposition == CREATE_ALWAYS) {
+		flags |= O_CREAT | O_TRUNC;
+	}
+	int fd = open(filename, flags, 0644);
+	if (fd < 0) {
+		return INVALID_HANDLE_VALUE;
+	}
+	return new Fakehandle{ fd, false, 0, false, false, false };
+}
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* filesize)
+{
+	struct stat filestat;
+	if (fstat(((Fakehandle*)file)->fd, &filestat) != 0) {
+		return FALSE;
+	}
+	filesize->QuadPart = filestat.st_size;
+	return TRUE;
+}
+
+BOOL ReadFile(HANDLE file, void* buffer, DWORD toread, DWORD* bytesread, void*)
+{
+	ssize_t got = read(((Fakehandle*)file)->fd, buffer, toread);
+	if (got < 0) {
+		return FALSE;
+	}
+	*bytesread = (DWORD)got;
+	return TRUE;
+}
+
+BOOL SetFilePointerEx(HANDLE file, LARGE_INTEGER distance, LARGE_INTEGER* newpointer, DWORD method)
+{
+	off_t position = lseek(((Fakehandle*)file)->fd, (off_t)distance.QuadPart, (method == FILE_BEGIN) ? SEEK_SET : SEEK_CUR);
+	if (position < 0) {
+		return FALSE;
+	}
+	if (newpointer != NULL) {
+		newpointer->QuadPart = position;
+	}
+	return TRUE;
+}
+
+BOOL SetEndOfFile(HANDLE file)
+{
+	int fd = ((Fakehandle*)file)->fd;
+	return (ftruncate(fd, lseek(fd, 0, SEEK_CUR)) == 0) ? TRUE : FALSE;
+}
+
+// Like Windows, the mapping extends the file if it is shorter than the mapping
+HANDLE CreateFileMappingA(HANDLE file, void*, DWORD, DWORD sizehigh, DWORD sizelow, const char*)
+{
+	Fakehandle* filehandle = (Fakehandle*)file;
+	uint64_t mapsize = ((uint64_t)sizehigh << 32) | sizelow;
+	struct stat filestat;
+	if (fstat(filehandle->fd, &filestat) != 0) {
+		return NULL;
+	}
+	if (mapsize == 0) {
+		mapsize = (uint64_t)filestat.st_size;
+	} else if ((uint64_t)filestat.st_size < mapsize) {
+		if (ftruncate(filehandle->fd, (off_t)mapsize) != 0) {
+			return NULL;
+		}
+	}
+	return new Fakehandle{ filehandle->fd, true, mapsize, false, false, false };
+}
+
+void* MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsethigh, DWORD offsetlow, SIZE_T bytes)
+{
+	Fakehandle* maphandle = (Fakehandle*)mapping;
+	uint64_t offset = ((uint64_t)offsethigh << 32) | offsetlow;
+	size_t length = (bytes != 0) ? bytes : (size_t)(maphandle->mapsize - offset);
+	void* view = mmap(NULL, length, ((access & FILE_MAP_WRITE) != 0) ? (PROT_READ | PROT_WRITE) : PROT_READ,
+		MAP_SHARED, maphandle->fd, (off_t)offset);
+	if (view == MAP_FAILED) {
+		return NULL;
+	}
+	fakeviews[view] = length;
+	return view;
+}
+
+BOOL UnmapViewOfFile(const void* address)
+{
+	std::map<const void*, size_t>::iterator view = fakeviews.find(address);
+	if (view == fakeviews.end()) {
+		return FALSE;
+	}
+	munmap((void*)address, view->second);
+	fakeviews.erase(view);
+	return TRUE;
+}
+
+// A file mapping shares the descriptor of its file, only the file handle closes it.
+// Closing the wait handle of a dispatcher thread lets the virtual clock run freely again
+BOOL CloseHandle(HANDLE handle)
+{
+	if (handle == fakewaithandle) {
+		return TRUE;
+	}
+	if (handle == fakethreadhandle) {
+		{
+			std::lock_guard<std::mutex> lock(fakelock);
+			--fakethreads;
+		}
+		fakechanged.notify_all();
+		return TRUE;
+	}
+	if ((handle == NULL) || (handle == INVALID_HANDLE_VALUE)) {
+		return FALSE;
+	}
+	Fakehandle* fakehandle = (Fakehandle*)handle;
+	if (fakehandle->event) {
+		std::lock_guard<std::mutex> lock(fakelock);
+		fakeevents.erase(fakehandle);
+	} else if (!fakehandle->mapping) {
+		close(fakehandle->fd);
+	}
+	delete fakehandle;
+	return TRUE;
+}
+
+// #############################################################################################################
+// Win32 events and the dispatcher thread's wait (real time, see fakegameinput.h)
+// #############################################################################################################
+
+HANDLE CreateEventA(void*, BOOL manualreset, BOOL initialstate, const char*)
+{
+	Fakehandle* event = new Fakehandle{ -1, false, 0, true, manualreset != FALSE, initialstate != FALSE };
+	std::lock_guard<std::mutex> lock(fakelock);
+	fakeevents.insert(event);
+	return event;
+}
+
+BOOL SetEvent(HANDLE event)
+{
+	{
+		std::lock_guard<std::mutex> lock(fakelock);
+		if (fakeevents.count((Fakehandle*)event) == 0) {
+			return FALSE;
+		}
+		((Fakehandle*)event)->signaled = true;
+	}
+	fakechanged.notify_all();
+	return TRUE;
+}
+
+static bool fakegi_isevent(HANDLE handle)
+{
+	std::lock_guard<std::mutex> lock(fakelock);
+	return fakeevents.count((Fakehandle*)handle) != 0;
+}
+
+// Is the event signaled ? An auto-reset event is reset by the wait it ends (fakelock held by the caller)
+static bool fakegi_takesignal(Fakehandle* event)
+{
+	if (!event->signaled) {
+		return false;
+	}
+	if (!event->manualreset) {
+		event->signaled = false;
+	}
+	return true;
+}
+
+// Is the event (NULL: any event) signaled, without resetting it (fakelock held by the caller)
+static bool fakegi_eventset(Fakehandle* event)
+{
+	if (event != NULL) {
+		return event->signaled;
+	}
+	for (Fakehandle* anyevent : fakeevents) {
+		if (anyevent->signaled) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool fakegi_signaled(Fakehandle* event)
+{
+	std::lock_guard<std::mutex> lock(fakelock);
+	return fakegi_takesignal(event);
+}
+
+// Real-time wait for one of the handles: a dispatcher thread's wait handle (work queued) or events
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitall, DWORD milliseconds)
+{
+	if (waitall) {
+		return WAIT_FAILED;					// not needed by the program
+	}
+	DWORD signaled = WAIT_FAILED;
+	std::unique_lock<std::mutex> lock(fakelock);
+	for (DWORD index = 0; index < count; ++index) {
+		if ((handles[index] != fakethreadhandle) && (fakeevents.count((Fakehandle*)handles[index]) == 0)) {
+			return WAIT_FAILED;
+		}
+	}
+	std::function<bool()> ready = [&]() {
+		for (DWORD index = 0; index < count; ++index) {
+			if ((handles[index] == fakethreadhandle) ? !fakework.empty() : fakegi_takesignal((Fakehandle*)handles[index])) {
+				signaled = WAIT_OBJECT_0 + index;
+				return true;
+			}
+		}
+		return false;
+	};
+	if (milliseconds == INFINITE) {
+		fakechanged.wait(lock, ready);
+		return signaled;
+	}
+	return fakechanged.wait_for(lock, std::chrono::milliseconds(milliseconds), ready) ? signaled : WAIT_TIMEOUT;
+}
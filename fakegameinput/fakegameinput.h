@@ -0,0 +1,113 @@
+/*
+	fakegameinput.h
+
+	In-process fake of the Microsoft GameInput API V.0 for SaitekTrimwheel.cpp, published under MIT license like the main program.
+
+	Selected by CMake option SAITEKTW_FAKEGAMEINPUT (default on non-Windows systems): instead of linking GameInput.lib,
+	fakegameinput.cpp implements GameInputCreate() and the interfaces IGameInput, IGameInputDevice, IGameInputReading
+	and IGameInputDispatcher in memory, and the stand-in headers of this folder (windows.h, unknwn.h, conio.h, io.h,
+	crtdefs.h, timeapi.h) let GameInput.h and the program compile with gcc/clang. So the whole detection loop, its return codes
+	and its statistics (--stats) can be run on a Linux box.
+
+	Time is virtual: it starts at 0 when the program starts and only advances by Sleep(), Beep() and waiting on the
+	dispatcher's wait handle (event-driven mode "-e"), which jumps straight to the next scripted event. So a run over
+	a whole day of cycles takes less than a second. GetTickCount64() and the GameInput timestamps read the virtual clock,
+	QueryPerformanceCounter() stays the real clock, as twstats measures the cost of our own code.
+
+	Like GameInput in manual dispatch mode, all callbacks are called by the thread that calls Dispatch(),
+	or from RegisterDeviceCallback() for GameInputBlockingEnumeration. A dispatcher thread ("--dispatcher") opens
+	a wait handle of its own and waits on it with WaitForMultipleObjects() in real time. While such a handle is open,
+	the virtual clock stops at each scripted event until the thread has dispatched all work the event has queued,
+	so the callbacks run at the virtual time of their event, as if the thread had been waiting for it.
+	Events (CreateEventA, SetEvent) are signaled in real time; the main thread's WaitForSingleObject() on one
+	advances the virtual clock event by event until it is signaled.
+
+	The devices and their inputs come from a script file (option "--script <file>" of the fake build), one event
+	per line, <ms> is the virtual time in milliseconds since program start, <dev> a number 0...FAKEGI_MAXDEVICES-1
+	chosen by the script. Empty lines and lines starting with '#' are ignored.
+
+		<ms> connect <dev> <vid> <pid> [<axes> [<buttons> [<switches>]]]	controller plugged in (default 1 axis)
+		<ms> disconnect <dev>								controller unplugged
+		<ms> replug <dev>									new device object of a plugged controller, the old
+															object's disconnect is never reported (quick USB reset)
+		<ms> axis <dev> <index> <value>						one reading with a new axis value
+		<ms> ramp <dev> <index> <from> <to> <duration> <step>	axis readings every <step> ms from <from> to <to>
+		<ms> button <dev> <index> <0|1>						one reading with a button released/pressed
+		<ms> switch <dev> <index> <position>				one reading with a switch position (GameInputSwitchPosition)
+		<ms> key <char>										key pressed on the console (_kbhit/_getch), e.g. "key Q"
+		<ms> synth <dev> <count> <vid> <pid> [<axes> [<buttons> [<switches>]]]	connect devices <dev>...<dev>+<count>-1
+		<ms> noise <dev> <count> <duration> <step>			every <step> ms a new axis 0 value (button 0 without axes)
+															for each of the devices <dev>...<dev>+<count>-1
+		history <readings>									reading history per device (GetNextReading), default 32
+
+	Each connect gives the device a first reading (all inputs zero). A device keeps its APP_LOCAL_DEVICE_ID over
+	reconnects, but gets a new IGameInputDevice object each time, like with the real API.
+	Example: Trimwheel plugged in at boot, turned after 5 seconds
+		0 connect 1 0x06A3 0x0BD4
+		5000 axis 1 0 0.25
+	synth and noise are for scaling benchmarks of the cycle loop, e.g. 512 joysticks with 8 axes and 32 buttons
+	and inputs every 100 ms on all of them (the registry holds DEVREG_MAXDEVICES, see CMake option SAITEKTW_MAXDEVICES):
+		0 synth 0 512 0x044F 0xB10A 8 32
+		0 noise 0 512 60000 100
+
+	Replay (option "--replay <file>" with "--session <n>"): instead of a script, the events come from a session of
+	a trace file written by "-T" (see twtrace.h), usually on the real GameInput with "-d" to get every reading.
+	The device callbacks of the session connect/disconnect the controllers with their recorded counts of axes,
+	buttons and switches, and each traced reading becomes one reading with its recorded sequence number,
+	axes (the first TWTRACE_AXES) and buttons, at its recorded timestamp relative to the session start.
+	Replayed connects have no first reading of their own, the recorded readings bring the controller's state.
+	With "--session all", each session is replayed by a child process of its own (fakegi_forksessions).
+	The replay runs as fast as possible on the virtual clock, or at real speed ("--realtime"): then the virtual
+	clock doesn't jump ahead but waits for the real time, e.g. to watch a recorded boot session once more.
+	A script runs at real speed too with "--realtime". The virtual clock then never lags behind the real one:
+	if the program was held up (e.g. by a slow console), GetCurrentTimestamp() shows the real time and the next wait
+	catches up with it (the events in between are due then), so the delay shows as it would on Windows.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Max. number of scripted devices (<dev> numbers)
+#define FAKEGI_MAXDEVICES	4096
+// Default number of readings kept per device for GetNextReading/GetPreviousReading
+#define FAKEGI_HISTORY		32
+// Controllers of the soak run
+#define FAKEGI_SOAKDEVICES	8
+
+// Load the event script, returns false (with a message on stderr) if the file can't be read or has an error
+// Should be called before GameInputCreate(), events already due then are processed at GameInputCreate()
+bool fakegi_loadscript(const char* filename);
+
+// Load session 'session' (1 = first) of trace file 'filename' as events, returns false (with a message on stderr)
+// if the file can't be read, isn't a trace file or has no such session. 'recordedrc' receives the session's
+// return code (-1 if the recording program didn't end normally), 'recordedms' its run time up to the exit event
+// (0 without one), 'sessions' the number of sessions in the file
+bool fakegi_loadtrace(const char* filename, int session, int* recordedrc, uint64_t* recordedms, int* sessions);
+
+// Replay of all sessions ("--session all"): the sessions of trace file 'filename' one after the other, each in a
+// child process forked by this call, so each starts from the program's state at the call (its options parsed, no
+// GameInput yet) without a program start of its own, and the trace is read only once. Returns the session number
+// in the child, which goes on to replay it by fakegi_loadtrace() and ends with its RC; in the program itself 0 once
+// all children have ended, -1 (with a message on stderr) if the trace can't be read or has no session.
+// 'sessions' receives the number of sessions
+int fakegi_forksessions(const char* filename, int* sessions);
+
+// Return code of the child of session 'session' (1 = first) of fakegi_forksessions(), -1 if it didn't end normally
+int fakegi_sessionrc(int session);
+
+// Pace the virtual clock by the real clock from now on (script or replay at real speed)
+void fakegi_realtime();
+
+// Soak run ("--soak"): generate 'hours' of hotplug churn, axis noise and keys. The Trimwheel (device 0) and
+// FAKEGI_SOAKDEVICES-1 other controllers are connected at every full hour; within each hour two of them are
+// unplugged for some minutes, every second one of the others gets a new axis value, and a key (not the exit key)
+// is pressed. The Trimwheel's axis stays 0, so the program runs all cycles. The random choices are seeded,
+// so every soak run is the same
+void fakegi_soakscript(int hours);
+
+// Number of connected fake devices
+uint32_t fakegi_connected();
+
+// Bytes allocated on the heap (glibc mallinfo2), for the soak run's memory check
+size_t fakegi_heapbytes();
@@ -0,0 +1,38 @@
+/*
+	io.h
+
+	Stand-in for the MSVC runtime header of the same name, only used by the fake GameInput build
+	(CMake option SAITEKTW_FAKEGAMEINPUT, see fakegameinput.h), published under MIT license like the main program.
+
+	Maps the low-level I/O functions of twjson.cpp to POSIX.
+*/
+#pragma once
+
+#include <stdio.h>
+#include <unistd.h>
+
+static inline int _dup(int fd)
+{
+	return dup(fd);
+}
+
+// MSVC's _dup2 returns 0 on success, POSIX dup2 the new descriptor
+static inline int _dup2(int fd, int fd2)
+{
+	return (dup2(fd, fd2) < 0) ? -1 : 0;
+}
+
+static inline int _close(int fd)
+{
+	return close(fd);
+}
+
+static inline int _fileno(FILE* stream)
+{
+	return fileno(stream);
+}
+
+static inline FILE* _fdopen(int fd, const char* mode)
+{
+	return fdopen(fd, mode);
+}
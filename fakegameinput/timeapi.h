@@ -0,0 +1,27 @@
+/*
+	timeapi.h
+
+	Stand-in for the Windows SDK header of the same name, only used by the fake GameInput build
+	(CMake option SAITEKTW_FAKEGAMEINPUT, see fakegameinput.h), published under MIT license like the main program.
+
+	The virtual clock has no timer resolution: timeBeginPeriod() and timeEndPeriod() do nothing (fakegameinput.cpp).
+*/
+#pragma once
+
+#include "windows.h"
+
+typedef uint32_t UINT;
+typedef UINT MMRESULT;
+
+#define TIMERR_NOERROR	0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MMRESULT timeBeginPeriod(UINT period);
+MMRESULT timeEndPeriod(UINT period);
+
+#ifdef __cplusplus
+}   // extern "C"
+#endif
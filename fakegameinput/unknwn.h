@@ -0,0 +1,93 @@
+/*
+	unknwn.h
+
+	Stand-in for the Windows SDK header of the same name, only used by the fake GameInput build
+	(CMake option SAITEKTW_FAKEGAMEINPUT, see fakegameinput.h), published under MIT license like the main program.
+
+	Provides just what GameInput.h needs on a non-Windows compiler: IUnknown, the interface declaration macros
+	and the SAL annotations (expanded to nothing). Like the real one, it brings windows.h along with the basic types.
+*/
+#pragma once
+
+#include "windows.h"
+
+// Windows API family partitions: GameInput.h is declared for all of them
+#define WINAPI_FAMILY_PARTITION(partitions)	1
+#define WINAPI_PARTITION_APP		1
+#define WINAPI_PARTITION_SYSTEM		1
+#define WINAPI_PARTITION_GAMES		1
+
+// SAL annotations used by GameInput.h, only meaningful to the MSVC code analysis
+#define _In_
+#define _In_opt_
+#define _In_reads_(size)
+#define _In_reads_bytes_opt_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_bytes_all_opt_(size)
+#define _Outptr_
+#define _Outptr_result_maybenull_
+#define _Outptr_result_nullonfailure_
+#define _COM_Outptr_
+#define _Must_inspect_result_
+#define _Result_zeroonfailure_
+#define _Ret_notnull_
+#define _Field_size_full_(size)
+#define _Field_size_full_opt_(size)
+#define _Field_size_bytes_full_opt_(size)
+#define _Field_z_
+
+// App-local device id (winnt.h)
+typedef struct APP_LOCAL_DEVICE_ID
+{
+	BYTE value[32];
+} APP_LOCAL_DEVICE_ID;
+
+#ifdef __cplusplus
+#define STDAPI	extern "C" HRESULT STDMETHODCALLTYPE
+#else
+#define STDAPI	extern HRESULT STDMETHODCALLTYPE
+#endif
+
+#ifdef __cplusplus
+// Interface ids aren't known to the fake backend, its QueryInterface always answers E_NOINTERFACE
+typedef struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+} GUID;
+typedef const GUID& REFIID;
+
+// COM interface declarations (objbase.h), without __declspec(uuid) and __declspec(novtable)
+#define interface	struct
+#define PURE		= 0
+#define THIS_
+#define THIS		void
+#define IFACEMETHOD(method)				virtual HRESULT STDMETHODCALLTYPE method
+#define IFACEMETHOD_(type, method)		virtual type STDMETHODCALLTYPE method
+#define DECLARE_INTERFACE_IID_(iface, baseiface, iid)	interface iface : public baseiface
+
+interface IUnknown
+{
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) = 0;
+	virtual ULONG STDMETHODCALLTYPE AddRef(void) = 0;
+	virtual ULONG STDMETHODCALLTYPE Release(void) = 0;
+};
+
+// Bit operators for the flag enums of GameInput.h (winnt.h)
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE) \
+extern "C++" { \
+inline ENUMTYPE operator | (ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((int)a) | ((int)b)); } \
+inline ENUMTYPE& operator |= (ENUMTYPE& a, ENUMTYPE b) { return (ENUMTYPE&)(((int&)a) |= ((int)b)); } \
+inline ENUMTYPE operator & (ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((int)a) & ((int)b)); } \
+inline ENUMTYPE& operator &= (ENUMTYPE& a, ENUMTYPE b) { return (ENUMTYPE&)(((int&)a) &= ((int)b)); } \
+inline ENUMTYPE operator ~ (ENUMTYPE a) { return ENUMTYPE(~((int)a)); } \
+inline ENUMTYPE operator ^ (ENUMTYPE a, ENUMTYPE b) { return ENUMTYPE(((int)a) ^ ((int)b)); } \
+inline ENUMTYPE& operator ^= (ENUMTYPE& a, ENUMTYPE b) { return (ENUMTYPE&)(((int&)a) ^= ((int)b)); } \
+}
+#else
+#define DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE)
+#endif
@@ -0,0 +1,116 @@
+/*
+	windows.h
+
+	Stand-in for the Windows SDK header of the same name, only used by the fake GameInput build
+	(CMake option SAITEKTW_FAKEGAMEINPUT, see fakegameinput.h), published under MIT license like the main program.
+
+	Declares the basic Windows types and the few Win32 functions SaitekTrimwheel and its submodules call.
+	They are implemented in fakegameinput.cpp: the time functions on the virtual clock of the fake backend,
+	the file functions (twtrace.cpp) by their POSIX counterparts.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Calling conventions don't exist on x64 / Linux
+#define CALLBACK
+#define WINAPI
+#define STDMETHODCALLTYPE
+
+// Basic Windows types
+typedef int32_t HRESULT;				// 32 bits like on Windows (long has 64 bits on Linux x64)
+typedef uint32_t ULONG;
+typedef uint32_t DWORD;
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef void* HANDLE;
+typedef const wchar_t* LPCWSTR;
+typedef unsigned long long ULONGLONG;
+typedef long long LONGLONG;
+typedef size_t SIZE_T;
+
+#define TRUE	1
+#define FALSE	0
+
+// HRESULT codes (winerror.h)
+#define _HRESULT_TYPEDEF_(code)	((HRESULT)code)
+#define SUCCEEDED(hr)	(((HRESULT)(hr)) >= 0)
+#define FAILED(hr)		(((HRESULT)(hr)) < 0)
+#define S_OK			((HRESULT)0L)
+#define S_FALSE			((HRESULT)1L)
+#define E_NOTIMPL		_HRESULT_TYPEDEF_(0x80004001L)
+#define E_NOINTERFACE	_HRESULT_TYPEDEF_(0x80004002L)
+#define E_POINTER		_HRESULT_TYPEDEF_(0x80004003L)
+#define E_FAIL			_HRESULT_TYPEDEF_(0x80004005L)
+#define E_OUTOFMEMORY	_HRESULT_TYPEDEF_(0x8007000EL)
+#define E_INVALIDARG	_HRESULT_TYPEDEF_(0x80070057L)
+
+#define ARRAYSIZE(array)	(sizeof(array) / sizeof((array)[0]))
+
+typedef union _LARGE_INTEGER
+{
+	LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+#define INFINITE			0xFFFFFFFF
+#define WAIT_OBJECT_0		0x00000000L
+#define WAIT_TIMEOUT		0x00000102L
+#define WAIT_FAILED			0xFFFFFFFF
+#define INVALID_HANDLE_VALUE	((HANDLE)(intptr_t)-1)
+
+// CreateFileA, CreateFileMappingA, MapViewOfFile, SetFilePointerEx
+#define GENERIC_READ		0x80000000
+#define GENERIC_WRITE		0x40000000
+#define FILE_SHARE_READ		0x00000001
+#define CREATE_ALWAYS		2
+#define OPEN_EXISTING		3
+#define OPEN_ALWAYS			4
+#define FILE_ATTRIBUTE_NORMAL	0x00000080
+#define PAGE_READWRITE		0x04
+#define FILE_MAP_WRITE		0x0002
+#define FILE_BEGIN			0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MSVC runtime: the program's arguments (getopt.c prints __argv[0] in its messages)
+extern char** __argv;
+
+// Time: Sleep() and WaitForSingleObject() advance the virtual clock of the fake backend,
+// GetTickCount64() reads it, QueryPerformanceCounter() is the real monotonic clock (twstats measures our own code)
+void Sleep(DWORD milliseconds);
+ULONGLONG GetTickCount64(void);
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count);
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitall, DWORD milliseconds);
+BOOL CloseHandle(HANDLE handle);
+
+// Events (twdispatch.cpp): the dispatcher thread's stop event and the main loop's wake event
+HANDLE CreateEventA(void* security, BOOL manualreset, BOOL initialstate, const char* name);
+BOOL SetEvent(HANDLE event);
+
+// Sound: no sound device, the call only takes its time on the virtual clock
+BOOL Beep(DWORD frequency, DWORD duration);
+
+// Files (twtrace.cpp)
+HANDLE CreateFileA(const char* filename, DWORD access, DWORD sharemode, void* security, DWORD disposition,
+	DWORD attributes, HANDLE templatefile);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* filesize);
+BOOL ReadFile(HANDLE file, void* buffer, DWORD toread, DWORD* bytesread, void* overlapped);
+BOOL SetFilePointerEx(HANDLE file, LARGE_INTEGER distance, LARGE_INTEGER* newpointer, DWORD method);
+BOOL SetEndOfFile(HANDLE file);
+HANDLE CreateFileMappingA(HANDLE file, void* security, DWORD protect, DWORD sizehigh, DWORD sizelow, const char* name);
+void* MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsethigh, DWORD offsetlow, SIZE_T bytes);
+BOOL UnmapViewOfFile(const void* address);
+
+#ifdef __cplusplus
+}   // extern "C"
+#endif
+
+// COM, as with the real windows.h
+#include "unknwn.h"
@@ -0,0 +1,71 @@
+# Virtual clock (twclock.h): every wait and time of the program runs on the fake's clock, so a day takes seconds
+#
+# * day : the default run length (a day of 1 s cycles) without a Trimwheel in each cycle mode, RC=16 after exactly
+#   86400 cycles in 86400.000 secs, no overrun, 3600 wakeups per hour; each run within a minute of real time
+# * short : 10 ms cycles for an hour, 360000 cycles in 3600.000 secs
+# * timestamps : the Trimwheel turned after 12 hours, the "turned" and "exit" events of --json at the virtual
+#   time of the reading and of the next cycle; with "-t" the tone at exit (500 ms) is on the clock too
+# * soak : "--soak" with "-a", the table's controllers per hour never more than the 8 connected, the last hour's
+#   mean cycle within twice the first hour's (plus 2 us of noise)
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+twscript(empty "# no controller")
+foreach (mode "" "-e" "-e --dispatcher" "-d" "-a")
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	string(TIMESTAMP start "%s")
+	twrun(output rc -s ${args} --script ${empty})
+	string(TIMESTAMP end "%s")
+	math(EXPR secs "${end} - ${start}")
+	twexpectrc("day ${mode}" "${rc}" 16 "${output}")
+	if (NOT output MATCHES "Cycles: 86400 in 86400\\.000 secs, period 1000 msecs, overruns: 0, wakeups: 86400 \\(3600 per hour\\)")
+		message(SEND_ERROR "day ${mode}: not a day of cycles, output:\n${output}")
+	endif()
+	message("day ${mode}: 86400 cycles in ${secs} secs of real time")
+	twexpect("day ${mode}" "secs of real time" "${secs}" LESS_EQUAL 60)
+endforeach()
+
+twrun(output rc -s -p 10 -c 3600 --script ${empty})
+twexpectrc("short" "${rc}" 16 "${output}")
+if (NOT output MATCHES "Cycles: 360000 in 3600\\.000 secs, period 10 msecs, overruns: 0")
+	message(SEND_ERROR "short: not an hour of 10 ms cycles, output:\n${output}")
+endif()
+
+twscript(halfday "0 connect 1 0x06A3 0x0BD4" "43200000 axis 1 0 0.5")
+foreach (tone "" "-t")
+	execute_process(COMMAND ${PROGRAM} -s ${tone} --json --script ${halfday} OUTPUT_VARIABLE json
+		ERROR_VARIABLE messages RESULT_VARIABLE rc TIMEOUT 600)
+	twexpectrc("timestamps ${tone}" "${rc}" 0 "${json}${messages}")
+	twnumber(turnedts "\"event\":\"turned\",\"ts\":([0-9]+)" "${json}")
+	twnumber(exitts "\"event\":\"exit\",\"ts\":([0-9]+)" "${json}")
+	if (tone)
+		set(expected 43201500000)
+	else()
+		set(expected 43201000000)
+	endif()
+	twexpect("timestamps ${tone}" "ts of turned" "${turnedts}" EQUAL 43200000000)
+	twexpect("timestamps ${tone}" "ts of exit" "${exitts}" EQUAL ${expected})
+	message("timestamps ${tone}: turned at ${turnedts} us, exit at ${exitts} us")
+endforeach()
+
+twrun(output rc -s -a --soak=24)
+twexpectrc("soak" "${rc}" 1 "${output}")
+string(REGEX MATCHALL "\n +[0-9]+ +[0-9]+ +[0-9.]+ +[0-9]+ +[0-9]+" rows "${output}")
+set(firstmean "")
+set(maxcontrollers 0)
+foreach (row IN LISTS rows)
+	string(REGEX MATCH "([0-9]+)\\.([0-9]+) +([0-9]+) +[0-9]+$" row "${row}")
+# mean in ns (usecs with 3 decimals)
+	set(mean "${CMAKE_MATCH_1}${CMAKE_MATCH_2}")
+	math(EXPR mean "${mean}")
+	if (firstmean STREQUAL "")
+		set(firstmean ${mean})
+	endif()
+	if (CMAKE_MATCH_3 GREATER maxcontrollers)
+		set(maxcontrollers ${CMAKE_MATCH_3})
+	endif()
+endforeach()
+message("soak: ${maxcontrollers} controllers at most, mean cycle ${firstmean} ns in the first hour, ${mean} ns in the last")
+twexpect("soak" "controllers" "${maxcontrollers}" LESS_EQUAL 8)
+math(EXPR limit "${firstmean} * 2 + 2000")
+twexpect("soak" "last hour's mean cycle (ns)" "${mean}" LESS_EQUAL ${limit})
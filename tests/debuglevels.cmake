@@ -0,0 +1,128 @@
+# Compile-time debug levels (twlog.h, CMake option SAITEKTW_MAXDBGLVL): the program built with TWLOG_MAXLVL=0
+# (-DNODEBUGPROGRAM=<SaitekTrimwheelNodebug>), 1 and 3 (-DLVL1PROGRAM, -DLVL3PROGRAM) against the main build with
+# level -DMAINLEVEL (9 by default)
+#
+# * messages : the Trimwheel connected and turned, run with -vvv; the main build has to show debug messages of
+#   levels 1 to 3, the build without them none at all, both end with RC=0
+# * size : table of the executables' sizes, a lower level is never the bigger one, level 0 is smaller than the main
+#   build; the size is code and data (text + data of "size", -DSIZE=<size>), else the file's size, which grows by
+#   whole pages and symbol names and may not follow the code
+# * cycle : the cycle's p50 of "--stats" without -v (a minute of 1 s cycles, 16 other controllers with -a), the lowest
+#   of 5 runs each, the build without debug messages must not be slower than the main build
+# * instructions : the user mode instructions of a cycle without -v (the same 17 controllers), the difference of a
+#   run of 3 and one of 1 cycle, halved: by "perf stat" (-DPERF=<perf>), else by the ptrace counter (-DINSCOUNT=
+#   <twinscount>, counted from the start of the console writer thread), left out without both. A lower level may
+#   cost at most 1% more than the main build
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+if (NOT NODEBUGPROGRAM)
+	message(FATAL_ERROR "Call with -DNODEBUGPROGRAM=<SaitekTrimwheel built with TWLOG_MAXLVL=0>")
+endif()
+set(MAINPROGRAM ${PROGRAM})
+if (NOT DEFINED MAINLEVEL)
+	set(MAINLEVEL 9)
+endif()
+
+twscript(turn "0 connect 1 0x06A3 0x0BD4" "0 connect 2 0x044F 0xB10A 8 32" "5000 ramp 1 0 0 0.5 300 10")
+twrun(output rc -vvv -c 10 --script ${turn})
+twexpectrc("messages main build" "${rc}" 0 "${output}")
+foreach (level 1 2 3)
+	string(REGEX MATCHALL "#DBG${level} " lines "${output}")
+	list(LENGTH lines count)
+	twexpect("messages main build" "#DBG${level} messages" "${count}" GREATER 0)
+	message("messages main build: ${count} #DBG${level} messages")
+endforeach()
+set(PROGRAM ${NODEBUGPROGRAM})
+twrun(output rc -vvv -c 10 --script ${turn})
+twexpectrc("messages without debug" "${rc}" 0 "${output}")
+string(REGEX MATCHALL "#DBG[0-9]" lines "${output}")
+list(LENGTH lines count)
+twexpect("messages without debug" "#DBG messages" "${count}" EQUAL 0)
+
+twscript(cycle "0 connect 1 0x06A3 0x0BD4" "0 synth 2 16 0x044F 0xB10A 8 32" "0 noise 2 16 60000 100")
+foreach (build main nodebug)
+	if (build STREQUAL "main")
+		set(PROGRAM ${MAINPROGRAM})
+	else()
+		set(PROGRAM ${NODEBUGPROGRAM})
+	endif()
+	foreach (run RANGE 1 5)
+		twrun(output rc -s -a -c 60 --stats --json --script ${cycle})
+		twexpectrc("cycle ${build}" "${rc}" 1 "${output}")
+		twnumber(p50 "\"phase\":\"cycle\",[^\n]*\"p50_ns\":([0-9]+)" "${output}")
+		if ((run EQUAL 1) OR (p50 LESS p50${build}))
+			set(p50${build} ${p50})
+		endif()
+	endforeach()
+endforeach()
+message("cycle: p50 main build ${p50main} ns, without debug messages ${p50nodebug} ns")
+# Loose bound: the buckets of the histogram are coarse, the skipped checks of verbolvl only a few ns of a cycle
+math(EXPR limit "${p50main} * 2 + 1000")
+twexpect("cycle" "p50 without debug messages (ns)" "${p50nodebug}" LESS_EQUAL ${limit})
+
+# Instructions of a run of <cycles> cycles of build <program>, sets <var> to them
+function(twinstructions var program cycles)
+	if (PERF)
+		execute_process(COMMAND ${PERF} stat -x, -e instructions:u ${program} -s -a -c ${cycles} --script ${cycle}
+			OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE rc TIMEOUT 600)
+		twnumber(count "([0-9]+),[^,\n]*,instructions" "${output}")
+	else()
+		execute_process(COMMAND ${INSCOUNT} --fromthread ${program} -s -a -c ${cycles} --script ${cycle}
+			OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE rc TIMEOUT 600)
+		twnumber(count "Instructions: ([0-9]+)" "${output}")
+	endif()
+	twexpectrc("instructions of ${program}" "${rc}" 1 "${output}")
+	set(${var} ${count} PARENT_SCOPE)
+endfunction()
+
+# Level and executable of the builds, lowest level first
+set(builds 0 ${NODEBUGPROGRAM})
+if (LVL1PROGRAM AND (MAINLEVEL GREATER 1))
+	list(APPEND builds 1 ${LVL1PROGRAM})
+endif()
+if (LVL3PROGRAM AND (MAINLEVEL GREATER 3))
+	list(APPEND builds 3 ${LVL3PROGRAM})
+endif()
+list(APPEND builds ${MAINLEVEL} ${MAINPROGRAM})
+set(sizes "")
+set(instructions "")
+while (builds)
+	list(POP_FRONT builds level program)
+	if (SIZE)
+		execute_process(COMMAND ${SIZE} ${program} OUTPUT_VARIABLE sizeoutput RESULT_VARIABLE sizerc)
+		if (NOT sizerc EQUAL 0 OR NOT sizeoutput MATCHES "\n *([0-9]+)[ \t]+([0-9]+)[ \t]")
+			message(FATAL_ERROR "${SIZE} ${program} failed (${sizerc}):\n${sizeoutput}")
+		endif()
+		math(EXPR size "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+	else()
+		file(SIZE ${program} size)
+	endif()
+	set(percycle "-")
+	if (PERF OR INSCOUNT)
+		twinstructions(short ${program} 1)
+		twinstructions(long ${program} 3)
+		math(EXPR percycle "(${long} - ${short}) / 2")
+	endif()
+	list(APPEND sizes ${size})
+	list(APPEND instructions ${percycle})
+	list(APPEND levels ${level})
+endwhile()
+
+message("| TWLOG_MAXLVL | size (bytes) | instructions per cycle |")
+message("|---|---|---|")
+foreach (level size percycle IN ZIP_LISTS levels sizes instructions)
+	message("| ${level} | ${size} | ${percycle} |")
+endforeach()
+list(GET sizes -1 mainsize)
+list(GET instructions -1 maininstructions)
+list(GET sizes 0 nodebugsize)
+twexpect("size" "bytes without debug messages" "${nodebugsize}" LESS ${mainsize})
+set(lastsize 0)
+foreach (level size percycle IN ZIP_LISTS levels sizes instructions)
+	twexpect("size" "bytes of level ${level}" "${size}" GREATER_EQUAL ${lastsize})
+	set(lastsize ${size})
+	if (NOT percycle STREQUAL "-")
+		math(EXPR limit "${maininstructions} * 101 / 100")
+		twexpect("instructions" "instructions per cycle of level ${level}" "${percycle}" LESS_EQUAL ${limit})
+	endif()
+endforeach()
@@ -0,0 +1,38 @@
+# Drain mode "-d" (README "Drain mode"): every reading of the Trimwheel's history between two cycles is evaluated
+#
+# * nudge : the wheel turned to 0.3 and back to exactly 0 within one cycle, only the drain sees it (RC=0, without
+#   "-d" RC=1)
+# * overflow : 100 readings between two cycles with a history of 32, the ones that fell out of it are counted as
+#   dropped, processed and dropped add up to all readings
+# * bench : 100000 readings (one every ms, jitter within the deadband) through the drain in cycles of 100 ms, none
+#   dropped, the cycle's p50 (100 readings each) within the limit
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+twscript(nudge "0 connect 1 0x06A3 0x0BD4" "2100 ramp 1 0 0 0.3 200 8" "2500 ramp 1 0 0.3 0 200 8")
+twrun(output rc -s -c 10 -d --script ${nudge})
+twexpectrc("nudge -d" "${rc}" 0 "${output}")
+twrun(output rc -s -c 10 --script ${nudge})
+twexpectrc("nudge without -d" "${rc}" 1 "${output}")
+
+# 1 connect reading, 100 readings from 2001 to 2100 ms
+twscript(overflow "history 32" "0 connect 1 0x06A3 0x0BD4" "2001 ramp 1 0 0 0.005 99 1")
+twrun(output rc -s -c 5 -d --script ${overflow})
+twexpectrc("overflow" "${rc}" 1 "${output}")
+twnumber(processed "Trimwheel readings processed: ([0-9]+)" "${output}")
+twnumber(dropped "Trimwheel readings processed: [0-9]+, dropped: ([0-9]+)" "${output}")
+math(EXPR readings "${processed} + ${dropped}")
+twexpect("overflow" "processed + dropped readings" "${readings}" EQUAL 101)
+twexpect("overflow" "dropped readings" "${dropped}" GREATER_EQUAL 68)
+message("overflow: ${processed} readings processed, ${dropped} dropped")
+
+twscript(bench "history 200" "0 connect 1 0x06A3 0x0BD4" "1000 ramp 1 0 0 0.005 99999 1")
+twrun(output rc -s -c 102 -p 100 -d --stats --script ${bench})
+twexpectrc("bench" "${rc}" 1 "${output}")
+twnumber(processed "Trimwheel readings processed: ([0-9]+)" "${output}")
+twnumber(dropped "Trimwheel readings processed: [0-9]+, dropped: ([0-9]+)" "${output}")
+twexpect("bench" "processed readings" "${processed}" EQUAL 100001)
+twexpect("bench" "dropped readings" "${dropped}" EQUAL 0)
+twnumber(p50 "\n  cycle +[0-9]+ +([0-9.]+)" "${output}")
+message("bench: ${processed} readings, cycle p50 ${p50} usecs (100 readings)")
+twexpect("bench" "cycle p50 (usecs)" "${p50}" LESS_EQUAL 100)
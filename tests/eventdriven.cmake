@@ -0,0 +1,72 @@
+# Event-driven mode "-e": the wait of a cycle ends with the Trimwheel's reading, not with the cycle period
+#
+# * block : a cycle period of 10 s, the Trimwheel connected, two readings of axis 0 and the turn at 5.3 s: the program
+#   doesn't wake up for the zero readings (one wakeup in all) and ends at the turn's reading, not at the period
+# * deadline : no turn within "-c 5": RC=1 at the deadline (exit event at 5 s), one wakeup per cycle
+# * first reading : the turn at a random millisecond (readiness with a single position, so the first non-zero reading
+#   is the turn), with and without "--dispatcher": the exit event is at most 1 ms (virtual clock) after the reading;
+#   3 runs "--realtime", where the wait is a real one: at most 5 ms of real time after the reading
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+set(trials 50)
+set(seed 1)
+set(ready --ready=0.01,1,0.1)
+
+# Next number of the generator (the LCG of ANSI C), sets <var> to a number 0...<range> - 1
+macro(twrandom var range)
+	math(EXPR seed "(${seed} * 1103515245 + 12345) % 2147483648")
+	math(EXPR ${var} "(${seed} / 65536) % ${range}")
+endmacro()
+
+twscript(block "0 connect 1 0x06A3 0x0BD4" "1000 axis 1 0 0" "2000 axis 1 0 0" "5300 axis 1 0 0.5")
+foreach (mode "-e" "-e --dispatcher")
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	twrun(output rc -s ${args} -p 10000 -c 20 ${ready} --json --script ${block})
+	twexpectrc("block ${mode}" "${rc}" 0 "${output}")
+	twnumber(exitts "\"event\":\"exit\",\"ts\":([0-9]+)" "${output}")
+	twnumber(wakeups "wakeups: ([0-9]+) " "${output}")
+	twexpect("block ${mode}" "exit (usecs)" "${exitts}" GREATER_EQUAL 5300000)
+	twexpect("block ${mode}" "exit (usecs)" "${exitts}" LESS_EQUAL 5301000)
+	twexpect("block ${mode}" "wakeups" "${wakeups}" LESS_EQUAL 1)
+	message("block ${mode}: exit at ${exitts} usecs, ${wakeups} wakeups (turn at 5300000 usecs, period 10 s)")
+endforeach()
+
+twscript(deadline "0 connect 1 0x06A3 0x0BD4" "1000 axis 1 0 0")
+twrun(output rc -s -e -p 1000 -c 5 --json --script ${deadline})
+twexpectrc("deadline" "${rc}" 1 "${output}")
+twnumber(exitts "\"event\":\"exit\",\"ts\":([0-9]+)" "${output}")
+twnumber(wakeups "wakeups: ([0-9]+) " "${output}")
+twexpect("deadline" "exit (usecs)" "${exitts}" GREATER_EQUAL 5000000)
+twexpect("deadline" "exit (usecs)" "${exitts}" LESS 6000000)
+twexpect("deadline" "wakeups" "${wakeups}" LESS_EQUAL 5)
+message("deadline: RC=${rc}, exit at ${exitts} usecs, ${wakeups} wakeups")
+
+foreach (mode "-e" "-e --dispatcher")
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	set(maxlatency 0)
+	foreach (trial RANGE 1 ${trials})
+		twrandom(turn 1000)
+		math(EXPR turn "${turn} + 2000")
+		twscript(first "0 connect 1 0x06A3 0x0BD4" "1000 axis 1 0 0" "${turn} axis 1 0 0.5")
+		twrun(output rc -s ${args} -p 1000 -c 10 ${ready} --json --script ${first})
+		twexpectrc("first reading ${mode} at ${turn} ms" "${rc}" 0 "${output}")
+		twnumber(exitts "\"event\":\"exit\",\"ts\":([0-9]+)" "${output}")
+		math(EXPR latency "${exitts} - ${turn} * 1000")
+		twexpect("first reading ${mode} at ${turn} ms" "latency (usecs)" "${latency}" LESS_EQUAL 1000)
+		if (latency GREATER maxlatency)
+			set(maxlatency ${latency})
+		endif()
+	endforeach()
+	message("first reading ${mode}: ${trials} trials, latency at most ${maxlatency} usecs (virtual clock)")
+endforeach()
+
+twscript(realtime "0 connect 1 0x06A3 0x0BD4" "300 axis 1 0 0" "1300 axis 1 0 0.5")
+foreach (run 1 2 3)
+	twrun(output rc -s -e -p 10000 -c 20 ${ready} --realtime --json --script ${realtime})
+	twexpectrc("realtime ${run}" "${rc}" 0 "${output}")
+	twnumber(exitts "\"event\":\"exit\",\"ts\":([0-9]+)" "${output}")
+	math(EXPR latency "${exitts} - 1300000")
+	twexpect("realtime ${run}" "latency (usecs)" "${latency}" LESS_EQUAL 5000)
+	message("realtime ${run}: exit ${latency} usecs after the reading")
+endforeach()
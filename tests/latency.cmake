@@ -0,0 +1,66 @@
+# Detection latency benchmark (README "Detection latency benchmark"): time from the start of a turn of the Trimwheel
+# to the program's exit with RC=0, as distribution over many trials per cycle mode
+#
+# Each trial is a run of its own: the Trimwheel is there at start and turned (0 to 0.5 within 300 ms, a reading
+# every 8 ms) at a random millisecond of the 3rd second, so at a random point of the cycle. The exit time is the
+# "ts" of the exit event of "--json" (virtual clock of the fake GameInput, the same code path as on Windows).
+# The limits are the percentiles of the README's table with some room, a mode beyond them fails the test.
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+set(trials 1000)
+set(seed 14)
+
+# Next number of the generator (the LCG of ANSI C), sets <var> to a number 0...<range> - 1
+macro(twrandom var range)
+	math(EXPR seed "(${seed} * 1103515245 + 12345) % 2147483648")
+	math(EXPR ${var} "(${seed} / 65536) % ${range}")
+endmacro()
+
+# Sets <var> to the <percent> percentile (msecs) of the sorted list <usecs>
+function(twpercentile var usecs percent)
+	list(LENGTH usecs count)
+	math(EXPR index "(${count} * ${percent} + 99) / 100 - 1")
+	list(GET usecs ${index} value)
+	math(EXPR msecs "${value} / 1000")
+	set(${var} ${msecs} PARENT_SCOPE)
+endfunction()
+
+# mode, its max. p50, p99 (msecs)
+set(modes
+	"-p 1000"			1300	1700
+	"-d"				1300	1700
+	"-p 10"				100		100
+	"--adaptive"		100		100
+	"-e"				80		80
+	"-e --dispatcher"	80		80
+)
+message("| mode | trials | p50 (ms) | p90 (ms) | p99 (ms) | max (ms) |")
+message("|---|---|---|---|---|---|")
+while (modes)
+	list(POP_FRONT modes mode maxp50 maxp99)
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	set(latencies "")
+	foreach (trial RANGE 1 ${trials})
+		twrandom(turn 1000)
+		math(EXPR turn "${turn} + 2000")
+		twscript(trial "0 connect 1 0x06A3 0x0BD4" "${turn} ramp 1 0 0 0.5 300 8")
+		twrun(output rc -s -c 10 --json ${args} --script ${trial})
+		twexpectrc("${mode} turn at ${turn} ms" "${rc}" 0 "${output}")
+		twnumber(exitts "\"event\":\"exit\",\"ts\":([0-9]+)" "${output}")
+		math(EXPR latency "${exitts} - ${turn} * 1000")
+# Fixed width for the sort
+		string(LENGTH "${latency}" length)
+		math(EXPR pad "10 - ${length}")
+		string(REPEAT "0" ${pad} zeros)
+		list(APPEND latencies "${zeros}${latency}")
+	endforeach()
+	list(SORT latencies)
+	twpercentile(p50 "${latencies}" 50)
+	twpercentile(p90 "${latencies}" 90)
+	twpercentile(p99 "${latencies}" 99)
+	twpercentile(max "${latencies}" 100)
+	message("| ${mode} | ${trials} | ${p50} | ${p90} | ${p99} | ${max} |")
+	twexpect("${mode}" "p50 latency" "${p50}" LESS_EQUAL ${maxp50})
+	twexpect("${mode}" "p99 latency" "${p99}" LESS_EQUAL ${maxp99})
+endwhile()
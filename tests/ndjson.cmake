@@ -0,0 +1,79 @@
+# NDJSON output "--json" (twjson.h): every line of stdout has to be one of the documented objects
+#
+# * session : the Trimwheel detected at start, unplugged, plugged in again and turned, with "--stats": the events
+#   detected, disappeared, appeared and turned in this order, then the stats, memory and schedule lines, the exit event
+#   with RC=0 as the last line
+# * timeout : the Trimwheel plugged in late and never turned: appeared, timeout, exit with RC=1
+# * none : no Trimwheel: timeout, exit with RC=16
+# Each event's ts (microseconds of the virtual clock) may not go back, no message of the program may be on stdout.
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+# Check the lines of <json> against the schema, sets <eventsvar> to the list of the event names in order
+function(twjsoncheck what json rc eventsvar)
+	string(REGEX REPLACE "\n$" "" json "${json}")
+	string(REPLACE ";" "," json "${json}")
+	string(REPLACE "\n" ";" lines "${json}")
+	set(number "[0-9]+")
+	set(axis "-?[0-9]+\\.[0-9]+")
+	set(events "")
+	set(lastts 0)
+	set(exitline FALSE)
+	foreach (line IN LISTS lines)
+		if (exitline)
+			message(SEND_ERROR "${what}: line after the exit event: ${line}")
+		endif()
+# A failed MATCHES clears CMAKE_MATCH_<n>, so one regex per branch
+		if (line MATCHES "^{\"event\":\"(detected|appeared|disappeared|turned|timeout|exit)\",\"ts\":(${number}),\"axis\":${axis}(,\"rc\":(${number}))?}$")
+			list(APPEND events ${CMAKE_MATCH_1})
+			if (CMAKE_MATCH_2 LESS lastts)
+				message(SEND_ERROR "${what}: ts ${CMAKE_MATCH_2} before the one of the previous event (${lastts}): ${line}")
+			endif()
+			set(lastts ${CMAKE_MATCH_2})
+			if (CMAKE_MATCH_1 STREQUAL "exit")
+				set(exitline TRUE)
+				if (NOT CMAKE_MATCH_4 STREQUAL rc)
+					message(SEND_ERROR "${what}: rc of the exit event '${CMAKE_MATCH_4}', program's RC ${rc}")
+				endif()
+			elseif (CMAKE_MATCH_3)
+				message(SEND_ERROR "${what}: rc in another event than exit: ${line}")
+			endif()
+		elseif (line MATCHES "^{\"event\":\"stats\",\"phase\":\"[^\"]+\",\"samples\":${number},\"mean_ns\":${number},\"p50_ns\":${number},\"p99_ns\":${number},\"max_ns\":${number}}$")
+			list(APPEND events stats)
+		elseif (line MATCHES "^{\"event\":\"memory\",\"controllers\":${number},\"registry_bytes\":${number},\"state_bytes\":${number}}$")
+			list(APPEND events memory)
+		elseif (line MATCHES "^{\"event\":\"schedule\",\"cycles\":${number},\"wakeups\":${number},\"wakeups_per_hour\":${number},\"overruns\":${number},\"bursts\":${number}}$")
+			list(APPEND events schedule)
+		else()
+			message(SEND_ERROR "${what}: line not in the schema: ${line}")
+		endif()
+	endforeach()
+	if (NOT exitline)
+		message(SEND_ERROR "${what}: no exit event")
+	endif()
+	list(REMOVE_DUPLICATES events)
+	set(${eventsvar} "${events}" PARENT_SCOPE)
+endfunction()
+
+# Run with "--json", stdout (the events) apart from stderr (the messages)
+function(twjsonrun what expectedrc expectedevents)
+	execute_process(COMMAND ${PROGRAM} ${ARGN} --json OUTPUT_VARIABLE json ERROR_VARIABLE messages RESULT_VARIABLE rc
+		TIMEOUT 600)
+	twexpectrc("${what}" "${rc}" ${expectedrc} "${json}${messages}")
+	twjsoncheck("${what}" "${json}" "${rc}" events)
+	if (NOT events STREQUAL expectedevents)
+		message(SEND_ERROR "${what}: events ${events}, expected ${expectedevents}, output:\n${json}")
+	endif()
+	message("${what}: ${events}")
+endfunction()
+
+twscript(session "0 connect 1 0x06A3 0x0BD4" "3000 disconnect 1" "5500 connect 1 0x06A3 0x0BD4"
+	"8000 ramp 1 0 0 0.5 300 10")
+twjsonrun("session" 0 "detected;disappeared;appeared;turned;stats;memory;schedule;exit"
+	-c 20 --stats --script ${session})
+
+twscript(timeout "2500 connect 1 0x06A3 0x0BD4")
+twjsonrun("timeout" 1 "appeared;timeout;exit" -c 5 --script ${timeout})
+
+twscript(none "0 connect 2 0x044F 0xB10A 8 32")
+twjsonrun("none" 16 "timeout;exit" -c 5 --script ${none})
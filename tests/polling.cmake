@@ -0,0 +1,50 @@
+# Polling benchmark (README "Polling benchmark"): wakeups per hour and detection latency of each cycle policy
+#
+# * plug : Trimwheel plugged in after 30 s and turned 3.3 s later, for the detection latency
+# * empty : an hour without Trimwheel, for the wakeups per hour
+# * turn : Trimwheel there at start and turned after 20 s, with --adaptive in every mode: 2 bursts,
+#   one for its appearance and one for the turn (the turned reading may reach us by the cycle loop, the drain
+#   or a reading callback, the poll policy must see it in any case)
+# The limits are the numbers of the README's table with some room, a policy beyond them fails the test
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+twscript(plug "30000 connect 1 0x06A3 0x0BD4" "33337 ramp 1 0 0 0.5 100 10")
+twscript(empty "# no controller")
+twscript(turn "0 connect 1 0x06A3 0x0BD4" "20000 ramp 1 0 0 0.5 100 10")
+
+# policy, its max. wakeups per hour without Trimwheel, its max. detection latency in msecs
+set(policies
+	"-p 1000"		3600	700
+	"-p 10"			360000	10
+	"--adaptive"	400		700
+	"-e -p 1000"	3600	1
+	"-e --adaptive"	400		1
+	"--dispatcher -p 1000"	3600	700
+	"--dispatcher --adaptive"	400		10
+	"-d --adaptive"	400		700
+)
+message("| policy | wakeups/hour without Trimwheel | detection latency (ms) |")
+message("|---|---|---|")
+while (policies)
+	list(POP_FRONT policies policy maxwakeups maxlatency)
+	separate_arguments(args UNIX_COMMAND "${policy}")
+	twrun(output rc -s -c 3600 ${args} --script ${empty})
+	twexpectrc("${policy} without Trimwheel" "${rc}" 16 "${output}")
+	twnumber(wakeups "wakeups: [0-9]+ \\(([0-9]+) per hour\\)" "${output}")
+	twexpect("${policy}" "wakeups per hour" "${wakeups}" LESS_EQUAL ${maxwakeups})
+	twrun(output rc -s -c 3600 ${args} --script ${plug})
+	twexpectrc("${policy} with Trimwheel" "${rc}" 0 "${output}")
+	twnumber(latency "Detection latency: ([0-9.]+) msecs" "${output}")
+	twexpect("${policy}" "detection latency" "${latency}" LESS_EQUAL ${maxlatency})
+	message("| ${policy} | ${wakeups} | ${latency} |")
+endwhile()
+
+foreach (mode "" "-d" "-e" "-e -d" "--dispatcher" "-e --dispatcher")
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	twrun(output rc -s --adaptive ${args} --script ${turn})
+	twexpectrc("--adaptive ${mode} turned" "${rc}" 0 "${output}")
+	twnumber(bursts "Adaptive polling: ([0-9]+) bursts" "${output}")
+	twexpect("--adaptive ${mode} turned" "bursts" "${bursts}" EQUAL 2)
+	message("--adaptive ${mode}: ${bursts} bursts")
+endforeach()
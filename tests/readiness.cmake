@@ -0,0 +1,140 @@
+# Readiness detector (README "Readiness detector"): false positives and false negatives of the default --ready on
+# generated sessions of the Trimwheel, in the cycle modes that see the readings differently
+#
+# * spike : the wheel never turned, one spike of 1...19 LSB that falls back to 0 after 1...100 ms (among them the
+#   spike of 0.15 for 100 ms, shortly after connecting), with 1 LSB jitter around it
+# * noise : the wheel never turned, 1 LSB jitter only
+# * turn : a turn of 13...63 LSB (at least the default travel of 0.1) within 0.2...3.2 s, every second one turned
+#   back to exactly 0 after 1...5 s (a turn and back within a cycle of 1 s is a spike to the cycle loop)
+# * held : the wheel set to a position by one reading and left there
+# An LSB is 2/255, the step of the Trimwheel's 8 bit axis. The sessions are the same on each run (fixed seed)
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+set(sessions 40)
+set(seed 2024)
+
+# Next number of the generator (the LCG of ANSI C), sets <var> to a number 0...<range> - 1
+macro(twrandom var range)
+	math(EXPR seed "(${seed} * 1103515245 + 12345) % 2147483648")
+	math(EXPR ${var} "(${seed} / 65536) % ${range}")
+endmacro()
+
+# Sets <var> to <lsbs> LSB of the axis as decimal number (6 digits)
+function(twlsb var lsbs)
+	set(sign "")
+	if (lsbs LESS 0)
+		set(sign "-")
+		math(EXPR lsbs "-(${lsbs})")
+	endif()
+	math(EXPR micro "(${lsbs} * 2000000 + 127) / 255")
+	math(EXPR whole "${micro} / 1000000")
+	math(EXPR fraction "${micro} % 1000000 + 1000000")
+	string(SUBSTRING "${fraction}" 1 6 fraction)
+	set(${var} "${sign}${whole}.${fraction}" PARENT_SCOPE)
+endfunction()
+
+# Lines of 1 LSB jitter every 0.5...2.5 s for 60 s to <var>
+macro(twjitter var)
+	twlsb(lsb 1)
+	set(${var} "")
+	set(t 1000)
+	while (t LESS 60000)
+		twrandom(onoff 2)
+		if (onoff)
+			list(APPEND ${var} "${t} axis 1 0 ${lsb}")
+		else()
+			list(APPEND ${var} "${t} axis 1 0 0")
+		endif()
+		twrandom(pause 2000)
+		math(EXPR t "${t} + 500 + ${pause}")
+	endwhile()
+endmacro()
+
+set(negatives "")
+set(positives "")
+
+# The spike and the held position of the review
+twscript(spike0 "0 connect 1 0x06A3 0x0BD4" "5000 axis 1 0 0.15" "5100 axis 1 0 0.0")
+list(APPEND negatives ${spike0})
+twscript(held0 "0 connect 1 0x06A3 0x0BD4" "5000 axis 1 0 0.3")
+list(APPEND positives ${held0})
+
+foreach (i RANGE 1 ${sessions})
+# Spike: the jitter's readings during the spike would end it early, they are left out
+	twjitter(lines)
+	twrandom(at 50000)
+	math(EXPR at "${at} + 5000")
+	twrandom(height 19)
+	math(EXPR height "${height} + 1")
+	twrandom(negative 2)
+	if (negative)
+		math(EXPR height "-${height}")
+	endif()
+	twlsb(height ${height})
+	twrandom(length 100)
+	math(EXPR end "${at} + 1 + ${length}")
+	set(spike "0 connect 1 0x06A3 0x0BD4")
+	foreach (line IN LISTS lines)
+		string(REGEX MATCH "^[0-9]+" t "${line}")
+		if (t LESS at OR t GREATER end)
+			list(APPEND spike "${line}")
+		endif()
+	endforeach()
+	list(APPEND spike "${at} axis 1 0 ${height}" "${end} axis 1 0 0")
+	list(SORT spike COMPARE NATURAL)
+	twscript(spike${i} ${spike})
+	list(APPEND negatives ${spike${i}})
+
+	twjitter(lines)
+	twscript(noise${i} "0 connect 1 0x06A3 0x0BD4" ${lines})
+	list(APPEND negatives ${noise${i}})
+
+	twrandom(at 40000)
+	math(EXPR at "${at} + 5000")
+	twrandom(lsbs 51)
+	math(EXPR lsbs "${lsbs} + 13")
+	twlsb(to ${lsbs})
+	twrandom(duration 3000)
+	math(EXPR duration "${duration} + 200")
+	set(turn "0 connect 1 0x06A3 0x0BD4" "${at} ramp 1 0 0 ${to} ${duration} 8")
+	math(EXPR back "${i} % 2")
+	if (back)
+		twrandom(pause 4000)
+		math(EXPR at "${at} + ${duration} + 1000 + ${pause}")
+		list(APPEND turn "${at} ramp 1 0 ${to} 0 ${duration} 8")
+	endif()
+	twscript(turn${i} ${turn})
+	list(APPEND positives ${turn${i}})
+endforeach()
+
+list(LENGTH negatives nnegatives)
+list(LENGTH positives npositives)
+message("| mode | false positives | false negatives |")
+message("|---|---|---|")
+foreach (mode "-p 1000" "-p 10" "-d" "-e" "-e --dispatcher")
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	set(falsepositives 0)
+	foreach (script IN LISTS negatives)
+		twrun(output rc -s -c 60 ${args} --script ${script})
+		if (rc EQUAL 0)
+			math(EXPR falsepositives "${falsepositives} + 1")
+			message("${mode}: false positive ${script}")
+		elseif (NOT rc EQUAL 1)
+			twexpectrc("${mode} ${script}" "${rc}" 1 "${output}")
+		endif()
+	endforeach()
+	set(falsenegatives 0)
+	foreach (script IN LISTS positives)
+		twrun(output rc -s -c 60 ${args} --script ${script})
+		if (rc EQUAL 1)
+			math(EXPR falsenegatives "${falsenegatives} + 1")
+			message("${mode}: false negative ${script}")
+		elseif (NOT rc EQUAL 0)
+			twexpectrc("${mode} ${script}" "${rc}" 0 "${output}")
+		endif()
+	endforeach()
+	message("| ${mode} | ${falsepositives}/${nnegatives} | ${falsenegatives}/${npositives} |")
+	twexpect("${mode}" "false positives" "${falsepositives}" EQUAL 0)
+	twexpect("${mode}" "false negatives" "${falsenegatives}" EQUAL 0)
+endforeach()
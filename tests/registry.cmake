@@ -0,0 +1,77 @@
+# Device registry (devregistry.h): 10000 connects and disconnects of 64 controllers, one every 10 ms at random
+#
+# With "-a" all controllers are registered: at the end the registry has to hold exactly the connected ones (its
+# "memory" line of "--json"), the Trimwheel among them is turned at the end and has to be found (RC=0), and the
+# device callback (phase "Dispatch" of "--stats", one connect or disconnect per cycle) has to stay within the limit.
+# Without "-a", none of the 64 other controllers may enter the registry (watch-list, only the Trimwheel)
+#
+# Replug: the Trimwheel and another controller get a new device object 100 times each without the old object's
+# disconnect (fake's "replug"), the registry finds the stale entry by its device id (devreg_findid) and holds each
+# controller once at the end, with and without "-a"
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+set(devices 64)
+set(events 10000)
+set(seed 3)
+
+# Next number of the generator (the LCG of ANSI C), sets <var> to a number 0...<range> - 1
+macro(twrandom var range)
+	math(EXPR seed "(${seed} * 1103515245 + 12345) % 2147483648")
+	math(EXPR ${var} "(${seed} / 65536) % ${range}")
+endmacro()
+
+set(lines "0 connect 0 0x06A3 0x0BD4")
+set(connected 0)
+foreach (event RANGE 1 ${events})
+	twrandom(device ${devices})
+	math(EXPR device "${device} + 1")
+	math(EXPR t "${event} * 10")
+	if (state${device})
+		list(APPEND lines "${t} disconnect ${device}")
+		set(state${device} FALSE)
+		math(EXPR connected "${connected} - 1")
+	else()
+		list(APPEND lines "${t} connect ${device} 0x044F 0xB10A 8 32")
+		set(state${device} TRUE)
+		math(EXPR connected "${connected} + 1")
+	endif()
+endforeach()
+math(EXPR t "(${events} + 10) * 10")
+list(APPEND lines "${t} ramp 0 0 0 0.5 300 10")
+twscript(churn ${lines})
+# Controllers connected at the end: the others and the Trimwheel
+math(EXPR connected "${connected} + 1")
+
+twrun(output rc -s -a -p 10 -c 110 --stats --json --script ${churn})
+twexpectrc("-a churn" "${rc}" 0 "${output}")
+twnumber(controllers "\"controllers\":([0-9]+)" "${output}")
+twexpect("-a churn" "registered controllers" "${controllers}" EQUAL ${connected})
+twnumber(p50 "\"phase\":\"Dispatch\",[^\n]*\"p50_ns\":([0-9]+)" "${output}")
+twnumber(p99 "\"phase\":\"Dispatch\",[^\n]*\"p99_ns\":([0-9]+)" "${output}")
+message("-a churn: ${events} events, ${controllers} controllers registered at the end, Dispatch p50 ${p50} ns, p99 ${p99} ns")
+twexpect("-a churn" "Dispatch p99 (ns)" "${p99}" LESS_EQUAL 50000)
+
+twrun(output rc -s -p 10 -c 110 --stats --json --script ${churn})
+twexpectrc("churn" "${rc}" 0 "${output}")
+twnumber(controllers "\"controllers\":([0-9]+)" "${output}")
+twexpect("churn" "registered controllers" "${controllers}" EQUAL 1)
+message("churn: ${controllers} controllers registered at the end")
+
+set(lines "0 connect 0 0x06A3 0x0BD4" "0 connect 1 0x044F 0xB10A 8 32")
+foreach (replug RANGE 1 100)
+	math(EXPR t "${replug} * 10 + 5")
+	list(APPEND lines "${t} replug 0" "${t} replug 1")
+endforeach()
+list(APPEND lines "1100 ramp 0 0 0 0.5 300 10")
+twscript(replugs ${lines})
+foreach (mode "-a:2" ":1")
+	string(REPLACE ":" ";" mode "${mode}")
+	list(GET mode 0 option)
+	list(GET mode 1 expected)
+	twrun(output rc -s ${option} -p 10 -c 150 --stats --json --script ${replugs})
+	twexpectrc("replug ${option}" "${rc}" 0 "${output}")
+	twnumber(controllers "\"controllers\":([0-9]+)" "${output}")
+	twexpect("replug ${option}" "registered controllers" "${controllers}" EQUAL ${expected})
+	message("replug ${option}: 200 new device objects, ${controllers} controllers registered at the end")
+endforeach()
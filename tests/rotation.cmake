@@ -0,0 +1,91 @@
+# Rotation telemetry "--rotation" (twrotation.h) with drain mode "-d": the Trimwheel turned at 0.5 rev/s with a
+# reading every ms (1 kHz), its axis running through its range once per revolution and wrapping at the ends
+#
+# * unit range : GameInput's axis 0...1 with the defaults of "--rotation", a revolution from the connect's 0, then 10
+#   more: 11.00 turned and net, 10 wraps, peak 0.50 rev/s
+# * forward : an axis of -1...1 ("--rotation=2,2"), half a revolution from 0, then 30 revolutions: 30.50 turned and
+#   net, 30 wraps, peak 0.50 rev/s, every reading evaluated
+# * backward : half a revolution forward up to the end of the range, then 10 backward: 10.50 turned, net -9.50,
+#   9 wraps (the first backward revolution starts at the end)
+# * memory : the state of a run of 3 secs (1000 readings) and of a minute (61000) has the same size
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+# Script of the Trimwheel turned by <revolutions> (negative: backward), 2000 readings per revolution, 0.001 units apart
+# also across the end of the range
+function(twrotationscript name revolutions)
+	set(lines "history 2000" "0 connect 1 0x06A3 0x0BD4" "1000 ramp 1 0 0 0.9995 1000 1")
+	if (revolutions LESS 0)
+		math(EXPR revolutions "- ${revolutions}")
+		set(from 0.9995)
+		set(to -0.9995)
+	else()
+		set(from -0.9995)
+		set(to 0.9995)
+	endif()
+	foreach (revolution RANGE 1 ${revolutions})
+		math(EXPR t "${revolution} * 2000 + 1")
+		list(APPEND lines "${t} ramp 1 0 ${from} ${to} 1999 1")
+	endforeach()
+	twscript(${name} ${lines})
+	set(${name} ${${name}} PARENT_SCOPE)
+endfunction()
+
+# Run with option <rotation> and parse the summary line "Trimwheel rotation: ..." into <prefix>_turned, _net, _wraps,
+# _peak, _readings, _bytes
+function(twrotationrun prefix rotation secs script)
+	twrun(output rc -s -d ${rotation} -c ${secs} --script ${script})
+	twexpectrc("${prefix}" "${rc}" 0 "${output}")
+	if (NOT output MATCHES "Trimwheel rotation: ([0-9.]+) revolutions turned \\(net ([-+0-9.]+), ([0-9]+) wraps\\), peak ([0-9.]+) rev/s \\(([0-9]+) readings, ([0-9]+) bytes of state\\)")
+		message(SEND_ERROR "${prefix}: no rotation summary, output:\n${output}")
+		return()
+	endif()
+	message("${prefix}: ${CMAKE_MATCH_0}")
+	set(index 1)
+	foreach (field turned net wraps peak readings bytes)
+		set(${prefix}_${field} ${CMAKE_MATCH_${index}} PARENT_SCOPE)
+		math(EXPR index "${index} + 1")
+	endforeach()
+endfunction()
+
+# 0...1: each revolution a ramp of 2000 readings over the whole range, the first one from the connect's 0
+set(lines "history 2000" "0 connect 1 0x06A3 0x0BD4")
+foreach (revolution RANGE 0 10)
+	math(EXPR t "${revolution} * 2000 + 1000")
+	list(APPEND lines "${t} ramp 1 0 0 0.9995 1999 1")
+endforeach()
+twscript(unitrange ${lines})
+twrotationrun(unitrange --rotation 24 ${unitrange})
+foreach (check "turned:11.00" "net:+11.00" "wraps:10" "peak:0.50")
+	string(REPLACE ":" ";" check "${check}")
+	list(GET check 0 field)
+	list(GET check 1 expected)
+	if (NOT unitrange_${field} STREQUAL expected)
+		message(SEND_ERROR "unit range: ${field} ${unitrange_${field}}, expected ${expected}")
+	endif()
+endforeach()
+
+twrotationscript(forward 30)
+twrotationrun(forward --rotation=2,2 63 ${forward})
+foreach (check "turned:30.50" "net:+30.50" "wraps:30" "peak:0.50" "readings:61002")
+	string(REPLACE ":" ";" check "${check}")
+	list(GET check 0 field)
+	list(GET check 1 expected)
+	if (NOT forward_${field} STREQUAL expected)
+		message(SEND_ERROR "forward: ${field} ${forward_${field}}, expected ${expected}")
+	endif()
+endforeach()
+
+twrotationscript(backward -10)
+twrotationrun(backward --rotation=2,2 23 ${backward})
+foreach (check "turned:10.50" "net:-9.50" "wraps:9")
+	string(REPLACE ":" ";" check "${check}")
+	list(GET check 0 field)
+	list(GET check 1 expected)
+	if (NOT backward_${field} STREQUAL expected)
+		message(SEND_ERROR "backward: ${field} ${backward_${field}}, expected ${expected}")
+	endif()
+endforeach()
+
+twrotationrun(short --rotation=2,2 3 ${forward})
+twexpect("memory" "bytes of state after ${forward_readings} readings" "${forward_bytes}" EQUAL ${short_bytes})
@@ -0,0 +1,65 @@
+# Scaling benchmark (README "Scaling benchmark"): cycle cost and memory of the cycle loop over 1...4096 synthetic
+# controllers, each count with and without -a and with three sizes of controller (axes, buttons)
+#
+# Each run is a minute of 1 s cycles with a new reading of every controller each 100 ms ("synth" and "noise" of
+# the fake GameInput). Its "--stats --json" lines (cycle timing, memory) are collected in scaling.ndjson of the
+# test's folder; the test fails if
+# * the cycle's p50 is above the limit of its controller size: <base> + controllers * <per controller> (ns),
+#   the measured costs times 3, so a loop that gets slower per controller or more than linear fails
+# * the memory of the device registry isn't the same for all counts (a fixed pool, nothing per controller on the heap)
+# * with -a, not all controllers are in the registry
+# SCALINGPROGRAM is the program built for 4096 controllers (see CMakeLists.txt)
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+if (NOT SCALINGPROGRAM)
+	message(FATAL_ERROR "Call with -DSCALINGPROGRAM=<SaitekTrimwheel with 4096 controllers>")
+endif()
+set(PROGRAM ${SCALINGPROGRAM})
+
+# axes, buttons, limit of the cycle's p50: base, per controller without -a, per controller with -a (ns)
+set(sizes
+	1	0		50000	40	1000
+	8	32		50000	40	1000
+	16	128		50000	40	1500
+)
+set(report ${WORKDIR}/scaling.ndjson)
+file(WRITE ${report} "")
+set(memory "")
+message("| axes | buttons | controllers | -a | cycle p50 (us) | limit (us) | registry + state (bytes) |")
+message("|---|---|---|---|---|---|---|")
+while (sizes)
+	list(POP_FRONT sizes axes buttons base percontroller percontrollerall)
+	foreach (count 1 8 64 512 4096)
+		twscript(synth "0 synth 0 ${count} 0x044F 0xB10A ${axes} ${buttons}" "0 noise 0 ${count} 60000 100")
+		foreach (all "" "-a")
+			set(what "${count} controllers (${axes} axes, ${buttons} buttons) ${all}")
+			twrun(output rc -s ${all} -c 60 --stats --json --script ${synth})
+			twexpectrc("${what}" "${rc}" 16 "${output}")
+			string(REGEX MATCHALL "{\"event\":\"(stats\",\"phase\":\"cycle|memory)[^\n]*" lines "${output}")
+# The lines of the run with its parameters in front
+			foreach (line IN LISTS lines)
+				string(SUBSTRING "${line}" 1 -1 line)
+				file(APPEND ${report} "{\"axes\":${axes},\"buttons\":${buttons},\"count\":${count},\"all\":\"${all}\",${line}\n")
+			endforeach()
+			twnumber(p50 "\"phase\":\"cycle\",[^\n]*\"p50_ns\":([0-9]+)" "${output}")
+			twnumber(controllers "\"controllers\":([0-9]+)" "${output}")
+			twnumber(bytes "\"registry_bytes\":([0-9]+)" "${output}")
+			twnumber(statebytes "\"state_bytes\":([0-9]+)" "${output}")
+			if (all)
+				math(EXPR limit "${base} + ${count} * ${percontrollerall}")
+				twexpect("${what}" "controllers in the registry" "${controllers}" EQUAL ${count})
+			else()
+				math(EXPR limit "${base} + ${count} * ${percontroller}")
+			endif()
+			twexpect("${what}" "cycle p50 (ns)" "${p50}" LESS_EQUAL ${limit})
+			math(EXPR bytes "${bytes} + ${statebytes}")
+			if (memory STREQUAL "")
+				set(memory ${bytes})
+			endif()
+			twexpect("${what}" "registry + state bytes" "${bytes}" EQUAL ${memory})
+			math(EXPR p50us "${p50} / 1000")
+			math(EXPR limitus "${limit} / 1000")
+			message("| ${axes} | ${buttons} | ${count} | ${all} | ${p50us} | ${limitus} | ${bytes} |")
+		endforeach()
+	endforeach()
+endwhile()
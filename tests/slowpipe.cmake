@@ -0,0 +1,120 @@
+# Console logger (twlog.h) on a slow pipe: the detection latency with stdout piped into a reader that takes only
+# 64 KB per sec (twslowreader, like a slow console or boot script), with the default policy (wait for room in the
+# message buffer) and with "-o" (drop new messages), against a run with stdout read at once
+#
+# The runs are at real speed (--realtime), so the waits of the logger show in the timestamps: the Trimwheel and 64
+# other controllers with a new reading every 10 ms, read with "-a -p 10" and printed (about 900 KB per sec, so each
+# cycle's messages wait for room), so the message buffer is full when the Trimwheel is turned after 2 seconds. The
+# program's "Detection latency" is up to its end, the pending messages written at the end (the same for both
+# policies) are taken off: what is left is the latency up to the decision on the RC.
+#
+# * unredirected : stdout read at once, the latency of the cycles only
+# * blocking : has to wait for the reader, no message dropped, its latency is above the one of "-o"
+# * -o : the latency stays flat (at most 20 ms above the unredirected run), messages are dropped and counted
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+if (NOT SLOWREADER)
+	message(FATAL_ERROR "Call with -DSLOWREADER=<twslowreader>")
+endif()
+
+set(trials 3)
+set(readerrate 65536)
+set(seed 9)
+
+# Next number of the generator (the LCG of ANSI C), sets <var> to a number 0...<range> - 1
+macro(twrandom var range)
+	math(EXPR seed "(${seed} * 1103515245 + 12345) % 2147483648")
+	math(EXPR ${var} "(${seed} / 65536) % ${range}")
+endmacro()
+
+# Run the program with stdout into the reader (or read at once with <rate> 0), sets <outvar> to the output of both,
+# <rcvar> to the program's return code
+function(twpiperun outvar rcvar rate)
+	if (rate)
+		execute_process(COMMAND ${PROGRAM} ${ARGN} COMMAND ${SLOWREADER} ${rate} OUTPUT_VARIABLE output
+			ERROR_VARIABLE output RESULTS_VARIABLE rcs TIMEOUT 600)
+		list(GET rcs 0 rc)
+	else()
+		twrun(output rc ${ARGN})
+	endif()
+	set(${outvar} "${output}" PARENT_SCOPE)
+	set(${rcvar} "${rc}" PARENT_SCOPE)
+endfunction()
+
+# Median of a list of numbers
+function(twmedian var values)
+	list(SORT values COMPARE NATURAL)
+	list(LENGTH values count)
+	math(EXPR index "${count} / 2")
+	list(GET values ${index} value)
+	set(${var} ${value} PARENT_SCOPE)
+endfunction()
+
+set(turns "")
+foreach (trial RANGE 1 ${trials})
+	twrandom(turn 100)
+	math(EXPR turn "${turn} + 2000")
+	list(APPEND turns ${turn})
+endforeach()
+
+# mode, program option ("-": none), rate of the reader (0: read at once)
+set(modes
+	"unredirected"	"-"		0
+	"blocking"		"-"		${readerrate}
+	"drop"			"-o"	${readerrate}
+)
+message("| stdout | policy | trials | detection latency p50 (ms) | pending messages at the end (ms) | dropped |")
+message("|---|---|---|---|---|---|")
+while (modes)
+	list(POP_FRONT modes mode option rate)
+	if (option STREQUAL "-")
+		set(option "")
+	endif()
+	set(latencies "")
+	set(pendings "")
+	set(drops "")
+	foreach (turn IN LISTS turns)
+		twscript(trial "0 connect 0 0x06A3 0x0BD4" "0 synth 1 64 0x044F 0xB10A 8 32" "0 noise 1 64 60000 10"
+			"${turn} ramp 0 0 0 0.5 300 8")
+		twpiperun(output rc "${rate}" -a -p 10 -c 4 --realtime ${option} --script ${trial})
+		twexpectrc("${mode} turn at ${turn} ms" "${rc}" 0 "${output}")
+# msecs with 3 decimals, as usecs
+		twnumber(total "Detection latency: ([0-9]+\\.[0-9][0-9][0-9]) msecs" "${output}")
+		twnumber(pending "Detection latency: [0-9.]+ msecs \\(turned reading to program end, ([0-9]+\\.[0-9][0-9][0-9]) msecs" "${output}")
+		string(REPLACE "." "" total "${total}")
+		string(REPLACE "." "" pending "${pending}")
+		math(EXPR latency "(${total} - ${pending}) / 1000")
+		math(EXPR pending "${pending} / 1000")
+		list(APPEND latencies ${latency})
+		list(APPEND pendings ${pending})
+		if (output MATCHES "Console messages dropped \\(-o\\): ([0-9]+)")
+			list(APPEND drops ${CMAKE_MATCH_1})
+		else()
+			list(APPEND drops 0)
+		endif()
+	endforeach()
+	twmedian(latency "${latencies}")
+	twmedian(pending "${pendings}")
+	twmedian(dropped "${drops}")
+	set(${mode}latency ${latency})
+	set(stdout "pipe of ${rate} bytes/s")
+	if (NOT rate)
+		set(stdout "read at once")
+	endif()
+	set(policy "wait")
+	if (option)
+		set(policy "drop (-o)")
+	endif()
+	message("| ${stdout} | ${policy} | ${trials} | ${latency} | ${pending} | ${dropped} |")
+	foreach (drop IN LISTS drops)
+		if (mode STREQUAL "drop")
+			twexpect("${mode}" "dropped messages" "${drop}" GREATER 0)
+		else()
+			twexpect("${mode}" "dropped messages" "${drop}" EQUAL 0)
+		endif()
+	endforeach()
+endwhile()
+
+math(EXPR flatlimit "${unredirectedlatency} + 20")
+twexpect("drop" "detection latency p50 (ms)" "${droplatency}" LESS_EQUAL ${flatlimit})
+twexpect("blocking" "detection latency p50 (ms)" "${blockinglatency}" GREATER ${droplatency})
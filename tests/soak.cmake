@@ -0,0 +1,60 @@
+# Soak run (README "Soak run"): hours of hotplug churn on the virtual clock, the heap has to stay flat
+#
+# * soak : "--soak" in each cycle mode, RC=1 (the Trimwheel is there all the time but never turned), the program's
+#   own checks passed and the heap of each hour within 8 KiB of the first hour's (a leaked reading or device per
+#   cycle would be hundreds of KiB an hour; the program's own check allows 64 KiB over the whole run)
+# * churn : the Trimwheel unplugged and plugged in again 500 times, then turned: RC=0, it has to be found again
+#   after each reconnect and its readings still have to reach the detector
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+# mode, hours of the soak run
+set(modes
+	"-a"					24
+	"-a -d"					24
+	"-a -e"					24
+	"-a -e --dispatcher"	24
+	"-a -p 100"				4
+)
+while (modes)
+	list(POP_FRONT modes mode hours)
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	twrun(output rc -s ${args} --soak=${hours})
+	twexpectrc("${mode} --soak=${hours}" "${rc}" 1 "${output}")
+	if (NOT output MATCHES "Soak checks passed: ${hours} hours")
+		message(SEND_ERROR "${mode} --soak=${hours}: the program's checks failed, output:\n${output}")
+	endif()
+# The table: hour, cycles, mean cycle, max controllers, heap bytes
+	string(REGEX MATCHALL "\n +[0-9]+ +[0-9]+ +[0-9.]+ +[0-9]+ +[0-9]+" rows "${output}")
+	list(LENGTH rows nrows)
+	twexpect("${mode} --soak=${hours}" "hours in the table" "${nrows}" EQUAL ${hours})
+	set(firstheap "")
+	set(maxgrowth 0)
+	foreach (row IN LISTS rows)
+		string(REGEX MATCH "([0-9]+)$" heap "${row}")
+		if (firstheap STREQUAL "")
+			set(firstheap ${heap})
+		endif()
+		math(EXPR growth "${heap} - ${firstheap}")
+		if (growth GREATER maxgrowth)
+			set(maxgrowth ${growth})
+		endif()
+	endforeach()
+	message("${mode} --soak=${hours}: heap ${firstheap} bytes in the first hour, grew by at most ${maxgrowth} bytes")
+	twexpect("${mode} --soak=${hours}" "heap growth" "${maxgrowth}" LESS_EQUAL 8192)
+endwhile()
+
+set(lines "0 connect 1 0x06A3 0x0BD4" "0 connect 2 0x044F 0xB10A")
+foreach (i RANGE 1 500)
+	math(EXPR t "${i} * 2000")
+	math(EXPR t2 "${t} + 1000")
+	list(APPEND lines "${t} disconnect 1" "${t2} connect 1 0x06A3 0x0BD4")
+endforeach()
+list(APPEND lines "1005000 ramp 1 0 0 0.5 1000 10")
+twscript(churn ${lines})
+foreach (mode "-a" "-a -d" "-a -e" "-a -e --dispatcher")
+	separate_arguments(args UNIX_COMMAND "${mode}")
+	twrun(output rc -s -c 1100 ${args} --script ${churn})
+	twexpectrc("${mode} churn" "${rc}" 0 "${output}")
+	message("${mode} churn: RC=${rc}")
+endforeach()
@@ -0,0 +1,51 @@
+# Controller state (devregistry.h): axes, switches and buttons read with the controller's own counts into its rows,
+# the buttons packed as bitset
+#
+# * bits : a controller with 16 axes, 128 buttons and 8 switches (the registry's maximum), buttons pressed on both
+#   sides of the 64 bit word boundary and released again, the cycle messages of "-a" (the changed fields of
+#   a controller) have to show exactly them
+# * clip : a controller with more than the maximum (20 axes, 200 buttons) is read up to it, nothing beyond is shown
+# * bench : "state extraction" of "--stats" (one reading of 16 axes, 128 buttons and 8 switches into its row) of
+#   255 such controllers with a new reading each 100 ms, its p50 within the limit
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+twscript(bits "0 connect 2 0x044F 0xB10A 16 128 8"
+	"1500 button 2 0 1" "1500 button 2 63 1" "1500 button 2 64 1" "1500 button 2 127 1"
+	"1500 axis 2 15 -0.5" "1500 switch 2 7 3"
+	"2500 button 2 63 0" "2500 button 2 64 0")
+twrun(output rc -a -c 4 --script ${bits})
+twexpectrc("bits" "${rc}" 16 "${output}")
+string(REGEX MATCHALL "Controller 0 [^\n]*" states "${output}")
+list(LENGTH states count)
+twexpect("bits" "changed states" "${count}" EQUAL 3)
+if (count EQUAL 3)
+	list(GET states 1 pressed)
+	list(GET states 2 released)
+	if (NOT pressed MATCHES "15:-0.500000 Switches - [0-6:0 ]*7:3 Buttons - 0 63 64 127 $")
+		message(SEND_ERROR "bits: wrong state after the press: ${pressed}")
+	endif()
+	if (NOT released MATCHES "Buttons - 0 127 $")
+		message(SEND_ERROR "bits: wrong state after the release: ${released}")
+	endif()
+	message("bits: ${pressed}")
+endif()
+
+twscript(clip "0 connect 2 0x044F 0xB10A 20 200 2"
+	"1500 button 2 127 1" "1500 button 2 150 1" "1500 axis 2 15 0.25" "1500 axis 2 17 0.75")
+twrun(output rc -a -c 3 --script ${clip})
+twexpectrc("clip" "${rc}" 16 "${output}")
+# Only the changed fields are shown (here the axes and buttons)
+string(REGEX MATCH "15:0.250000 Buttons - 127 \n" clipped "${output}")
+if (NOT clipped)
+	message(SEND_ERROR "clip: state not read up to 16 axes and 128 buttons, output:\n${output}")
+endif()
+
+twscript(bench "0 synth 0 255 0x044F 0xB10A 16 128 8" "0 noise 0 255 60000 100")
+twrun(output rc -s -a -c 60 --stats --json --script ${bench})
+twexpectrc("bench" "${rc}" 16 "${output}")
+twnumber(samples "\"phase\":\"state extraction\",\"samples\":([0-9]+)" "${output}")
+twnumber(p50 "\"phase\":\"state extraction\",[^\n]*\"p50_ns\":([0-9]+)" "${output}")
+message("bench: state extraction p50 ${p50} ns (${samples} readings)")
+twexpect("bench" "state extraction samples" "${samples}" GREATER_EQUAL 15000)
+twexpect("bench" "state extraction p50 (ns)" "${p50}" LESS_EQUAL 1500)
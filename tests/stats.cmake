@@ -0,0 +1,60 @@
+# Phase timing "--stats[=N]" (twstats.h) of a run: the Trimwheel and 16 other controllers with a new reading each
+# 100 ms, read with "-a", a minute of 1 s cycles with a report every 20 secs
+#
+# * reports : the two periodic reports and the one at exit
+# * samples : one sample of cycle, Dispatch and _kbhit drain per cycle, one GetCurrentReading per controller and cycle
+#   (the last report), p50 <= p99 <= max in each row
+# * overhead : one read of the clock per phase boundary (twstats.h), its calibrated "ns per sample" within 100 ns,
+#   and its share of the busy part of the cycles (the cycle phase, without the wait) below 50%: the fake's GameInput
+#   calls cost about 0.1 usecs each, so a 17 controller cycle is busy for 2...4 usecs only, of which the 36 boundaries
+#   are 15...35% (with a real GameInput's calls, the cycle is longer and the share smaller), its share of the run time
+#   (cycles * period) is shown
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+set(cycles 60)
+set(controllers 17)
+twscript(run "0 connect 0 0x06A3 0x0BD4" "0 synth 1 16 0x044F 0xB10A 8 32" "0 noise 1 16 60000 100")
+twrun(output rc -s -a -c ${cycles} --stats=20 --script ${run})
+twexpectrc("run" "${rc}" 1 "${output}")
+
+string(REGEX MATCHALL "Phase timing \\(usecs\\)" reports "${output}")
+list(LENGTH reports count)
+twexpect("reports" "phase timing reports" "${count}" EQUAL 3)
+
+# The last report: its rows "<phase> <samples> <p50> <p99> <max>"
+string(FIND "${output}" "Phase timing (usecs)" last REVERSE)
+string(SUBSTRING "${output}" ${last} -1 report)
+math(EXPR readings "${cycles} * ${controllers}")
+foreach (phase "cycle:${cycles}" "Dispatch:${cycles}" "_kbhit drain:${cycles}" "GetCurrentReading:${readings}")
+	string(REPLACE ":" ";" phase "${phase}")
+	list(GET phase 0 name)
+	list(GET phase 1 expected)
+	twnumber(samples "\n  ${name} +([0-9]+) " "${report}")
+	twexpect("samples" "${name} samples" "${samples}" EQUAL ${expected})
+endforeach()
+string(REGEX MATCHALL "\n  [^\n]+ +[0-9]+ +[0-9.]+ +[0-9.]+ +[0-9.]+" rows "${report}")
+set(allsamples 0)
+foreach (row IN LISTS rows)
+	string(REGEX MATCH "([^ ]+) +([0-9]+) +([0-9.]+) +([0-9.]+) +([0-9.]+)$" row "${row}")
+	set(samples ${CMAKE_MATCH_2})
+	set(p50 ${CMAKE_MATCH_3})
+	set(p99 ${CMAKE_MATCH_4})
+	set(max ${CMAKE_MATCH_5})
+	math(EXPR allsamples "${allsamples} + ${samples}")
+# usecs with one decimal, compared as integers of 0.1 usecs
+	string(REPLACE "." "" p50 "${p50}")
+	string(REPLACE "." "" p99 "${p99}")
+	string(REPLACE "." "" max "${max}")
+	if ((p50 GREATER p99) OR (p99 GREATER max))
+		message(SEND_ERROR "samples: p50, p99 and max out of order: ${row}")
+	endif()
+endforeach()
+
+twnumber(boundaryns "Instrumentation: ([0-9]+) ns per sample" "${report}")
+twnumber(busyshare "Instrumentation: [0-9]+ ns per sample, ([0-9]+)\\.[0-9]+% of the cycle time" "${report}")
+# Share of the run time in ppm: samples * ns per sample * 1000000 / (cycles * 1 s)
+math(EXPR share "${allsamples} * ${boundaryns} / (${cycles} * 1000)")
+message("overhead: ${allsamples} samples of ${boundaryns} ns, ${busyshare}% of the busy cycle time, ${share} ppm of the run time")
+twexpect("overhead" "ns per phase boundary" "${boundaryns}" LESS 100)
+twexpect("overhead" "share of the busy cycle time (%)" "${busyshare}" LESS 50)
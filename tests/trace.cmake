@@ -0,0 +1,161 @@
+# Trace and replay (twtrace.h): two sessions recorded with "-d -T" into one trace file, decoded by twtracedecode
+# (-DDECODER=<twtracedecode>) and replayed by "--replay"; a large trace of twtracegen (-DTRACEGEN=<twtracegen>) for
+# the decoder's rate
+#
+# * record : session 1 the Trimwheel and a joystick, the wheel unplugged, plugged in again and turned (RC=0),
+#   session 2 the Trimwheel never turned (RC=1), appended to the same file
+# * decode : the CSV has a line per record, the start and exit events of both sessions with their RC, the callbacks
+#   of the connects and the disconnect at their virtual time, every reading of the ramp in order up to its end value
+# * replay : each session gives its recorded RC ("same RC as recorded"), session 1 with a readiness rule it doesn't
+#   pass ends with RC=20, so does "--session all" with a mismatch of session 1 in its summary; 1000 sessions (the two
+#   recorded 500 times) replayed by "--session all" at least 1000 per sec (about 2000 here, best of 3 runs), a replay
+#   "--realtime" takes the session's real time
+# * decode rate : 1048576 records (64 MB) decoded to a CSV file, the best of 3 runs at least 200 MB/s (300...450 MB/s
+#   here); the CSV written to a full disk (/dev/full, if there is one) ends with RC=12
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+if (NOT DECODER OR NOT TRACEGEN)
+	message(FATAL_ERROR "Call with -DDECODER=<twtracedecode> -DTRACEGEN=<twtracegen>")
+endif()
+
+set(trace ${WORKDIR}/trace.trc)
+file(REMOVE ${trace})
+twscript(turned "0 connect 1 0x06A3 0x0BD4" "0 connect 2 0x044F 0xB10A 8 32" "3000 disconnect 1"
+	"5500 connect 1 0x06A3 0x0BD4" "8000 ramp 1 0 0 0.5 300 10")
+twrun(output rc -s -d -c 20 -T ${trace} --script ${turned})
+twexpectrc("record session 1" "${rc}" 0 "${output}")
+twscript(notturned "0 connect 1 0x06A3 0x0BD4")
+twrun(output rc -s -d -c 5 -T ${trace} --script ${notturned})
+twexpectrc("record session 2" "${rc}" 1 "${output}")
+
+execute_process(COMMAND ${DECODER} ${trace} ${WORKDIR}/trace.csv OUTPUT_VARIABLE output ERROR_VARIABLE output
+	RESULT_VARIABLE rc)
+twexpectrc("decode" "${rc}" 0 "${output}")
+twnumber(records "([0-9]+) records decoded" "${output}")
+file(STRINGS ${WORKDIR}/trace.csv lines)
+list(POP_FRONT lines header)
+list(LENGTH lines count)
+twexpect("decode" "CSV lines" "${count}" EQUAL ${records})
+# Columns: record,kind,event,device,vid,pid,sequence,timestamp,nbraxes,nbrbutt,axis0,...
+set(starts 0)
+set(exits "")
+set(connects 0)
+set(disconnectts "")
+set(turns 0)
+set(session 0)
+set(lastsequence 0)
+set(lastaxis "")
+foreach (line IN LISTS lines)
+	string(REPLACE "," ";" fields "${line}")
+	list(GET fields 1 kind)
+	list(GET fields 2 event)
+	list(GET fields 6 sequence)
+	list(GET fields 7 timestamp)
+	if ((kind STREQUAL "event") AND (event STREQUAL "start"))
+		math(EXPR starts "${starts} + 1")
+		set(session ${starts})
+	elseif ((kind STREQUAL "event") AND (event STREQUAL "exit"))
+		list(APPEND exits ${sequence})
+	elseif ((kind STREQUAL "event") AND (event STREQUAL "turned"))
+		math(EXPR turns "${turns} + 1")
+	elseif ((kind STREQUAL "callback") AND (event STREQUAL "connected"))
+		math(EXPR connects "${connects} + 1")
+	elseif ((kind STREQUAL "callback") AND (event STREQUAL "disconnected"))
+		set(disconnectts ${timestamp})
+	elseif ((kind STREQUAL "reading") AND (session EQUAL 1))
+# The Trimwheel's readings after the reconnect: one per sequence number, in order
+		if (NOT sequence EQUAL 1)
+			math(EXPR expected "${lastsequence} + 1")
+			twexpect("decode" "reading sequence" "${sequence}" EQUAL ${expected})
+		endif()
+		set(lastsequence ${sequence})
+		list(GET fields 10 lastaxis)
+	endif()
+endforeach()
+twexpect("decode" "sessions" "${starts}" EQUAL 2)
+if (NOT exits STREQUAL "0;1")
+	message(SEND_ERROR "decode: RCs of the exit events ${exits}, expected 0;1")
+endif()
+twexpect("decode" "turned events" "${turns}" EQUAL 1)
+twexpect("decode" "connect callbacks" "${connects}" EQUAL 4)
+twexpect("decode" "timestamp of the disconnect callback" "${disconnectts}" EQUAL 3000000)
+twexpect("decode" "last reading's sequence number" "${lastsequence}" EQUAL 32)
+if (NOT lastaxis STREQUAL "0.500000")
+	message(SEND_ERROR "decode: axis of the last reading ${lastaxis}, expected 0.500000")
+endif()
+message("decode: ${records} records, exits with RC ${exits}, readings up to sequence ${lastsequence} (axis ${lastaxis})")
+
+foreach (session 1 2)
+	twrun(output rc -s -d --replay ${trace} --session ${session})
+	math(EXPR index "${session} - 1")
+	list(GET exits ${index} expected)
+	twexpectrc("replay session ${session}" "${rc}" ${expected} "${output}")
+	if (NOT output MATCHES "Replay: same RC as recorded")
+		message(SEND_ERROR "replay session ${session}: RC not checked, output:\n${output}")
+	endif()
+endforeach()
+twrun(output rc -s -d --ready=0.01,2,0.9 --replay ${trace} --session 1)
+twexpectrc("replay session 1 with travel 0.9" "${rc}" 20 "${output}")
+
+# All sessions in one run: the summary of their RCs, one mismatch with the stricter readiness rule
+twrun(output rc -s -d --ready=0.01,2,0.9 --replay ${trace} --session all)
+twexpectrc("replay all with travel 0.9" "${rc}" 20 "${output}")
+if (NOT output MATCHES "Replay: session 1 ended with another RC than recorded\n"
+	OR NOT output MATCHES "Replay: 1 of 2 sessions with the same RC as recorded, 1 mismatches")
+	message(SEND_ERROR "replay all with travel 0.9: no mismatch of session 1 in the summary, output:\n${output}")
+endif()
+
+# 1000 sessions, the two above 500 times, replayed by "--session all"
+set(manytrace ${WORKDIR}/many.trc)
+file(REMOVE ${manytrace})
+foreach (recording RANGE 1 500)
+	twrun(output rc -s -d -c 20 -T ${manytrace} --script ${turned})
+	twrun(output rc -s -d -c 5 -T ${manytrace} --script ${notturned})
+endforeach()
+set(best 0)
+foreach (run 1 2 3)
+	twrun(output rc -s -d --replay ${manytrace} --session all)
+	twexpectrc("replay all" "${rc}" 0 "${output}")
+	twnumber(same "Replay: ([0-9]+) of 1000 sessions with the same RC as recorded, 0 mismatches" "${output}")
+	twexpect("replay all" "sessions with the same RC" "${same}" EQUAL 1000)
+	twnumber(rate "Replay of all 1000 sessions from trace [^\n]* \\(([0-9]+) per sec\\)" "${output}")
+	if (rate GREATER best)
+		set(best ${rate})
+	endif()
+endforeach()
+message("replay: 1000 sessions by --session all, best of 3 runs ${best} per sec")
+twexpect("replay all" "sessions per sec" "${best}" GREATER_EQUAL 1000)
+file(REMOVE ${manytrace})
+
+string(TIMESTAMP start "%s")
+twrun(output rc -s -d --realtime --replay ${trace} --session 2)
+string(TIMESTAMP end "%s")
+math(EXPR secs "${end} - ${start}")
+twexpectrc("replay session 2 --realtime" "${rc}" 1 "${output}")
+message("realtime: session 2 (5 secs recorded) replayed in ${secs} secs")
+twexpect("realtime" "secs of the replay" "${secs}" GREATER_EQUAL 4)
+
+set(bigtrace ${WORKDIR}/big.trc)
+execute_process(COMMAND ${TRACEGEN} ${bigtrace} 1048576 OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE rc)
+twexpectrc("decode rate: generate" "${rc}" 0 "${output}")
+set(best 0)
+foreach (run 1 2 3)
+	execute_process(COMMAND ${DECODER} ${bigtrace} ${WORKDIR}/big.csv OUTPUT_VARIABLE output ERROR_VARIABLE output
+		RESULT_VARIABLE rc)
+	twexpectrc("decode rate" "${rc}" 0 "${output}")
+	twnumber(records "([0-9]+) records decoded" "${output}")
+	twexpect("decode rate" "records" "${records}" EQUAL 1048576)
+	twnumber(rate "records decoded \\([^)]*, ([0-9]+) MB/s\\)" "${output}")
+	if (rate GREATER best)
+		set(best ${rate})
+	endif()
+endforeach()
+file(SIZE ${WORKDIR}/big.csv csvsize)
+message("decode rate: ${records} records (64 MB), CSV of ${csvsize} bytes, best of 3 runs ${best} MB/s")
+twexpect("decode rate" "MB/s" "${best}" GREATER_EQUAL 200)
+if (EXISTS /dev/full)
+	execute_process(COMMAND ${DECODER} ${bigtrace} /dev/full OUTPUT_VARIABLE output ERROR_VARIABLE output
+		RESULT_VARIABLE rc)
+	twexpectrc("decode to a full disk" "${rc}" 12 "${output}")
+endif()
+file(REMOVE ${bigtrace} ${WORKDIR}/big.csv)
@@ -0,0 +1,99 @@
+/*
+	twdispatchstress.cpp
+
+	Stress test of the dispatcher thread's handover ring (twdispatch.h), published under MIT license like the main program.
+
+	A producer thread hands over millions of events by twdispatch_post(), the main thread takes them by
+	twdispatch_take() and twdispatch_waituntil(), the same roles as the dispatcher thread and the cycle loop.
+	Built with -fsanitize=thread and a ring of 16 events (tests/CMakeLists.txt), so the producer keeps running into
+	the full ring and ThreadSanitizer watches both handshakes (wake event, room event) and the records themselves.
+	Each event carries its number in the timestamp: the main thread checks that all arrive, once and in order.
+
+	Parameter: number of events (default 2000000)
+	RC=0 all events in order, RC=1 an event missing, duplicate or out of order, RC=2 setup failed
+*/
+
+#include "GameInput.h"
+#include "twclock.h"
+#include "twdispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <thread>
+
+// The main thread's request to give up (an event out of order) and the producer's end
+static std::atomic<bool> producerquit(false);
+static std::atomic<bool> producerdone(false);
+
+static void producer(uint64_t events)
+{
+	Twdispatchevent event = {};
+	event.kind = TWDISPATCH_READING;
+	for (uint64_t number = 0; (number < events) && !producerquit.load(); ++number) {
+		event.timestamp = number;
+		twdispatch_post(event);
+	}
+	producerdone.store(true);
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t events = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+	IGameInput* gameinput;
+	IGameInputDispatcher* dispatcher;
+	if (FAILED(GameInputCreate(&gameinput)) || FAILED(gameinput->CreateDispatcher(&dispatcher))) {
+		printf("GameInput setup failed\n");
+		return 2;
+	}
+	twclock_init(gameinput, TWCLOCK_GRANULARITY);
+	if (!twdispatch_start(dispatcher, TWDISPATCH_QUOTADFLT)) {
+		printf("Dispatcher thread can't be started\n");
+		return 2;
+	}
+	std::thread producerthread(producer, events);
+// Take most events as the cycle start does, every 64th one after a wait as between two cycles
+	uint64_t expected = 0;
+	uint64_t waits = 0;
+	int rc = 0;
+	while (expected < events) {
+		Twdispatchevent event;
+		if (((expected % 64) == 0) || !twdispatch_take(&event)) {
+			++waits;
+			twdispatch_waituntil(twclock_timestamp() + 1000);
+			if (!twdispatch_take(&event)) {
+				continue;
+			}
+		}
+		if (event.timestamp != expected) {
+			printf("Event %llu taken, expected %llu\n", (unsigned long long)event.timestamp, (unsigned long long)expected);
+			rc = 1;
+			break;
+		}
+		++expected;
+	}
+// After a break, the producer may be blocked on the full ring: tell it to end and keep taking events until it has,
+// so the join doesn't hang and it posts nothing after twdispatch_stop() has closed the ring's events. The rest is
+// taken too, twdispatch_stop() would release the readings of the events left, these carry none
+	if (rc != 0) {
+		producerquit.store(true);
+		Twdispatchevent event;
+		while (!producerdone.load()) {
+			if (!twdispatch_take(&event)) {
+				twdispatch_waituntil(twclock_timestamp() + 1000);
+			}
+		}
+		while (twdispatch_take(&event)) {
+		}
+	}
+	producerthread.join();
+	twdispatch_stop();
+	twclock_exit();
+	printf("%llu events in order of %llu handed over, %llu waits of the consumer, %llu waits on a full ring (%i records)\n",
+		(unsigned long long)expected, (unsigned long long)twdispatch_posted(), (unsigned long long)waits,
+		(unsigned long long)twdispatch_fullwaits(), TWDISPATCH_RING);
+	dispatcher->Release();
+	gameinput->Release();
+	return rc;
+}
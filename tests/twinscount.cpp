@@ -0,0 +1,97 @@
+/*
+	twinscount.cpp
+
+	Instruction counter for the debug level benchmark (tests/debuglevels.cmake), published under MIT license like
+	the main program. Linux only, for machines without "perf stat" or valgrind (or a virtual machine without
+	performance counters).
+
+	Runs a program under ptrace, single-stepping all its threads, and counts the user mode instructions they
+	execute (a system call counts as one), like the "Ir" of callgrind. Slow (about 100000 instructions per second in
+	a virtual machine), so only for short runs; the cost of a program's cycle is the difference between two runs of
+	different length. With "--fromthread", the program runs at full speed until it starts its first thread and is
+	counted from there: SaitekTrimwheel starts its console writer thread (twlog.h) just before the cycle loop, so
+	the loader and the setup aren't stepped.
+
+	Parameter: [--fromthread] the program and its arguments
+	Output on stderr: "Instructions: <count>"
+	RC=the program's RC, RC=125 the program couldn't be started
+*/
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[])
+{
+	int first = 1;
+	bool counting = true;
+	if ((argc > 1) && (strcmp(argv[1], "--fromthread") == 0)) {
+		first = 2;
+		counting = false;
+	}
+	if (argc <= first) {
+		fprintf(stderr, "Usage: twinscount [--fromthread] <program> [<arguments>]\n");
+		return 125;
+	}
+	pid_t child = fork();
+	if (child < 0) {
+		perror("fork");
+		return 125;
+	}
+	if (child == 0) {
+		ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+		raise(SIGSTOP);
+		execv(argv[first], &argv[first]);
+		perror("execv");
+		_exit(125);
+	}
+	int status;
+	if (waitpid(child, &status, 0) != child) {
+		perror("waitpid");
+		return 125;
+	}
+// The threads of the program are traced too, the program dies with us
+	ptrace(PTRACE_SETOPTIONS, child, NULL, (void*)(PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL));
+	ptrace(counting ? PTRACE_SINGLESTEP : PTRACE_CONT, child, NULL, NULL);
+
+	uint64_t instructions = 0;
+	int retcode = 125;
+	for (;;) {
+		pid_t thread = waitpid(-1, &status, __WALL);
+		if (thread < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;								// ECHILD: all threads have ended
+		}
+		if (WIFEXITED(status) || WIFSIGNALED(status)) {
+			if (thread == child) {
+				retcode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+			}
+			continue;
+		}
+		if (!WIFSTOPPED(status)) {
+			continue;
+		}
+// A step (or the exec, the stop of a new thread, a clone event), or a signal for the program: pass it on
+		int signal = WSTOPSIG(status);
+		if ((signal == SIGTRAP) && ((status >> 16) == PTRACE_EVENT_CLONE)) {
+			counting = true;
+		}
+		if ((signal == SIGTRAP) && ((status >> 16) == 0) && counting) {
+			++instructions;
+			signal = 0;
+		} else if ((signal == SIGTRAP) || (signal == SIGSTOP)) {
+			signal = 0;
+		}
+		ptrace(counting ? PTRACE_SINGLESTEP : PTRACE_CONT, thread, NULL, (void*)(intptr_t)signal);
+	}
+	fprintf(stderr, "Instructions: %llu\n", (unsigned long long)instructions);
+	return retcode;
+}
@@ -0,0 +1,109 @@
+/*
+	twjsontest.cpp
+
+	Benchmark and format check of the NDJSON emitter (twjson.h), published under MIT license like the main program.
+
+	stdout is redirected to the file twjsontest.ndjson in the working folder, then twjson_open() keeps it for the
+	events as the program does. Millions of events are written by twjson_event() (all event names in turn, every 8th
+	an exit event with RC), the rate has to be at least the limit. Then the axis values twjson_event() formats by
+	hand: ties of the rounding, negative zero, small and large values, NaN/infinite and random floats. The file is
+	read back: each line has to be the event written, in the format of twjson.h (the axis as "%f" of printf), and in
+	order.
+
+	Parameter: number of events (default 1000000), events per second at least (default 1000000)
+	RC=0 all checks passed, RC=1 a check failed, RC=2 setup failed
+*/
+
+#include "twjson.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <limits>
+#include <vector>
+
+static const char* eventnames[8] = { "detected", "appeared", "disappeared", "turned", "timeout", "detected", "turned",
+	"exit" };
+
+int main(int argc, char* argv[])
+{
+	uint64_t events = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+	double minrate = (argc > 2) ? strtod(argv[2], NULL) : 1000000;
+	if ((freopen("twjsontest.ndjson", "w", stdout) == NULL) || !twjson_open()) {
+		fprintf(stderr, "Event file can't be opened\n");
+		return 2;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t number = 0; number < events; ++number) {
+		uint32_t kind = number % 8;
+		twjson_event(eventnames[kind], number, (float)kind / 8, (kind == 7) ? (int)(number % 32) : -1);
+	}
+	auto end = std::chrono::steady_clock::now();
+	double secs = std::chrono::duration<double>(end - start).count();
+	double rate = events / secs;
+
+// Axis values: ties of the rounding to 6 decimals (1/128, 3/128), around zero, limits of the hand-made format,
+// values snprintf writes, random floats in -2...2 and random bit patterns
+	std::vector<float> axes = { 1.0f / 128, 3.0f / 128, -1.0f / 128, 0.0f, -0.0f, -1e-7f, 1e-7f, 5e-7f, -5e-7f, 0.9999995f,
+		-0.9999995f, 1.0f, -1.0f, 123456.789f, 999999.9f, 1e11f, 9.9e11f, 1e12f, -3e20f,
+		std::numeric_limits<float>::max(), std::numeric_limits<float>::denorm_min(),
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+		std::numeric_limits<float>::quiet_NaN() };
+	uint32_t seed = 11;
+	for (int value = 0; value < 100000; ++value) {
+		seed = seed * 1103515245 + 12345;
+		axes.push_back(((seed >> 8) & 0xFFFFFF) / 4194304.0f - 2.0f);
+		seed = seed * 1103515245 + 12345;
+		float pattern;
+		memcpy(&pattern, &seed, sizeof(pattern));
+		axes.push_back(pattern);
+	}
+	for (float axis : axes) {
+		twjson_event("turned", 0, axis, -1);
+	}
+
+	int failed = 0;
+	FILE* ndjson = fopen("twjsontest.ndjson", "r");
+	if (ndjson == NULL) {
+		fprintf(stderr, "Event file can't be read\n");
+		return 2;
+	}
+	char line[256];
+	char expected[256];
+	uint64_t number = 0;
+	while (fgets(line, sizeof(line), ndjson) != NULL) {
+		uint32_t kind = number % 8;
+		if (number >= events) {
+			snprintf(expected, sizeof(expected), "{\"event\":\"turned\",\"ts\":0,\"axis\":%f}\n",
+				(number - events < axes.size()) ? axes[number - events] : 0.0f);
+		} else if (kind == 7) {
+			snprintf(expected, sizeof(expected), "{\"event\":\"exit\",\"ts\":%llu,\"axis\":0.875000,\"rc\":%d}\n",
+				(unsigned long long)number, (int)(number % 32));
+		} else {
+			snprintf(expected, sizeof(expected), "{\"event\":\"%s\",\"ts\":%llu,\"axis\":%f}\n", eventnames[kind],
+				(unsigned long long)number, (float)kind / 8);
+		}
+		if (strcmp(line, expected) != 0) {
+			fprintf(stderr, "Check failed: line %llu is %s, expected %s", (unsigned long long)number + 1, line, expected);
+			failed = 1;
+			break;
+		}
+		++number;
+	}
+	fclose(ndjson);
+	if (!failed && (number != events + axes.size())) {
+		fprintf(stderr, "Check failed: %llu lines, expected %llu\n", (unsigned long long)number,
+			(unsigned long long)(events + axes.size()));
+		failed = 1;
+	}
+	fprintf(stderr, "%llu events in %.3f secs: %.0f events per sec (at least %.0f)\n", (unsigned long long)events, secs,
+		rate, minrate);
+	if (rate < minrate) {
+		fprintf(stderr, "Check failed: emitter slower than %.0f events per sec\n", minrate);
+		failed = 1;
+	}
+	return failed;
+}
@@ -0,0 +1,188 @@
+/*
+	twprofilestest.cpp
+
+	Test and benchmark of the compile-time device profiles (twprofiles.h), published under MIT license like the main program.
+
+	On the fake GameInput, a Trimwheel and a joystick (8 axes, 32 buttons, 1 switch) are connected and the wheel is
+	turned (script twprofilestest.tws, written to the working folder). Checked are:
+	* twprofile_find: profile id 1 for the Trimwheel's VID/PID, 0 for everything else
+	* twprofile_mincounts: a Trimwheel reporting no axis is still read with the profile's one
+	* the state handlers of the table: the Trimwheel's readings, walked in order, make its handler "ready" with the
+	  deciding axis value, the joystick's generic handler never is
+	Benchmark: millions of calls on the Trimwheel's current reading through its specialized handler, against the
+	generic path it replaced (all counts from the device information, a runtime VID/PID compare, then the detector).
+
+	Parameter: number of benchmark calls per path (default 5000000)
+	RC=0 all checks passed, RC=1 a check failed, RC=2 setup failed
+*/
+
+#include "GameInput.h"
+#include "devregistry.h"
+#include "twprofiles.h"
+#include "fakegameinput.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <initializer_list>
+
+// The registry is too big for the stack
+static Devregistry registry;
+
+static int failed = 0;
+
+static void check(bool condition, const char* what)
+{
+	if (!condition) {
+		printf("Check failed: %s\n", what);
+		failed = 1;
+	}
+}
+
+// Device callback: register every connected controller with its description, as deviceChangeCallback does
+static void CALLBACK devicecallback(GameInputCallbackToken callbackToken, void* context, IGameInputDevice* device,
+	uint64_t timestamp, GameInputDeviceStatus currentStatus, GameInputDeviceStatus previousStatus)
+{
+	Devregistry* reg = (Devregistry*)context;
+	if (!(currentStatus & GameInputDeviceConnected)) {
+		return;
+	}
+	const GameInputDeviceInfo* info = device->GetDeviceInfo();
+	Devregentry* entry = devreg_insert(reg, device, &info->deviceId);
+	if (entry == NULL) {
+		return;
+	}
+	entry->desc.valid = true;
+	entry->desc.vid = info->vendorId;
+	entry->desc.pid = info->productId;
+	entry->desc.nbraxes = info->controllerAxisCount;
+	entry->desc.nbrbutt = info->controllerButtonCount;
+	entry->desc.nbrswch = info->controllerSwitchCount;
+	entry->desc.profile = twprofile_find(Twknownprofiles(), entry->desc.vid, entry->desc.pid);
+	entry->desc.watched = (entry->desc.profile != 0);
+	twprofile_mincounts(Twknownprofiles(), &entry->desc);
+	devreg_resetstate(reg, entry);
+}
+
+// Nanoseconds per call of 'function' over 'calls' calls
+template <typename Function>
+static double nspercall(uint64_t calls, Function function)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t call = 0; call < calls; ++call) {
+		function();
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / calls;
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t calls = (argc > 1) ? strtoull(argv[1], NULL, 10) : 5000000;
+
+// Profile lookup and counts, no GameInput needed
+	check(twprofile_find(Twknownprofiles(), 0x06A3, 0x0BD4) == 1, "profile id of the Trimwheel is 1");
+	check(twprofile_find(Twknownprofiles(), 0x06A3, 0x0BD5) == 0, "no profile for another PID");
+	check(twprofile_find(Twknownprofiles(), 0x044F, 0x0BD4) == 0, "no profile for another VID");
+	Devregdesc desc = {};
+	desc.profile = 1;
+	twprofile_mincounts(Twknownprofiles(), &desc);
+	check(desc.nbraxes == SaitekTrimwheelProfile::axiscount, "Trimwheel profile raises its axis count");
+	desc = {};
+	desc.nbraxes = 8;
+	twprofile_mincounts(Twknownprofiles(), &desc);
+	check(desc.nbraxes == 8, "generic controller keeps its axis count");
+
+// Trimwheel and joystick, the wheel turned within 300 ms (31 readings, all in the history)
+	FILE* script = fopen("twprofilestest.tws", "w");
+	if (script == NULL) {
+		printf("Script can't be written\n");
+		return 2;
+	}
+	fprintf(script, "0 connect 1 0x06A3 0x0BD4\n0 connect 2 0x044F 0xB10A 8 32 1\n100 ramp 1 0 0 0.5 300 10\n200 axis 2 0 0.75\n");
+	fclose(script);
+	IGameInput* gameinput;
+	if (!fakegi_loadscript("twprofilestest.tws") || FAILED(GameInputCreate(&gameinput))) {
+		printf("GameInput setup failed\n");
+		return 2;
+	}
+	devreg_init(&registry);
+	GameInputCallbackToken token;
+	gameinput->RegisterDeviceCallback(0, GameInputKindController, GameInputDeviceAnyStatus, GameInputBlockingEnumeration,
+		&registry, devicecallback, &token);
+	Sleep(1000);
+	Devregentry* trimwheel = NULL;
+	Devregentry* joystick = NULL;
+	for (uint32_t devctr = 0; devctr < registry.deviceCount; ++devctr) {
+		Devregentry* entry = registry.devices[devctr];
+		if (entry->desc.profile == 1) {
+			trimwheel = entry;
+		} else {
+			joystick = entry;
+		}
+	}
+	if ((trimwheel == NULL) || (joystick == NULL)) {
+		printf("Controllers not registered\n");
+		return 2;
+	}
+	check(joystick->desc.profile == 0, "joystick has no profile");
+
+// Walk each controller's history from its oldest reading through the handler of its profile
+	uint32_t readycount = 0;
+	float readyval = 0;
+	for (Devregentry* entry : { trimwheel, joystick }) {
+		Twstatehandler handler = Twhandlertable<Twknownprofiles>::handlers[entry->desc.profile];
+		IGameInputReading* reading = NULL;
+		IGameInputReading* previous = NULL;
+		gameinput->GetCurrentReading(GameInputKindController, entry->device, &reading);
+		while (SUCCEEDED(gameinput->GetPreviousReading(reading, GameInputKindController, entry->device, &previous))) {
+			reading->Release();
+			reading = previous;
+		}
+		uint32_t readings = 0;
+		bool ready = false;
+		while (reading != NULL) {
+			++readings;
+			float value = 0;
+			if (handler(reading, &registry, entry, &value) && !ready) {
+				ready = true;
+				readyval = value;
+				readycount += (entry == trimwheel) ? 1 : 100;
+			}
+			IGameInputReading* next = NULL;
+			gameinput->GetNextReading(reading, GameInputKindController, entry->device, &next);
+			reading->Release();
+			reading = next;
+		}
+		printf("Controller %04X:%04X: profile %u, %u readings, %s\n", entry->desc.vid, entry->desc.pid,
+			entry->desc.profile, readings, ready ? "ready" : "not ready");
+	}
+	check(readycount == 1, "only the Trimwheel's handler gets ready");
+	check((readyval >= 0.1f) && (readyval <= 0.5f), "ready value is the Trimwheel's axis after a turn of 0.1 or more");
+	check(joystick->axes[0] == 0.75f, "generic handler reads the joystick's axes");
+
+// Benchmark on the Trimwheel's current reading: the detector ignores it after the first call, both paths the same
+	IGameInputReading* current = NULL;
+	gameinput->GetCurrentReading(GameInputKindController, trimwheel->device, &current);
+	float value = 0;
+	double specialized = nspercall(calls, [&]() {
+		Twhandlertable<Twknownprofiles>::handlers[trimwheel->desc.profile](current, &registry, trimwheel, &value);
+	});
+	double generic = nspercall(calls, [&]() {
+		twgeneric_readstate(current, &registry, trimwheel, &value);
+		if ((trimwheel->desc.vid == 0x06A3) && (trimwheel->desc.pid == 0x0BD4)) {
+			twready_update(&trimwheel->ready, current->GetSequenceNumber(GameInputKindController),
+				current->GetTimestamp(), trimwheel->axes[0]);
+		}
+	});
+	current->Release();
+	printf("%llu readings per path: specialized %.1f ns, generic %.1f ns per reading\n", (unsigned long long)calls,
+		specialized, generic);
+// Loose bound, both are mostly the fake's reading calls: the specialized path must not be the slower one
+	check(specialized <= generic * 1.5, "specialized handler not slower than the generic path");
+	devreg_remove(&registry, trimwheel->device);
+	devreg_remove(&registry, joystick->device);
+	gameinput->Release();
+	return failed;
+}
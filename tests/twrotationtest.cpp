@@ -0,0 +1,153 @@
+/*
+	twrotationtest.cpp
+
+	Test and benchmark of the rotation telemetry (twrotation.h), published under MIT license like the main program.
+
+	Axis values of a wheel turned at a constant speed are fed in at 1 kHz, wrapped into the axis range as the
+	Trimwheel sends them: GameInput's 0...1 with the defaults, -1...1 (range 2.0) for most checks. Checked are:
+	* 0...1 with the default range and units: 2.5 revolutions from 0, 2 wraps, the rate 2 rev/s, 1.2 back with a wrap
+	* forward 3.25 revolutions from -1: net and turned rotation 3.25, 3 wraps, the rate the wheel's 2 rev/s
+	* backward 1.5 revolutions: net -1.5, turned 1.5, two wraps; back near the start: net 0.05, turned the sum
+	* --rotation=units: 0.5 units per revolution count 4 times the revolutions of the whole range
+	* a reading not newer than the last one (sequence number) is ignored, a restart (reconnect) isn't a step
+	* no reading for TWROTATION_IDLEUSECS: the rate is 0
+	Benchmark: millions of readings at 1 kHz through twrotation_update, the time per reading within the limit; the
+	state is the fixed-size Twrotation, whatever the number of readings.
+
+	Parameter: number of benchmark readings (default 10000000), max. ns per reading (default 100)
+	RC=0 all checks passed, RC=1 a check failed
+*/
+
+#include "twrotation.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+static int failed = 0;
+
+static void check(bool condition, const char* what)
+{
+	if (!condition) {
+		printf("Check failed: %s\n", what);
+		failed = 1;
+	}
+}
+
+static bool near(double value, double expected)
+{
+	return fabs(value - expected) < 1e-4;
+}
+
+// Current wheel: its axis range (lowest value and span), unwrapped axis position, sequence number and timestamp of
+// the next reading (1 kHz)
+static double low = -1;
+static double span = 2.0;
+static double position = -1;
+static uint64_t sequence = 1;
+static uint64_t timestamp = 1000000;
+
+// Turn the wheel by 'units' axis units at 'unitspersec', one reading per ms, the axis wrapped into low...low + span
+static void turn(Twrotation* rot, double units, double unitspersec)
+{
+	double steps = fabs(units) * 1000 / unitspersec;
+	double step = units / steps;
+	for (int stepctr = 0; stepctr < (int)(steps + 0.5); ++stepctr) {
+		position += step;
+		double axis = fmod(position - low, span);
+		if (axis < 0) {
+			axis += span;
+		}
+		twrotation_update(rot, sequence++, timestamp, (float)(axis + low));
+		timestamp += 1000;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t readings = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000;
+	double maxns = (argc > 2) ? strtod(argv[2], NULL) : 100;
+
+// GameInput's axis 0...1 with the defaults: 2.5 revolutions of 1.0 unit at 2 units per sec, wraps at 1.0 and 2.0
+	Twrotation unitrange;
+	twrotation_init(&unitrange, TWROTATION_UNITSDFLT, TWROTATION_RANGEDFLT);
+	low = 0;
+	span = 1.0;
+	position = 0;
+	twrotation_update(&unitrange, sequence++, timestamp, (float)position);
+	timestamp += 1000;
+	turn(&unitrange, 2.5, 2.0);
+	printf("0...1: net %+.4f, turned %.4f revolutions, %llu wraps, rate %.3f rev/s\n", unitrange.rotation,
+		unitrange.turned, (unsigned long long)unitrange.wraps, twrotation_rate(&unitrange, timestamp));
+	check(near(unitrange.rotation, 2.5) && near(unitrange.turned, 2.5), "0...1: 2.5 revolutions");
+	check(unitrange.wraps == 2, "0...1: 2 wraps");
+	check(fabs(twrotation_rate(&unitrange, timestamp) - 2.0) < 0.01, "0...1: rate 2 rev/s");
+	turn(&unitrange, -1.2, 2.0);
+	check(near(unitrange.rotation, 1.3) && near(unitrange.turned, 3.7), "0...1: 1.2 revolutions back");
+	check(unitrange.wraps == 3, "0...1: back across 2.0 units: one more wrap");
+
+// The axis -1...1 (range 2.0), a revolution the whole range
+	Twrotation rot;
+	twrotation_init(&rot, 2.0f, 2.0f);
+	low = -1;
+	span = 2.0;
+	position = -1;
+	twrotation_update(&rot, sequence++, timestamp, (float)position);
+	timestamp += 1000;
+// 3.25 revolutions of 2.0 units at 4 units per sec (2 rev/s), wraps at 1.0, 3.0 and 5.0 units from -1
+	turn(&rot, 6.5, 4.0);
+	printf("forward: net %+.4f, turned %.4f revolutions, %llu wraps, rate %.3f rev/s, %llu readings\n", rot.rotation,
+		rot.turned, (unsigned long long)rot.wraps, twrotation_rate(&rot, timestamp), (unsigned long long)rot.readings);
+	check(near(rot.rotation, 3.25) && near(rot.turned, 3.25), "forward 3.25 revolutions");
+	check(rot.wraps == 3, "forward 3 wraps");
+	check(fabs(twrotation_rate(&rot, timestamp) - 2.0) < 0.01, "forward rate 2 rev/s");
+	check(rot.readings == 1626, "every reading evaluated");
+
+	turn(&rot, -3.0, 4.0);
+	printf("backward: net %+.4f, turned %.4f revolutions, %llu wraps, rate %.3f rev/s\n", rot.rotation, rot.turned,
+		(unsigned long long)rot.wraps, twrotation_rate(&rot, timestamp));
+	check(near(rot.rotation, 1.75) && near(rot.turned, 4.75), "backward 1.5 revolutions");
+	check(rot.wraps == 5, "backward across 5.0 and 3.0 units: 2 more wraps");
+	check(fabs(twrotation_rate(&rot, timestamp) + 2.0) < 0.01, "backward rate -2 rev/s");
+
+// Back to near the start (not onto the end of the range, where rounding decides the side)
+	turn(&rot, -3.4, 4.0);
+	check(near(rot.rotation, 0.05) && near(rot.turned, 6.45), "back near the start: net 0.05, turned all");
+	check(rot.wraps == 6, "back near the start across 1.0 units: one more wrap");
+
+// Stale readings and the restart
+	double turned = rot.turned;
+	twrotation_update(&rot, sequence - 1, timestamp, 0.9f);
+	check(near(rot.turned, turned), "reading with an old sequence number ignored");
+	twrotation_restart(&rot);
+	twrotation_update(&rot, 1, timestamp, 0.9f);
+	check(near(rot.turned, turned), "first reading after a restart isn't a step");
+	check(twrotation_rate(&rot, timestamp + TWROTATION_IDLEUSECS) == 0, "rate 0 after the idle time");
+
+// Half a unit per revolution: the same turn counts four times the revolutions
+	Twrotation halfunit;
+	twrotation_init(&halfunit, 0.5f, 2.0f);
+	position = -1;
+	twrotation_update(&halfunit, sequence++, timestamp, (float)position);
+	turn(&halfunit, 1.0, 4.0);
+	check(near(halfunit.rotation, 2.0), "0.5 units per revolution: 2 revolutions for 1.0 unit");
+
+// Benchmark: readings of the axis 0...1 at 1 kHz, 4 rev/s, wrapping every 250 readings
+	Twrotation bench;
+	twrotation_init(&bench, TWROTATION_UNITSDFLT, TWROTATION_RANGEDFLT);
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t reading = 0; reading < readings; ++reading) {
+		float axis = (float)((reading % 250) * 0.004);
+		twrotation_update(&bench, reading + 1, reading * 1000, axis);
+	}
+	auto end = std::chrono::steady_clock::now();
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / readings;
+	printf("%llu readings at 1 kHz: %.1f ns per reading, %.0f revolutions, %zu bytes of state\n",
+		(unsigned long long)readings, ns, bench.turned, sizeof(bench));
+	check(bench.readings == readings, "every benchmark reading evaluated");
+	check(fabs(bench.turned - readings * 0.004) < readings * 1e-6, "benchmark revolutions");
+	check(ns <= maxns, "time per reading within the limit");
+	return failed;
+}
@@ -0,0 +1,38 @@
+/*
+	twslowreader.cpp
+
+	A slow reader of a pipe for the test of the console logger (twlog.h), published under MIT license like the
+	main program.
+
+	Copies stdin to stdout at most at the given rate, like a slow console or a boot script that takes its time
+	with each line: the program's stdout piped into it fills the pipe, then its writer thread has to wait.
+
+	Parameter: bytes per second (default 65536)
+	RC=0 end of input reached
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+
+int main(int argc, char* argv[])
+{
+	double rate = (argc > 1) ? strtod(argv[1], NULL) : 65536;
+	if (rate <= 0) {
+		rate = 65536;
+	}
+// Small chunks, so the rate holds for short outputs too
+	char chunk[256];
+	uint64_t total = 0;
+	auto start = std::chrono::steady_clock::now();
+	size_t length;
+	while ((length = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+		fwrite(chunk, 1, length, stdout);
+		total += length;
+		std::this_thread::sleep_until(start + std::chrono::microseconds((uint64_t)(total * 1e6 / rate)));
+	}
+	fflush(stdout);
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+	twstatstest.cpp
+
+	Accuracy and overhead of the phase timing histograms (twstats.h), published under MIT license like the main program.
+
+	Known values are recorded by twstats_addns() into phases of their own, the summaries are checked against the
+	exact statistics of the values:
+	* 0...7 ns : exact buckets, p50 3, max 7
+	* uniform 1...100000 ns and log-uniform 8 ns...1 s (generated) : p50 and p99 at most one sub-bucket (12.5%) above
+	  the exact percentile, never below it, mean and max exact
+	* a single value : p50 and p99 clipped to the max, the value itself
+	Overhead: millions of phase boundaries (twstats_mark) of an empty phase, the cost of one has to stay within the
+	limit, an inactive boundary (twstats_active false) has to cost less than an active one. A timed scope
+	(Twstatsscope, two reads of the clock) is shown for comparison.
+
+	Parameter: number of boundaries (default 5000000), max. ns per boundary (default 100)
+	RC=0 all checks passed, RC=1 a check failed
+*/
+
+#include "twstats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static int failed = 0;
+
+static void check(bool condition, const char* what)
+{
+	if (!condition) {
+		printf("Check failed: %s\n", what);
+		failed = 1;
+	}
+}
+
+// Exact percentile of sorted values, the same rank as twstats.cpp (nearest rank)
+static uint64_t exactpercentile(const std::vector<uint64_t>& sorted, double percent)
+{
+	size_t rank = (size_t)(sorted.size() * percent / 100.0 + 0.5);
+	if (rank == 0) {
+		rank = 1;
+	}
+	return sorted[rank - 1];
+}
+
+// Record the values into a phase, check its summary against the exact statistics
+static void checkphase(Twstatsphase phase, std::vector<uint64_t> values, const char* what)
+{
+	uint64_t sum = 0;
+	for (uint64_t value : values) {
+		twstats_addns(phase, value);
+		sum += value;
+	}
+	std::sort(values.begin(), values.end());
+	Twstatssummary summary;
+	if (!twstats_summary(phase, &summary)) {
+		printf("Check failed: %s has no summary\n", what);
+		failed = 1;
+		return;
+	}
+	uint64_t p50 = exactpercentile(values, 50);
+	uint64_t p99 = exactpercentile(values, 99);
+	printf("%-12s %8llu samples: p50 %llu ns (exact %llu), p99 %llu ns (exact %llu), max %llu ns\n", what,
+		(unsigned long long)summary.samples, (unsigned long long)summary.p50ns, (unsigned long long)p50,
+		(unsigned long long)summary.p99ns, (unsigned long long)p99, (unsigned long long)summary.maxns);
+	check(summary.samples == values.size(), "sample count");
+	check(summary.meanns == sum / values.size(), "mean exact");
+	check(summary.maxns == values.back(), "max exact");
+	check((summary.p50ns >= p50) && (summary.p50ns <= p50 + p50 / 8), "p50 within one sub-bucket above the exact one");
+	check((summary.p99ns >= p99) && (summary.p99ns <= p99 + p99 / 8), "p99 within one sub-bucket above the exact one");
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t boundaries = (argc > 1) ? strtoull(argv[1], NULL, 10) : 5000000;
+	double maxboundaryns = (argc > 2) ? strtod(argv[2], NULL) : 100;
+	twstats_init();
+
+	std::vector<uint64_t> values;
+	for (uint64_t value = 0; value < 8; ++value) {
+		values.push_back(value);
+	}
+	checkphase(TWSTATS_DISPATCH, values, "0...7 ns");
+	Twstatssummary summary;
+	twstats_summary(TWSTATS_DISPATCH, &summary);
+	check(summary.p50ns == 3, "p50 of 0...7 ns exact");
+
+	values.clear();
+	for (uint64_t value = 1; value <= 100000; ++value) {
+		values.push_back(value);
+	}
+	checkphase(TWSTATS_READING, values, "uniform");
+
+// Log-uniform: 2^(3 + 27 * r) ns with the LCG of ANSI C, so every sub-bucket from 8 ns to 1 s gets samples
+	values.clear();
+	uint32_t seed = 7;
+	for (int sample = 0; sample < 200000; ++sample) {
+		seed = seed * 1103515245 + 12345;
+		double fraction = ((seed >> 8) & 0xFFFFFF) / 16777216.0;
+		values.push_back((uint64_t)(8.0 * exp2(27.0 * fraction)));
+	}
+	checkphase(TWSTATS_STATE, values, "log-uniform");
+
+	values.assign(1, 123456789);
+	checkphase(TWSTATS_PRINT, values, "single");
+	twstats_summary(TWSTATS_PRINT, &summary);
+	check((summary.p50ns == 123456789) && (summary.p99ns == 123456789), "p50 and p99 of a single value clipped to it");
+
+// Overhead: active boundaries into TWSTATS_KBHIT, then inactive ones, then timed scopes into TWSTATS_BEEP
+	auto start = std::chrono::steady_clock::now();
+	twstats_begin();
+	for (uint64_t boundary = 0; boundary < boundaries; ++boundary) {
+		twstats_mark(TWSTATS_KBHIT);
+	}
+	auto end = std::chrono::steady_clock::now();
+	double activens = std::chrono::duration<double, std::nano>(end - start).count() / boundaries;
+	twstats_active = false;
+	start = std::chrono::steady_clock::now();
+	for (uint64_t boundary = 0; boundary < boundaries; ++boundary) {
+		twstats_mark(TWSTATS_KBHIT);
+	}
+	end = std::chrono::steady_clock::now();
+	double inactivens = std::chrono::duration<double, std::nano>(end - start).count() / boundaries;
+	twstats_active = true;
+	start = std::chrono::steady_clock::now();
+	for (uint64_t scope = 0; scope < boundaries; ++scope) {
+		Twstatsscope statsscope(TWSTATS_BEEP);
+	}
+	end = std::chrono::steady_clock::now();
+	double scopens = std::chrono::duration<double, std::nano>(end - start).count() / boundaries;
+	twstats_summary(TWSTATS_KBHIT, &summary);
+	printf("%llu phase boundaries: %.1f ns per boundary, %.1f ns inactive (limit %.0f ns), %.1f ns per timed scope\n",
+		(unsigned long long)boundaries, activens, inactivens, maxboundaryns, scopens);
+	check(summary.samples == boundaries, "every active boundary recorded, no inactive one");
+	check(activens <= maxboundaryns, "cost of a phase boundary within the limit");
+	check(inactivens < activens, "inactive boundary cheaper than an active one");
+	return failed;
+}
@@ -0,0 +1,52 @@
+# Helpers of the scripted tests (cmake -P), included by the test scripts of this folder
+#
+# Each test script is called by CTest (see CMakeLists.txt) with
+#	-DPROGRAM=<SaitekTrimwheel of the fake GameInput build>
+#	-DWORKDIR=<folder for the scripts and files a test writes>
+# and fails by message(SEND_ERROR) (goes on, the other checks are still shown) or message(FATAL_ERROR)
+#
+cmake_minimum_required(VERSION 3.25)
+if (NOT PROGRAM OR NOT WORKDIR)
+	message(FATAL_ERROR "Call with -DPROGRAM=<SaitekTrimwheel> -DWORKDIR=<folder>")
+endif()
+file(MAKE_DIRECTORY ${WORKDIR})
+
+# Write the event script <name> (lines of the fake GameInput script, see fakegameinput.h) to WORKDIR,
+# sets <name> to its path
+function(twscript name)
+	list(JOIN ARGN "\n" lines)
+	file(WRITE ${WORKDIR}/${name}.tws "${lines}\n")
+	set(${name} ${WORKDIR}/${name}.tws PARENT_SCOPE)
+endfunction()
+
+# Run the program with the arguments, sets <outvar> to its output (stdout and stderr) and <rcvar> to its return code
+function(twrun outvar rcvar)
+	execute_process(COMMAND ${PROGRAM} ${ARGN} OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE rc
+		TIMEOUT 600)
+	set(${outvar} "${output}" PARENT_SCOPE)
+	set(${rcvar} "${rc}" PARENT_SCOPE)
+endfunction()
+
+# The number captured by <regex> (one group) in <text>, fails if there is none
+function(twnumber var regex text)
+	if (NOT text MATCHES "${regex}")
+		message(SEND_ERROR "No match of '${regex}' in output:\n${text}")
+		set(${var} "" PARENT_SCOPE)
+		return()
+	endif()
+	set(${var} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+endfunction()
+
+# Check the return code of run <what>
+function(twexpectrc what rc expected text)
+	if (NOT "${rc}" STREQUAL "${expected}")
+		message(SEND_ERROR "${what}: RC=${rc}, expected ${expected}, output:\n${text}")
+	endif()
+endfunction()
+
+# Check number <value> of run <what> against <op> (LESS, LESS_EQUAL, EQUAL, GREATER_EQUAL, GREATER) <limit>
+function(twexpect what name value op limit)
+	if (NOT "${value}" ${op} "${limit}")
+		message(SEND_ERROR "${what}: ${name} is ${value}, expected ${op} ${limit}")
+	endif()
+endfunction()
@@ -0,0 +1,97 @@
+/*
+	twtracegen.cpp
+
+	Generator of large trace files (twtrace.h) for the rate test of twtracedecode (tests/trace.cmake), published under
+	MIT license like the main program.
+
+	Writes one session of the given number of records, like a long boot recorded with "-d -T": a start event, the
+	connect callbacks of 17 controllers, then readings of them in turn (axes and buttons changing with each reading,
+	a reading every ms per controller), every 1000th record a device event, and the exit event last.
+
+	Parameters: trace file, number of records (default 1048576, 64 MB)
+	RC=0 written, RC=12 file error
+*/
+
+#include "twtrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint16_t controllers = 17;
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: twtracegen <tracefile> [<records>]\n");
+		return 12;
+	}
+	uint64_t count = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1048576;
+	if (count < 2 + controllers) {
+		count = 2 + controllers;
+	}
+	FILE* file = fopen(argv[1], "wb");
+	if (file == NULL) {
+		fprintf(stderr, "Cannot create trace file %s\n", argv[1]);
+		return 12;
+	}
+	Twtraceheader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TWTRACE_MAGIC, sizeof(header.magic));
+	header.version = TWTRACE_VERSION;
+	header.recordsize = sizeof(Twtracerecord);
+	header.recordcount = count;
+	bool written = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+	static Twtracerecord block[4096];
+	size_t used = 0;
+	uint32_t seed = 9;
+	uint64_t sequence[controllers] = {};
+	for (uint64_t recordnbr = 0; written && (recordnbr < count); ++recordnbr) {
+		Twtracerecord& record = block[used++];
+		memset(&record, 0, sizeof(record));
+		uint16_t device = (uint16_t)(recordnbr % controllers);
+		record.device = device;
+		record.vid = (device == 0) ? 0x06A3 : 0x044F;
+		record.pid = (device == 0) ? 0x0BD4 : (uint16_t)(0xB10A + device);
+		record.timestamp = 1000000 + recordnbr * 1000 / controllers;
+		record.nbraxes = (device == 0) ? 1 : 4;
+		record.nbrbutt = (device == 0) ? 0 : 32;
+		if (recordnbr == 0) {
+			record.kind = TWTRACE_EVENT;
+			record.event = TWTRACE_EV_START;
+			record.device = TWTRACE_NODEVICE;
+		} else if (recordnbr == count - 1) {
+			record.kind = TWTRACE_EVENT;
+			record.event = TWTRACE_EV_EXIT;
+			record.device = TWTRACE_NODEVICE;
+			record.sequence = 1;
+		} else if (recordnbr <= controllers) {
+			record.kind = TWTRACE_CALLBACK;
+			record.event = TWTRACE_EV_CONNECTED;
+			record.buttons[0] = 1;
+		} else if (recordnbr % 1000 == 0) {
+			record.kind = TWTRACE_EVENT;
+			record.event = TWTRACE_EV_NOTFOUND;
+		} else {
+			record.kind = TWTRACE_READING;
+			record.sequence = ++sequence[device];
+			for (uint32_t axis = 0; axis < record.nbraxes; ++axis) {
+// The LCG of ANSI C, axes -1...1
+				seed = seed * 1103515245 + 12345;
+				record.axes[axis] = (float)((seed >> 8) % 2000001) / 1000000.0f - 1.0f;
+			}
+			record.buttons[0] = (device == 0) ? 0 : (seed & 0xFFFFFFFF);
+		}
+		if ((used == sizeof(block) / sizeof(block[0])) || (recordnbr == count - 1)) {
+			written = (fwrite(block, sizeof(Twtracerecord), used, file) == used);
+			used = 0;
+		}
+	}
+	written = (fclose(file) == 0) && written;
+	if (!written) {
+		fprintf(stderr, "Cannot write trace file %s\n", argv[1]);
+		return 12;
+	}
+	return 0;
+}
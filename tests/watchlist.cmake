@@ -0,0 +1,35 @@
+# Watch-list (README "Scaling benchmark"): without "-a", controllers other than the Trimwheel don't enter the registry,
+# so the cycle costs the same however many of them are plugged in
+#
+# The Trimwheel and 1, 16 or 255 other controllers (8 axes, 32 buttons) with a new reading each 100 ms, a minute of
+# 1 s cycles: the registry holds only the Trimwheel, GetCurrentReading is called once per cycle (its samples of
+# "--stats") and the cycle's p50 stays within the limit. With "-a" for comparison, all of them are read each cycle.
+#
+include(${CMAKE_CURRENT_LIST_DIR}/twtest.cmake)
+
+message("| other controllers | -a | registered | GetCurrentReading calls | cycle p50 (ns) |")
+message("|---|---|---|---|---|")
+foreach (count 1 16 255)
+	twscript(others${count} "0 connect 0 0x06A3 0x0BD4" "0 synth 1 ${count} 0x044F 0xB10A 8 32"
+		"0 noise 1 ${count} 60000 100")
+	foreach (all "" "-a")
+		set(what "${count} other controllers ${all}")
+		twrun(output rc -s ${all} -c 60 --stats --json --script ${others${count}})
+		twexpectrc("${what}" "${rc}" 1 "${output}")
+		twnumber(controllers "\"controllers\":([0-9]+)" "${output}")
+		twnumber(cycles "\"phase\":\"cycle\",\"samples\":([0-9]+)" "${output}")
+		twnumber(readings "\"phase\":\"GetCurrentReading\",\"samples\":([0-9]+)" "${output}")
+		twnumber(p50 "\"phase\":\"cycle\",[^\n]*\"p50_ns\":([0-9]+)" "${output}")
+		if (all)
+			math(EXPR expected "${count} + 1")
+			math(EXPR expectedreadings "${cycles} * ${expected}")
+		else()
+			set(expected 1)
+			set(expectedreadings ${cycles})
+			twexpect("${what}" "cycle p50 (ns)" "${p50}" LESS_EQUAL 50000)
+		endif()
+		twexpect("${what}" "registered controllers" "${controllers}" EQUAL ${expected})
+		twexpect("${what}" "GetCurrentReading calls" "${readings}" EQUAL ${expectedreadings})
+		message("| ${count} | ${all} | ${controllers} | ${readings} | ${p50} |")
+	endforeach()
+endforeach()
@@ -0,0 +1,95 @@
+/*
+	twclock.cpp
+
+	Time sources of SaitekTrimwheel.cpp, see twclock.h
+*/
+
+#include "twclock.h"
+
+#include <windows.h>
+// for timeBeginPeriod(), timeEndPeriod()
+#include <timeapi.h>
+
+static IGameInput* clockgameinput = NULL;
+static uint64_t clockwakeups = 0;
+static bool clockraised = false;
+
+void twclock_init(IGameInput* gameinput, uint32_t minmsecs)
+{
+	clockgameinput = gameinput;
+// The default timer resolution of 15.6 ms would stretch a 10 ms cycle to 15.6 ms. The raised resolution costs power
+// system-wide, so only for periods that need it
+	if (minmsecs < TWCLOCK_GRANULARITY) {
+		clockraised = (timeBeginPeriod(1) == TIMERR_NOERROR);
+	}
+}
+
+void twclock_exit()
+{
+	if (clockraised) {
+		timeEndPeriod(1);
+		clockraised = false;
+	}
+}
+
+uint64_t twclock_msecs()
+{
+	return GetTickCount64();
+}
+
+uint64_t twclock_timestamp()
+{
+	return (clockgameinput != NULL) ? clockgameinput->GetCurrentTimestamp() : 0;
+}
+
+void twclock_sleep(uint32_t msecs)
+{
+	Sleep(msecs);
+	++clockwakeups;
+}
+
+// Milliseconds from 'now' to 'timestamp', rounded up: Sleep() and the waits may return up to a millisecond early
+// otherwise, and another wait for the rest would follow
+static uint32_t twclock_msecsuntil(uint64_t timestamp, uint64_t now)
+{
+	uint64_t msecs = (timestamp - now + 999) / 1000;
+	return (msecs < INFINITE) ? (uint32_t)msecs : INFINITE - 1;
+}
+
+void twclock_sleepuntil(uint64_t timestamp)
+{
+	uint64_t now;
+	while ((now = twclock_timestamp()) < timestamp) {
+		Sleep(twclock_msecsuntil(timestamp, now));
+		++clockwakeups;
+	}
+}
+
+DWORD twclock_waituntil(HANDLE handle, uint64_t timestamp)
+{
+	uint64_t now;
+	while ((now = twclock_timestamp()) < timestamp) {
+		DWORD waitret = WaitForSingleObject(handle, twclock_msecsuntil(timestamp, now));
+		++clockwakeups;
+		if (waitret != WAIT_TIMEOUT) {
+			return waitret;
+		}
+	}
+	return WAIT_TIMEOUT;
+}
+
+DWORD twclock_wait(HANDLE handle, uint32_t msecs)
+{
+	++clockwakeups;
+	return WaitForSingleObject(handle, msecs);
+}
+
+uint64_t twclock_wakeups()
+{
+	return clockwakeups;
+}
+
+void twclock_beep(uint32_t frequency, uint32_t msecs)
+{
+	Beep(frequency, msecs);
+}
@@ -0,0 +1,53 @@
+/*
+	twclock.h
+
+	Time sources of SaitekTrimwheel.cpp, published under MIT license like the main program.
+
+	Every wait and every time the program reads goes through these functions: the cycle sleep, the event wait of "-e",
+	the tones, the milliseconds of the cycle loop's statistics and the GameInput timestamps of events, latency and
+	the cycle deadlines (twclock_sleepuntil, twclock_waituntil).
+	On Windows, they are just the Win32/GameInput calls. In the fake GameInput build (fakegameinput.h), the same
+	calls run on the fake's virtual clock, so a whole day of cycles (e.g. the soak run "--soak") takes seconds.
+	Not covered by purpose: QueryPerformanceCounter in twstats.cpp, it measures the real cost of our own code.
+*/
+#pragma once
+
+#include "GameInput.h"
+
+#include <stdint.h>
+
+// Windows' default timer granularity (msecs, 15.6 rounded up): Sleep() and the waits wake up on its ticks only
+#define TWCLOCK_GRANULARITY		16
+
+// Set the GameInput instance of the timestamps, to be called right after GameInputCreate()
+// 'minmsecs' is the shortest period the program will sleep or wait: if it is below TWCLOCK_GRANULARITY, the Windows
+// timer resolution is raised to 1 ms until twclock_exit(), so Sleep() can meet it
+void twclock_init(IGameInput* gameinput, uint32_t minmsecs);
+
+// Restore the Windows timer resolution raised by twclock_init(), to be called on every exit path after it
+void twclock_exit();
+
+// Milliseconds since system start (GetTickCount64)
+uint64_t twclock_msecs();
+
+// GameInput timestamp in microseconds (monotonic, since system start), 0 before twclock_init()
+uint64_t twclock_timestamp();
+
+// Wait 'msecs' milliseconds (Sleep)
+void twclock_sleep(uint32_t msecs);
+
+// Wait until the GameInput timestamp 'timestamp' (microseconds) is reached, returns at once if it already is
+void twclock_sleepuntil(uint64_t timestamp);
+
+// Wait for 'handle' until the GameInput timestamp 'timestamp' is reached, returns WAIT_OBJECT_0 as soon as 'handle'
+// is signaled, WAIT_TIMEOUT when the time is up (at once if it already is) or WAIT_FAILED
+DWORD twclock_waituntil(HANDLE handle, uint64_t timestamp);
+
+// Wait for 'handle' at most 'msecs' milliseconds, returns WAIT_OBJECT_0, WAIT_TIMEOUT or WAIT_FAILED (WaitForSingleObject)
+DWORD twclock_wait(HANDLE handle, uint32_t msecs);
+
+// Number of times the program has woken up from a sleep or wait so far (for the polling benchmark, see twpoll.h)
+uint64_t twclock_wakeups();
+
+// Play a tone for 'msecs' milliseconds, returns after the tone (Beep)
+void twclock_beep(uint32_t frequency, uint32_t msecs);
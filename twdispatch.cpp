@@ -0,0 +1,224 @@
+/*
+	twdispatch.cpp
+
+	Dispatcher thread of SaitekTrimwheel.cpp, see twdispatch.h
+
+	The ring has a write index, only advanced by the producer after it has filled the record (release), and a read
+	index, only advanced by the consumer after it has copied the record (release). Each side reads the other's index
+	with acquire, so a record is never read before it is written, nor overwritten before it is read.
+	Both indexes count up forever, their difference is the number of waiting records; they live in cache lines
+	of their own, so producer and consumer don't slow each other down by false sharing.
+	Waking the main loop: it sets dispwaiting before it checks the ring a last time and waits, the producer checks
+	dispwaiting after it has advanced the write index (both sequentially consistent), so at least one of them
+	sees the other and no event is left unnoticed. An auto-reset wake event set once too often only ends one wait early.
+	Room in a full ring works the same way the other way round: the producer sets dispfull before it checks the ring
+	a last time and blocks on the room event, the consumer checks dispfull after it has advanced the read index.
+	It only sets the room event once half of the ring is free: it takes all waiting events anyway, and the
+	producer then hands over half a ring of events instead of waking up for each single one.
+*/
+
+#include "twdispatch.h"
+#include "twclock.h"
+
+#include <windows.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+static_assert((TWDISPATCH_RING & (TWDISPATCH_RING - 1)) == 0, "TWDISPATCH_RING must be a power of 2");
+static_assert(sizeof(Twdispatchevent) <= 32, "Twdispatchevent should stay compact");
+
+bool twdispatch_active = false;
+
+static IGameInputDispatcher* dispdispatcher = NULL;
+static uint64_t dispquota = TWDISPATCH_QUOTADFLT;
+static HANDLE dispstopevent = NULL;			// ends the thread
+static HANDLE dispwakeevent = NULL;			// ends the main loop's wait (auto-reset)
+static HANDLE disproomevent = NULL;			// ends the producer's wait for room in a full ring (auto-reset)
+static std::thread dispthread;
+static Twdispatchevent dispring[TWDISPATCH_RING];
+alignas(64) static std::atomic<uint64_t> dispwrite(0);		// next record to fill (producer)
+alignas(64) static std::atomic<uint64_t> dispread(0);		// next record to take (consumer)
+alignas(64) static std::atomic<bool> dispwaiting(false);	// main loop waits on the wake event
+alignas(64) static std::atomic<bool> dispfull(false);		// producer waits on the room event
+static std::atomic<bool> dispstopping(false);
+static std::atomic<uint64_t> dispcalls(0);
+static uint64_t dispmaxqueued = 0;			// producer only
+static uint64_t dispfullwaits = 0;			// producer only
+
+// Wait for GameInput work or the stop event, dispatch the work within the quota.
+// 'opened' tells twdispatch_start whether the thread got its wait handle
+static void twdispatch_loop(std::promise<bool>* opened)
+{
+// Our own wait handle, so it is closed by the thread that waits on it
+	HANDLE workhandle = NULL;
+	if (FAILED(dispdispatcher->OpenWaitHandle(&workhandle)) || (workhandle == NULL)) {
+		opened->set_value(false);
+		return;
+	}
+	opened->set_value(true);
+	HANDLE handles[2] = { workhandle, dispstopevent };
+	while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0) {
+		dispdispatcher->Dispatch(dispquota);
+		dispcalls.fetch_add(1);
+	}
+	CloseHandle(workhandle);
+}
+
+// Release the device or reading of an event nobody will apply
+static void twdispatch_discard(const Twdispatchevent& event)
+{
+	if (event.kind == TWDISPATCH_DEVICE) {
+		event.device->Release();
+	} else {
+		event.reading->Release();
+	}
+}
+
+bool twdispatch_start(IGameInputDispatcher* dispatcher, uint64_t quotausecs)
+{
+	dispdispatcher = dispatcher;
+	dispquota = quotausecs;
+	dispstopping.store(false);
+	dispstopevent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	dispwakeevent = CreateEventA(NULL, FALSE, FALSE, NULL);
+	disproomevent = CreateEventA(NULL, FALSE, FALSE, NULL);
+	if ((dispstopevent == NULL) || (dispwakeevent == NULL) || (disproomevent == NULL)) {
+		twdispatch_stop();
+		return false;
+	}
+// Set before the thread starts: from its first Dispatch() on, the callbacks hand over their events
+	twdispatch_active = true;
+	std::promise<bool> opened;
+	try {
+		dispthread = std::thread(twdispatch_loop, &opened);
+	} catch (...) {
+		twdispatch_active = false;
+		twdispatch_stop();
+		return false;
+	}
+// Only return when the thread waits for work: GameInput work queued before would wait for the next one
+	if (!opened.get_future().get()) {
+		dispthread.join();
+		twdispatch_active = false;
+		twdispatch_stop();
+		return false;
+	}
+	return true;
+}
+
+void twdispatch_stop()
+{
+// A producer waiting on a full ring gives up, the main loop doesn't take any more
+	dispstopping.store(true);
+	if (dispthread.joinable()) {
+		SetEvent(dispstopevent);
+		dispthread.join();
+	}
+	twdispatch_active = false;
+	Twdispatchevent event;
+	while (twdispatch_take(&event)) {
+		twdispatch_discard(event);
+	}
+	if (dispstopevent != NULL) {
+		CloseHandle(dispstopevent);
+		dispstopevent = NULL;
+	}
+	if (dispwakeevent != NULL) {
+		CloseHandle(dispwakeevent);
+		dispwakeevent = NULL;
+	}
+	if (disproomevent != NULL) {
+		CloseHandle(disproomevent);
+		disproomevent = NULL;
+	}
+}
+
+void twdispatch_post(const Twdispatchevent& event)
+{
+	uint64_t writeidx = dispwrite.load(std::memory_order_relaxed);
+	uint64_t queued = writeidx - dispread.load(std::memory_order_acquire);
+	if (queued >= TWDISPATCH_RING) {
+// Ring full: the main loop is busy (console, tones) or doesn't wait yet, make sure it wakes up and block until
+// it has taken an event (or the program stops)
+		dispfullwaits++;
+		SetEvent(dispwakeevent);
+		HANDLE handles[2] = { disproomevent, dispstopevent };
+		dispfull.store(true);
+		while (writeidx - dispread.load() >= TWDISPATCH_RING) {
+			if (dispstopping.load()) {
+				dispfull.store(false);
+				twdispatch_discard(event);
+				return;
+			}
+			WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+		}
+		dispfull.store(false);
+	}
+	if (queued + 1 > dispmaxqueued) {
+		dispmaxqueued = (queued < TWDISPATCH_RING) ? queued + 1 : TWDISPATCH_RING;
+	}
+	dispring[writeidx & (TWDISPATCH_RING - 1)] = event;
+	dispwrite.store(writeidx + 1);
+	if (dispwaiting.load()) {
+		SetEvent(dispwakeevent);
+	}
+}
+
+bool twdispatch_take(Twdispatchevent* event)
+{
+	uint64_t readidx = dispread.load(std::memory_order_relaxed);
+	if (readidx == dispwrite.load(std::memory_order_acquire)) {
+		return false;
+	}
+	*event = dispring[readidx & (TWDISPATCH_RING - 1)];
+	dispread.store(readidx + 1);
+// Wake a producer waiting for room only when half of the ring is free, not for each single record
+	if (dispfull.load() && (dispwrite.load(std::memory_order_acquire) - (readidx + 1) <= TWDISPATCH_RING / 2)) {
+		SetEvent(disproomevent);
+	}
+	return true;
+}
+
+// Main loop: events waiting in the ring
+static bool twdispatch_pending()
+{
+	return dispread.load(std::memory_order_relaxed) != dispwrite.load(std::memory_order_acquire);
+}
+
+bool twdispatch_waituntil(uint64_t deadline)
+{
+	if (twdispatch_pending()) {
+		return true;
+	}
+	dispwaiting.store(true);
+	if (twdispatch_pending()) {
+		dispwaiting.store(false);
+		return true;
+	}
+	DWORD waitret = twclock_waituntil(dispwakeevent, deadline);
+	dispwaiting.store(false);
+	return (waitret == WAIT_OBJECT_0) || twdispatch_pending();
+}
+
+uint64_t twdispatch_calls()
+{
+	return dispcalls.load();
+}
+
+uint64_t twdispatch_posted()
+{
+	return dispwrite.load();
+}
+
+// Read after twdispatch_stop() (the thread has ended), so the producer's plain counters need no atomics
+uint64_t twdispatch_maxqueued()
+{
+	return dispmaxqueued;
+}
+
+uint64_t twdispatch_fullwaits()
+{
+	return dispfullwaits;
+}
@@ -0,0 +1,83 @@
+/*
+	twdispatch.h
+
+	Dispatcher thread of SaitekTrimwheel.cpp (option "--dispatcher[=usecs]"), published under MIT license like the main program.
+
+	In manual dispatch mode, GameInput does its background work and calls our callbacks only when we call Dispatch(),
+	and the cycle loop does so once per cycle. So a connect or a reading waits for up to a whole cycle period.
+	With the dispatcher thread, a thread of its own waits on the dispatcher's wait handle and calls Dispatch() with
+	a quota (microseconds) as soon as GameInput has work. Our callbacks then run on this thread: they don't touch
+	the device registry, but hand their arguments over to the main loop (twdispatch_post), which takes them
+	(twdispatch_take) at the start of a cycle or while it waits for the next one (twdispatch_waituntil).
+	So the registry has a single writer, the main loop, and is only changed at these points.
+
+	The handover is a bounded lock-free single-producer/single-consumer ring of compact event records (32 bytes):
+	the dispatcher thread is the only producer, the main loop the only consumer, each one only advances its own index.
+	The wake event is only set when the main loop waits for it (like the writer thread of twlog.h), not per event.
+	Only one thread may call twdispatch_post() at a time: GameInput calls our callbacks from Dispatch(), and only
+	the dispatcher thread calls it while the thread runs (the callbacks of RegisterDeviceCallback's blocking
+	enumeration run before twdispatch_start and apply their events directly).
+	If the ring is full, the dispatcher thread blocks on an event until the main loop has taken one (no event is lost,
+	counted by twdispatch_fullwaits), at twdispatch_stop() it releases what it can't hand over any more.
+*/
+#pragma once
+
+#include "GameInput.h"
+
+#include <stdint.h>
+
+// Default quota of one Dispatch() call in microseconds
+#define TWDISPATCH_QUOTADFLT	1000
+// Number of event records in the ring, power of 2 (a burst of readings from all controllers between two takes),
+// a small ring (e.g. -DTWDISPATCH_RING=16) lets a stress run hit the full ring all the time
+#ifndef TWDISPATCH_RING
+#define TWDISPATCH_RING			4096
+#endif
+
+enum Twdispatchkind : uint8_t
+{
+	TWDISPATCH_DEVICE = 1,				// device callback
+	TWDISPATCH_READING = 2				// reading callback
+};
+
+// A callback's arguments, handed over to the main loop. The device or reading is referenced (AddRef) by the callback,
+// the main loop releases it after it has applied the event
+struct Twdispatchevent
+{
+	union {
+		IGameInputDevice* device;		// TWDISPATCH_DEVICE
+		IGameInputReading* reading;		// TWDISPATCH_READING
+	};
+	uint64_t timestamp;					// GameInput timestamp of the device callback or of the reading
+	GameInputDeviceStatus currentstatus;	// device callback only
+	GameInputDeviceStatus previousstatus;
+	Twdispatchkind kind;
+	bool overrun;						// reading callback only: readings were lost before this one
+};
+
+// The dispatcher thread is running (the callbacks hand over their events instead of applying them)
+extern bool twdispatch_active;
+
+// Start the thread, returns false if it (or one of its events) can't be created
+bool twdispatch_start(IGameInputDispatcher* dispatcher, uint64_t quotausecs);
+
+// Stop the thread and release the events it has handed over and nobody took
+void twdispatch_stop();
+
+// Dispatcher thread (single producer): hand over one event, wake up the main loop if it waits
+void twdispatch_post(const Twdispatchevent& event);
+
+// Main loop (single consumer): take the oldest event, returns false if there is none
+bool twdispatch_take(Twdispatchevent* event);
+
+// Main loop: wait until an event is handed over or the GameInput timestamp 'deadline' is reached,
+// returns true if events are waiting
+bool twdispatch_waituntil(uint64_t deadline);
+
+// Number of Dispatch() calls by the thread
+uint64_t twdispatch_calls();
+
+// Events handed over, the most that were waiting in the ring at once, and how often the ring was full
+uint64_t twdispatch_posted();
+uint64_t twdispatch_maxqueued();
+uint64_t twdispatch_fullwaits();
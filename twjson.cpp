@@ -0,0 +1,152 @@
+/*
+	twjson.cpp
+
+	NDJSON event output of SaitekTrimwheel.cpp, see twjson.h
+
+	The file descriptor of stdout is duplicated for the events, then stdout is redirected to stderr (_dup2),
+	so all printf's of the program and the twlog writer thread end up on stderr without any change.
+
+	twjson_event() is the one written many times (a reading's events), its line is put together by hand instead of
+	snprintf: snprintf's "%f" costs about as much as the write of the line, the hand-made line gives the same text.
+*/
+
+#include "twjson.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <io.h>
+
+static FILE* jsonstream = NULL;
+static char jsonline[256];
+static char jsonbuffer[4096];		// stream buffer, so a line is written by one system call
+
+bool twjson_open()
+{
+	fflush(stdout);
+	int jsonfd = _dup(_fileno(stdout));
+	if (jsonfd < 0) {
+		return false;
+	}
+	jsonstream = _fdopen(jsonfd, "w");
+	if (jsonstream == NULL) {
+		_close(jsonfd);
+		return false;
+	}
+	setvbuf(jsonstream, jsonbuffer, _IOFBF, sizeof(jsonbuffer));
+	if (_dup2(_fileno(stderr), _fileno(stdout)) != 0) {
+		fclose(jsonstream);
+		jsonstream = NULL;
+		return false;
+	}
+	return true;
+}
+
+// Write the formatted line of 'length' chars from jsonline
+static void twjson_write(int length)
+{
+	if ((length <= 0) || (length >= (int)sizeof(jsonline))) {
+		return;
+	}
+	fwrite(jsonline, 1, length, jsonstream);
+	fflush(jsonstream);		// the boot script reacts on each event, so don't keep it in the buffer
+}
+
+// Append a string, returns the new end of the line
+static char* putstr(char* pos, const char* text, size_t length)
+{
+	memcpy(pos, text, length);
+	return pos + length;
+}
+
+// Append the decimal digits of a value
+static char* putuint(char* pos, uint64_t value)
+{
+	char digits[20];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	while (count > 0) {
+		*pos++ = digits[--count];
+	}
+	return pos;
+}
+
+// Append an axis value as "%f" does: 6 decimals, rounded half to even. A float times 1e6 is exact in a double
+// (24 + 20 bits of mantissa), so llrint rounds the exact value as printf does; NaN, infinite and huge values
+// (not from an axis) are left to snprintf
+static char* putaxis(char* pos, float axis)
+{
+	double value = fabs((double)axis);
+	if (!(value < 1e12)) {
+		return pos + snprintf(pos, 64, "%f", axis);
+	}
+	if (signbit(axis)) {
+		*pos++ = '-';
+	}
+	uint64_t micros = (uint64_t)llrint(value * 1e6);
+	pos = putuint(pos, micros / 1000000);
+	*pos++ = '.';
+	uint32_t fraction = (uint32_t)(micros % 1000000);
+	for (uint32_t divisor = 100000; divisor > 0; divisor /= 10) {
+		*pos++ = (char)('0' + fraction / divisor % 10);
+	}
+	return pos;
+}
+
+void twjson_event(const char* event, uint64_t timestamp, float axis, int retcode)
+{
+	if (jsonstream == NULL) {
+		return;
+	}
+	size_t eventlength = strlen(event);
+	if (eventlength > 64) {
+		return;
+	}
+// At most about 180 chars (an event name of 64, the largest float by snprintf), within jsonline
+	char* pos = putstr(jsonline, "{\"event\":\"", 10);
+	pos = putstr(pos, event, eventlength);
+	pos = putstr(pos, "\",\"ts\":", 7);
+	pos = putuint(pos, timestamp);
+	pos = putstr(pos, ",\"axis\":", 8);
+	pos = putaxis(pos, axis);
+	if (retcode >= 0) {
+		pos = putstr(pos, ",\"rc\":", 6);
+		pos = putuint(pos, (uint64_t)retcode);
+	}
+	pos = putstr(pos, "}\n", 2);
+	twjson_write((int)(pos - jsonline));
+}
+
+void twjson_stats(const char* phase, uint64_t samples, uint64_t meanns, uint64_t p50ns, uint64_t p99ns, uint64_t maxns)
+{
+	if (jsonstream == NULL) {
+		return;
+	}
+	twjson_write(snprintf(jsonline, sizeof(jsonline),
+		"{\"event\":\"stats\",\"phase\":\"%s\",\"samples\":%llu,\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu}\n",
+		phase, (unsigned long long)samples, (unsigned long long)meanns, (unsigned long long)p50ns,
+		(unsigned long long)p99ns, (unsigned long long)maxns));
+}
+
+void twjson_memory(uint32_t controllers, uint64_t registrybytes, uint64_t statebytes)
+{
+	if (jsonstream == NULL) {
+		return;
+	}
+	twjson_write(snprintf(jsonline, sizeof(jsonline), "{\"event\":\"memory\",\"controllers\":%u,\"registry_bytes\":%llu,\"state_bytes\":%llu}\n",
+		controllers, (unsigned long long)registrybytes, (unsigned long long)statebytes));
+}
+
+void twjson_schedule(uint64_t cycles, uint64_t wakeups, uint64_t wakeupsperhour, uint64_t overruns, uint64_t bursts)
+{
+	if (jsonstream == NULL) {
+		return;
+	}
+	twjson_write(snprintf(jsonline, sizeof(jsonline),
+		"{\"event\":\"schedule\",\"cycles\":%llu,\"wakeups\":%llu,\"wakeups_per_hour\":%llu,\"overruns\":%llu,\"bursts\":%llu}\n",
+		(unsigned long long)cycles, (unsigned long long)wakeups, (unsigned long long)wakeupsperhour,
+		(unsigned long long)overruns, (unsigned long long)bursts));
+}
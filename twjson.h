@@ -0,0 +1,39 @@
+/*
+	twjson.h
+
+	NDJSON event output of SaitekTrimwheel.cpp (option "--json"), published under MIT license like the main program.
+
+	For boot scripts that want to react on the Trimwheel's state in one long-running process instead of evaluating
+	the return code of a respawned program: stdout carries one JSON object per line and state transition, e.g.
+	{"event":"turned","ts":123456789,"axis":0.023529}
+	{"event":"exit","ts":123459999,"axis":0.023529,"rc":0}
+	* event : detected, appeared, disappeared, turned, timeout, exit
+	* ts : GameInput timestamp in microseconds (monotonic, since system start)
+	* axis : Trimwheel axis value (last known value for detected/appeared/disappeared/timeout)
+	* rc : return code of the program (exit event only)
+	With "--stats", the exit event is preceded by the statistics, one line per phase and one for the registry's memory:
+	{"event":"stats","phase":"cycle","samples":100,"mean_ns":2100,"p50_ns":1983,"p99_ns":4095,"max_ns":5120}
+	{"event":"memory","controllers":64,"registry_bytes":75000,"state_bytes":45056}
+	{"event":"schedule","cycles":5000,"wakeups":5000,"wakeups_per_hour":3600,"overruns":0,"bursts":1}
+	All other messages of the program are written to stderr in this mode.
+	Events are formatted into a static buffer (no heap allocation) and flushed line by line.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Move the console messages to stderr and keep the original stdout for the events
+// Has to be called before the first message, returns false if stdout can't be duplicated
+bool twjson_open();
+
+// Write one event line, 'retcode' is only written if it isn't negative
+void twjson_event(const char* event, uint64_t timestamp, float axis, int retcode);
+
+// Write the timing summary of one phase of the cycle loop (times in ns)
+void twjson_stats(const char* phase, uint64_t samples, uint64_t meanns, uint64_t p50ns, uint64_t p99ns, uint64_t maxns);
+
+// Write the memory of the device registry: its size and the part of it that holds the state of the controllers
+void twjson_memory(uint32_t controllers, uint64_t registrybytes, uint64_t statebytes);
+
+// Write the schedule of the cycle loop: cycles, wakeups (also per hour of run time), overruns and polling bursts
+void twjson_schedule(uint64_t cycles, uint64_t wakeups, uint64_t wakeupsperhour, uint64_t overruns, uint64_t bursts);
@@ -0,0 +1,150 @@
+/*
+	twlog.cpp
+
+	Asynchronous console logger for SaitekTrimwheel.cpp, see twlog.h
+
+	The ring buffer has a write index, only advanced by the producer after it has filled a record, and a read index,
+	only advanced by the writer thread after it has written a record. So a record between the two belongs to the
+	writer thread alone, the producer never touches it: if there is no room for a message, policy TWLOG_DROPNEW
+	drops the new message instead.
+	The writer thread only sleeps (condition variable) while the ring is empty, the producer takes the mutex
+	only to wake it up, i.e. once per burst of messages, never per record.
+*/
+
+#include "twlog.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct Twlogrecord
+{
+	uint16_t length;
+	char text[TWLOG_RECSIZE - sizeof(uint16_t)];
+};
+
+static Twlogrecord twlogring[TWLOG_RECORDS];
+static std::atomic<uint64_t> twlogwrite(0);			// next record to fill (producer)
+static std::atomic<uint64_t> twlogread(0);			// next record to write to stdout (writer thread)
+static std::atomic<uint64_t> twlogdropped(0);
+static std::atomic<bool> twlogsleeping(false);		// writer thread waits for records
+static std::atomic<bool> twlogstopping(false);
+static std::atomic<bool> twlogrunning(false);
+static Twlogpolicy twlogpolicy = TWLOG_BLOCK;
+static std::mutex twlogmutex;
+static std::condition_variable twlogwakeup;
+static std::thread twlogwriter;
+
+// Background writer thread: write the oldest record, then free it
+static void twlog_writerloop()
+{
+	for (;;) {
+		uint64_t readidx = twlogread.load();
+		if (readidx == twlogwrite.load()) {
+// Ring empty: now is the time to flush, then sleep until the producer wakes us
+			fflush(stdout);
+			std::unique_lock<std::mutex> lock(twlogmutex);
+			twlogsleeping.store(true);
+			twlogwakeup.wait(lock, [] { return (twlogread.load() != twlogwrite.load()) || twlogstopping.load(); });
+			twlogsleeping.store(false);
+			if ((twlogread.load() == twlogwrite.load()) && twlogstopping.load()) {
+				return;
+			}
+			continue;
+		}
+		const Twlogrecord* slot = &twlogring[readidx & (TWLOG_RECORDS - 1)];
+		fwrite(slot->text, 1, slot->length, stdout);
+		twlogread.store(readidx + 1);
+	}
+}
+
+bool twlog_start(Twlogpolicy policy)
+{
+	if (twlogrunning.load()) {
+		return true;
+	}
+	twlogpolicy = policy;
+	twlogstopping.store(false);
+	try {
+		twlogwriter = std::thread(twlog_writerloop);
+	} catch (...) {
+		return false;
+	}
+	twlogrunning.store(true);
+	return true;
+}
+
+void twlog_stop()
+{
+	if (!twlogrunning.load()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(twlogmutex);
+		twlogstopping.store(true);
+	}
+	twlogwakeup.notify_one();
+	twlogwriter.join();
+	twlogrunning.store(false);
+	fflush(stdout);
+}
+
+uint64_t twlog_dropped()
+{
+	return twlogdropped.load();
+}
+
+// Put one chunk of text (max. one record) into the ring buffer, waits for room
+static void twlog_put(const char* text, uint16_t length)
+{
+	uint64_t writeidx = twlogwrite.load(std::memory_order_relaxed);
+	while (writeidx - twlogread.load() >= TWLOG_RECORDS) {
+		std::this_thread::yield();
+	}
+	Twlogrecord* slot = &twlogring[writeidx & (TWLOG_RECORDS - 1)];
+	memcpy(slot->text, text, length);
+	slot->length = length;
+	twlogwrite.store(writeidx + 1);
+	if (twlogsleeping.load()) {
+		std::lock_guard<std::mutex> lock(twlogmutex);
+		twlogwakeup.notify_one();
+	}
+}
+
+void twlog_printf(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	if (!twlogrunning.load(std::memory_order_relaxed)) {
+		vprintf(format, args);
+		va_end(args);
+		return;
+	}
+	char message[1024];
+	int length = vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	if (length < 0) {
+		return;
+	}
+	if (length >= (int)sizeof(message)) {
+		length = sizeof(message) - 1;
+	}
+	const size_t chunksize = sizeof(((Twlogrecord*)0)->text);
+// Drop policy: the whole message or nothing, a message cut off in the middle would garble the next one
+	if (twlogpolicy == TWLOG_DROPNEW) {
+		uint64_t records = ((uint64_t)length + chunksize - 1) / chunksize;
+		if (twlogwrite.load(std::memory_order_relaxed) - twlogread.load() + records > TWLOG_RECORDS) {
+			twlogdropped.fetch_add(1);
+			return;
+		}
+	}
+	for (int offset = 0; offset < length; offset += chunksize) {
+		size_t chunk = ((size_t)(length - offset) < chunksize) ? (size_t)(length - offset) : chunksize;
+		twlog_put(message + offset, (uint16_t)chunk);
+	}
+}
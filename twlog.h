@@ -0,0 +1,51 @@
+/*
+	twlog.h
+
+	Asynchronous console logger for SaitekTrimwheel.cpp, published under MIT license like the main program.
+
+	twlog_printf() formats its message into a record of a lock-free single-producer/single-consumer ring buffer,
+	a background writer thread writes the records to stdout and flushes stdout whenever the ring is empty.
+	So a slow console or a pipe into the calling .bat script never blocks the detection path.
+	Before twlog_start() and after twlog_stop(), twlog_printf() writes directly to stdout (like printf).
+
+	Only one thread may call twlog_printf() at a time (single producer), in SaitekTrimwheel.cpp that's the main thread,
+	as the GameInput callbacks are called from our manual dispatch in the main thread too.
+
+	If the ring buffer is full, the overflow policy decides:
+	* TWLOG_BLOCK : wait until the writer thread has made room (no message is lost)
+	* TWLOG_DROPNEW : drop the new message as a whole (never waits), counted by twlog_dropped()
+	  (the messages already in the ring are the writer thread's, only it may free their records)
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Highest debug level compiled into SaitekTrimwheel (#DBG1 ... #DBG9 messages), set by CMake option SAITEKTW_MAXDBGLVL
+// Debug messages above this level are discarded at compile time (IFDBG in SaitekTrimwheel.cpp), 0 = no debug messages
+#ifndef TWLOG_MAXLVL
+#define TWLOG_MAXLVL	9
+#endif
+
+// Size of one record in bytes (longer messages are split into several records)
+#define TWLOG_RECSIZE	256
+// Number of records in the ring buffer, power of 2
+#define TWLOG_RECORDS	4096
+
+// Overflow policy if the ring buffer is full
+enum Twlogpolicy
+{
+	TWLOG_BLOCK = 0,
+	TWLOG_DROPNEW = 1
+};
+
+// Start the writer thread, returns false if it couldn't be started (twlog_printf then keeps writing directly)
+bool twlog_start(Twlogpolicy policy);
+
+// Write all pending records, stop the writer thread and switch back to direct output
+void twlog_stop();
+
+// printf-like output through the ring buffer
+void twlog_printf(const char* format, ...);
+
+// Number of messages dropped by overflow policy TWLOG_DROPNEW since program start
+uint64_t twlog_dropped();
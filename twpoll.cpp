@@ -0,0 +1,67 @@
+/*
+	twpoll.cpp
+
+	Adaptive cycle period of SaitekTrimwheel.cpp, see twpoll.h
+*/
+
+#include "twpoll.h"
+
+#include <stddef.h>
+
+static bool pollactive = false;
+static uint64_t pollbase = 0;			// periods in microseconds
+static uint64_t pollfast = 0;
+static uint64_t pollwindow = 0;
+static uint64_t pollidle = 0;
+static uint64_t pollcurrent = 0;		// period of the last cycle
+static uint64_t pollburstend = 0;		// timestamp the current burst ends (0: no burst yet)
+static uint64_t pollbursts = 0;
+
+void twpoll_init(const Twpollpolicy* policy, uint32_t basemsecs)
+{
+	pollactive = (policy != NULL);
+	pollbase = (uint64_t)basemsecs * 1000;
+	pollcurrent = pollbase;
+	pollburstend = 0;
+	pollbursts = 0;
+	if (pollactive) {
+		pollfast = (uint64_t)policy->fastmsecs * 1000;
+		pollwindow = (uint64_t)policy->windowmsecs * 1000;
+		pollidle = (uint64_t)policy->idlemsecs * 1000;
+	}
+}
+
+void twpoll_burst(uint64_t timestamp)
+{
+	if (!pollactive) {
+		return;
+	}
+// A movement during a burst only extends it
+	if (timestamp >= pollburstend) {
+		++pollbursts;
+	}
+	pollburstend = timestamp + pollwindow;
+}
+
+uint64_t twpoll_period(uint64_t timestamp, bool present)
+{
+	if (!pollactive) {
+		return pollbase;
+	}
+	if (timestamp < pollburstend) {
+		pollcurrent = pollfast;
+	} else {
+// Exponential back-off from the burst, a longer period than the target (e.g. idle -> present) is cut at once
+		uint64_t target = present ? pollbase : pollidle;
+		pollcurrent = (pollcurrent < target) ? pollcurrent * 2 : target;
+		if (pollcurrent > target) {
+			pollcurrent = target;
+		}
+	}
+	return pollcurrent;
+}
+
+uint64_t twpoll_bursts()
+{
+	return pollbursts;
+}
@@ -0,0 +1,42 @@
+/*
+	twpoll.h
+
+	Adaptive cycle period of SaitekTrimwheel.cpp (option "--adaptive[=fast,window,idle]"), published under MIT license
+	like the main program.
+
+	A fixed period is too slow right after the Trimwheel appears, when the user is about to turn it, and too frequent
+	while no Trimwheel is plugged in at all. With a policy, the cycle loop asks for the period of each cycle:
+	* burst : for 'windowmsecs' after the Trimwheel appeared or its axis moved (twpoll_burst), a cycle every 'fastmsecs'
+	* then the period doubles each cycle up to the normal period of -p/-v while the Trimwheel is present,
+	  or up to 'idlemsecs' while it is absent
+	Without a policy, the period is always the normal one.
+	How often the program wakes up for it is counted by twclock (twclock_wakeups), see README "Polling benchmark".
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Thresholds of the adaptive policy in msecs
+struct Twpollpolicy
+{
+	uint32_t fastmsecs;			// period during a burst
+	uint32_t windowmsecs;		// length of a burst
+	uint32_t idlemsecs;			// longest period while the Trimwheel is absent
+};
+
+// Defaults of "--adaptive": 100 Hz for 5 seconds, 10 seconds idle
+#define TWPOLL_FASTDFLT		10
+#define TWPOLL_WINDOWDFLT	5000
+#define TWPOLL_IDLEDFLT		10000
+
+// Set the normal period 'basemsecs' and the policy (NULL: fixed period, no adaptation)
+void twpoll_init(const Twpollpolicy* policy, uint32_t basemsecs);
+
+// Start a burst at GameInput timestamp 'timestamp' (microseconds): Trimwheel appeared or its axis moved
+void twpoll_burst(uint64_t timestamp);
+
+// Period in microseconds of the cycle starting at 'timestamp', 'present': the Trimwheel is plugged in
+uint64_t twpoll_period(uint64_t timestamp, bool present);
+
+// Number of bursts so far (a burst extended by further movements counts once)
+uint64_t twpoll_bursts();
@@ -0,0 +1,127 @@
+/*
+	twprofiles.h
+
+	Compile-time device profiles for SaitekTrimwheel.cpp, published under MIT license like the main program.
+
+	Each known controller is described by a profile type with constexpr members:
+	* vid, pid : Vendor-ID and Product-ID the profile is matched against (once, at connect time)
+	* axiscount, switchcount, buttoncount : what we read from the controller
+	* axisindex : the axis that decides if the controller is "ready", by the readiness detector of twready.h
+	All profiles are collected in the type list Twknownprofiles. When a controller connects, its profile id
+	(position in the list, 0 = no profile) is stored in the device registry. The cycle loop then calls the state handler
+	Twhandlertable<Twknownprofiles>::handlers[profile id], which is instantiated for each profile by the compiler,
+	so there is no runtime branching on VID/PID in the cycle loop.
+
+	To add a controller: define its profile type and append it to Twknownprofiles
+*/
+#pragma once
+
+#include "GameInput.h"
+#include "devregistry.h"
+
+// Saitek Pro Flight Trim Wheel: a single axis, no buttons or switches
+// The axis stays at zero after boot until the wheel has been turned some revolutions
+struct SaitekTrimwheelProfile
+{
+	static constexpr uint16_t vid = 0x06A3;
+	static constexpr uint16_t pid = 0x0BD4;
+	static constexpr uint32_t axiscount = 1;
+	static constexpr uint32_t switchcount = 0;
+	static constexpr uint32_t buttoncount = 0;
+	static constexpr uint32_t axisindex = 0;
+};
+
+// Type list of profiles
+template <typename... Profiles>
+struct Twprofilelist
+{
+	static constexpr uint8_t count = sizeof...(Profiles);
+};
+
+// All known profiles, profile id n (1, 2, ...) is the n-th type of this list
+typedef Twprofilelist<SaitekTrimwheelProfile> Twknownprofiles;
+
+// Find the profile id of a controller by its VID/PID, 0 if there is no profile for it
+template <typename... Profiles>
+inline uint8_t twprofile_find(Twprofilelist<Profiles...>, uint16_t vid, uint16_t pid)
+{
+	uint8_t profileid = 0;
+	uint8_t ix = 0;
+	((++ix, ((profileid == 0) && (Profiles::vid == vid) && (Profiles::pid == pid)) ? (profileid = ix) : 0), ...);
+	return profileid;
+}
+
+// Raise the counts of a decoded device information to what its profile reads,
+// so the state buffers sized from it hold at least the profile's axes, switches and buttons
+template <typename... Profiles>
+inline void twprofile_mincounts(Twprofilelist<Profiles...>, Devregdesc* desc)
+{
+	static constexpr uint32_t axiscounts[] = { 0, Profiles::axiscount... };
+	static constexpr uint32_t switchcounts[] = { 0, Profiles::switchcount... };
+	static constexpr uint32_t buttoncounts[] = { 0, Profiles::buttoncount... };
+	if (desc->nbraxes < axiscounts[desc->profile]) {
+		desc->nbraxes = axiscounts[desc->profile];
+	}
+	if (desc->nbrswch < switchcounts[desc->profile]) {
+		desc->nbrswch = switchcounts[desc->profile];
+	}
+	if (desc->nbrbutt < buttoncounts[desc->profile]) {
+		desc->nbrbutt = buttoncounts[desc->profile];
+	}
+}
+
+// State handler: read the state of 'reading' into the state buffers of 'entry'
+// Returns true if the controller is "ready" and its deciding axis value in *readyval
+typedef bool (*Twstatehandler)(IGameInputReading* reading, Devregistry* reg, Devregentry* entry, float* readyval);
+
+// Generic controller without profile: read all axes, switches, buttons by the counts decoded at connect time,
+// such a controller is never "ready"
+inline bool twgeneric_readstate(IGameInputReading* reading, Devregistry* reg, Devregentry* entry, float* readyval)
+{
+	reading->GetControllerAxisState(entry->desc.nbraxes, entry->axes);
+// Switches are returned as enum array, we keep them as bytes
+	if (entry->desc.nbrswch > 0) {
+		reading->GetControllerSwitchState(entry->desc.nbrswch, reg->switchscratch);
+		devreg_packswitches(reg->switchscratch, entry->desc.nbrswch, entry->switches);
+	}
+// Buttons are returned as bool array, we keep them packed as bitset
+	if (entry->desc.nbrbutt > 0) {
+		reading->GetControllerButtonState(entry->desc.nbrbutt, reg->buttonscratch);
+		devreg_packbuttons(reg->buttonscratch, entry->desc.nbrbutt, entry->buttons);
+	}
+	return false;
+}
+
+// Controller with profile: counts and the deciding axis are fixed at compile time,
+// the axis value of each reading goes into the controller's readiness detector
+template <class Profile>
+bool twprofile_readstate(IGameInputReading* reading, Devregistry* reg, Devregentry* entry, float* readyval)
+{
+	static_assert((Profile::axisindex < Profile::axiscount) && (Profile::axiscount <= DEVREG_MAXAXES) && (Profile::switchcount <= DEVREG_MAXSWITCHES)
+		&& (Profile::buttoncount <= DEVREG_MAXBUTTONS), "profile reads more than the device registry holds");
+	reading->GetControllerAxisState(Profile::axiscount, entry->axes);
+	if constexpr (Profile::switchcount > 0) {
+		reading->GetControllerSwitchState(Profile::switchcount, reg->switchscratch);
+		devreg_packswitches(reg->switchscratch, Profile::switchcount, entry->switches);
+	}
+	if constexpr (Profile::buttoncount > 0) {
+		reading->GetControllerButtonState(Profile::buttoncount, reg->buttonscratch);
+		devreg_packbuttons(reg->buttonscratch, Profile::buttoncount, entry->buttons);
+	}
+	if (twready_update(&entry->ready, reading->GetSequenceNumber(GameInputKindController), reading->GetTimestamp(),
+		entry->axes[Profile::axisindex])) {
+		*readyval = entry->axes[Profile::axisindex];
+		return true;
+	}
+	return false;
+}
+
+// Table of state handlers indexed by profile id: 0 = generic, then one instance per profile
+template <typename List>
+struct Twhandlertable;
+
+template <typename... Profiles>
+struct Twhandlertable<Twprofilelist<Profiles...>>
+{
+	static constexpr Twstatehandler handlers[] = { &twgeneric_readstate, &twprofile_readstate<Profiles>... };
+};
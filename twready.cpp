@@ -0,0 +1,86 @@
+/*
+	twready.cpp
+
+	Readiness detector of SaitekTrimwheel.cpp, see twready.h
+*/
+
+#include "twready.h"
+
+#include <math.h>
+#include <string.h>
+
+Twreadyconfig twready_config = { TWREADY_DEADBANDDFLT, TWREADY_POSITIONSDFLT, TWREADY_TRAVELDFLT, TWREADY_HOLDDFLT };
+
+void twready_reset(Twready* det)
+{
+	memset(det, 0, sizeof(*det));
+}
+
+// Ratio of 'value' to its minimum 'minimum', 1 if there is no minimum
+static float twready_ratio(float value, float minimum)
+{
+	return (minimum > 0) ? value / minimum : 1.0f;
+}
+
+// Confidence and decision by both rules, 'heldusecs' the time the position has held so far
+static bool twready_decide(Twready* det, uint64_t heldusecs)
+{
+	float bypositions = fminf(twready_ratio((float)det->positions, (float)twready_config.minpositions),
+		twready_ratio(det->travel, twready_config.mintravel));
+	float byhold = 0;
+	if (twready_config.holdmsecs > 0) {
+		byhold = fminf(twready_ratio(heldusecs / 1000.0f, (float)twready_config.holdmsecs),
+			twready_ratio(fabsf(det->value), twready_config.mintravel));
+	}
+	det->ready = ((det->positions >= twready_config.minpositions) && (det->travel >= twready_config.mintravel))
+		|| ((twready_config.holdmsecs > 0) && (fabsf(det->value) > twready_config.deadband)
+			&& (fabsf(det->value) >= twready_config.mintravel) && (heldusecs >= twready_config.holdmsecs * 1000ull));
+	det->confidence = det->ready ? 1.0f : fminf(fmaxf(bypositions, byhold), 1.0f);
+	return det->ready;
+}
+
+bool twready_update(Twready* det, uint64_t sequence, uint64_t timestamp, float value)
+{
+	if ((det->readings > 0) && (sequence <= det->lastseq)) {
+		return det->ready;
+	}
+	bool connectreading = (det->readings == 0);
+	bool nextreading = (sequence == det->lastseq + 1);
+	det->lastseq = sequence;
+	++det->readings;
+	if (det->ready) {
+		return true;
+	}
+// The last reading's position has held until this reading, if there is none missing in between (e.g. the cycle loop
+// without drain mode skips readings, the position may have changed back and forth since)
+	uint64_t heldusecs = (nextreading && (timestamp > det->positionts)) ? timestamp - det->positionts : 0;
+	if (!connectreading && twready_decide(det, heldusecs)) {
+		return true;
+	}
+	det->value = value;
+	float step = fabsf(value - det->position);
+	if (step <= twready_config.deadband) {
+// Still the same position, but with readings missing before, it is only known to hold since this one
+		if (!nextreading) {
+			det->positionts = timestamp;
+		}
+		return false;
+	}
+	det->position = value;
+	det->positionts = timestamp;
+	if (!connectreading) {
+		det->travel += step;
+		if (fabsf(value) > twready_config.deadband) {
+			++det->positions;
+		}
+	}
+	return twready_decide(det, 0);
+}
+
+bool twready_hold(Twready* det, uint64_t now)
+{
+	if (det->ready || (det->readings == 0)) {
+		return det->ready;
+	}
+	return twready_decide(det, (now > det->positionts) ? now - det->positionts : 0);
+}
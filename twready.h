@@ -0,0 +1,77 @@
+/*
+	twready.h
+
+	Readiness detector of SaitekTrimwheel.cpp (option "--ready=deadband,positions,travel[,hold]"), published under MIT
+	license like the main program.
+
+	The Trimwheel's axis stays exactly zero after boot until the wheel has been turned some revolutions. Deciding
+	"turned" by a non-zero axis value ends the run on any single spurious sample, and a wheel turned back to its
+	centre looks untouched. Instead, each reading's axis value is fed into a small streaming detector per controller
+	(part of its registry entry), which decides on the movement it has seen since the controller connected:
+	* deadband : a change of the axis by up to this much is noise; a larger change from the last counted position
+	  is a step, and the new value becomes the counted position (the start is 0, the axis of an untouched wheel)
+	* positions : distinct positions seen after the connect reading, away from 0. The connect reading itself isn't one
+	  (it is the wheel's state from before), nor is a step back to 0: a spike that falls back is a single position
+	* travel : the summed size of the steps after the connect reading
+	* hold : the axis, at least 'travel' away from 0, has held its position this long
+	The controller is ready as soon as both the positions and the travel reach their minimum, or its position has
+	held long enough. The second rule is for the cycle loop without drain mode, which only sees one reading per cycle,
+	so a whole turn may be a single position to it; the hold is measured from the position's reading to the next
+	reading, or to now for the current reading (twready_hold), and only over readings without a gap in their
+	sequence numbers (a skipped reading may have been back at 0). A connect reading away from 0 (the wheel turned
+	before the program started) is ready by the same rule.
+	The confidence is the larger of the two rules' ratios (each the smaller of its ratios, e.g. positions / minimum
+	and travel / minimum), at most 1, so it is 1 exactly when ready.
+	Once ready, a controller stays ready until it reconnects (twready_reset).
+	Each reading costs a few compares and additions, the state has a fixed size: O(1) time and memory per reading.
+	A reading not newer (by its sequence number) than the last evaluated one is ignored, so the cycle loop, drain mode
+	and the reading callback may all feed the same readings.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Thresholds of the detector
+struct Twreadyconfig
+{
+	float deadband;				// largest axis change that is noise
+	uint32_t minpositions;		// distinct positions after the connect reading before ready
+	float mintravel;			// summed axis travel before ready, and the least distance from 0 of a held position
+	uint32_t holdmsecs;			// time a position has to hold to be ready on its own (0: never)
+};
+
+// Defaults of "--ready": more than 1 LSB of the Trimwheel's 8 bit axis is a step, two positions and 0.1 of travel
+// (a spike that falls back is one position, a real turn runs through many), or a position held for 250 msecs
+// (a spike falls back within a few msecs)
+#define TWREADY_DEADBANDDFLT	0.01f
+#define TWREADY_POSITIONSDFLT	2
+#define TWREADY_TRAVELDFLT		0.1f
+#define TWREADY_HOLDDFLT		250
+
+// State of one controller, initialized by twready_reset
+struct Twready
+{
+	uint64_t lastseq;			// sequence number of the last evaluated reading
+	uint64_t positionts;		// GameInput timestamp (usecs) since which the counted position is known to hold
+	uint32_t readings;			// evaluated readings
+	uint32_t positions;			// distinct positions seen after the connect reading
+	float position;				// the last counted position
+	float value;				// axis value of the last evaluated reading (within the deadband of the position)
+	float travel;				// summed size of the steps after the connect reading
+	float confidence;			// 0...1, 1 = ready
+	bool ready;
+};
+
+// Thresholds used by all controllers (set by option "--ready")
+extern Twreadyconfig twready_config;
+
+// Forget all readings, e.g. the controller has (re)connected
+void twready_reset(Twready* det);
+
+// Evaluate the axis value 'value' of the reading with sequence number 'sequence' and GameInput timestamp 'timestamp',
+// returns true if ready
+bool twready_update(Twready* det, uint64_t sequence, uint64_t timestamp, float value);
+
+// The last evaluated reading is the current one at GameInput timestamp 'now': returns true if ready, by now
+// with the time its position has held
+bool twready_hold(Twready* det, uint64_t now);
@@ -0,0 +1,79 @@
+/*
+	twrotation.cpp
+
+	Rotation telemetry of the Trimwheel's axis, see twrotation.h
+*/
+
+#include "twrotation.h"
+
+#include <math.h>
+#include <string.h>
+
+static_assert((TWROTATION_RING & (TWROTATION_RING - 1)) == 0, "TWROTATION_RING must be a power of 2");
+
+void twrotation_init(Twrotation* rot, float units, float range)
+{
+	memset(rot, 0, sizeof(*rot));
+	rot->units = units;
+	rot->range = range;
+}
+
+void twrotation_restart(Twrotation* rot)
+{
+	rot->started = false;
+	rot->ringcount = 0;
+	rot->ringnext = 0;
+	rot->rate = 0;
+}
+
+void twrotation_update(Twrotation* rot, uint64_t sequence, uint64_t timestamp, float axis)
+{
+	if (rot->started && (sequence <= rot->lastseq)) {
+		return;
+	}
+	rot->lastseq = sequence;
+	++rot->readings;
+	if (rot->started) {
+		double step = (double)axis - rot->axis;
+		if (step > rot->range / 2.0) {
+			step -= rot->range;
+			++rot->wraps;
+		} else if (step < -rot->range / 2.0) {
+			step += rot->range;
+			++rot->wraps;
+		}
+		rot->rotation += step / rot->units;
+		rot->turned += fabs(step) / rot->units;
+	}
+	rot->started = true;
+	rot->axis = axis;
+// Rate over the ring: from its oldest sample (overwritten now, if the ring is full) to this reading
+	if (rot->ringcount > 0) {
+		const Twrotationsample& oldest = rot->ring[(rot->ringcount < TWROTATION_RING) ? 0 : rot->ringnext];
+		if (timestamp > oldest.timestamp) {
+			double measured = (rot->rotation - oldest.rotation) * 1000000.0 / (double)(timestamp - oldest.timestamp);
+			rot->rate += (measured - rot->rate) * TWROTATION_ALPHA;
+			if (fabs(rot->rate) > rot->peakrate) {
+				rot->peakrate = fabs(rot->rate);
+			}
+		}
+	}
+	rot->ring[rot->ringnext].timestamp = timestamp;
+	rot->ring[rot->ringnext].rotation = rot->rotation;
+	rot->ringnext = (rot->ringnext + 1) & (TWROTATION_RING - 1);
+	if (rot->ringcount < TWROTATION_RING) {
+		++rot->ringcount;
+	}
+}
+
+double twrotation_rate(const Twrotation* rot, uint64_t now)
+{
+	if (rot->ringcount == 0) {
+		return 0;
+	}
+	uint64_t last = rot->ring[(rot->ringnext - 1) & (TWROTATION_RING - 1)].timestamp;
+	if ((now > last) && (now - last >= TWROTATION_IDLEUSECS)) {
+		return 0;
+	}
+	return rot->rate;
+}
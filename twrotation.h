@@ -0,0 +1,72 @@
+/*
+	twrotation.h
+
+	Rotation telemetry of the Trimwheel's axis for SaitekTrimwheel.cpp (option "--rotation[=units]"), published under
+	MIT license like the main program.
+
+	The Trimwheel is an endless wheel, its axis runs through its range and wraps around at the ends. GameInput
+	normalizes controller axes to 0...1 and gives no other range per axis, so the range is 1.0 by default; an axis
+	of -1...1 (e.g. a replay of another source) has a range of 2.0 (option "--rotation=units,range"). Each reading's
+	axis value is fed in (twrotation_update), and the steps between readings are summed up into a cumulative rotation:
+	a step of more than half the axis range is a wrap-around, so it is counted as the shorter step across the end instead.
+	* rotation : the summed signed steps in revolutions, 'units' of the axis per revolution (default: the whole range)
+	* turned : the summed absolute steps in revolutions, its whole part is the count of revolutions turned
+	* rate : revolutions per second over the last TWROTATION_RING readings (a ring of their timestamps and rotations),
+	  smoothed by an exponential moving average, so a single reading with a jittered timestamp doesn't spike it
+	Each reading costs a few additions and one division, the ring has a fixed size: constant time and memory
+	whatever the reading rate (1 kHz with drain mode "-d" or event mode "-e").
+	As with twready.h, a reading not newer (by its sequence number) than the last one is ignored.
+	The wheel sends no readings while it stands still, so the rate of a wheel without a reading for
+	TWROTATION_IDLEUSECS is 0 (twrotation_rate).
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Readings in the ring the rate is measured over (power of 2): 16 ms at 1 kHz
+#ifndef TWROTATION_RING
+#define TWROTATION_RING			16
+#endif
+// Weight of a new rate measurement in the moving average
+#define TWROTATION_ALPHA		0.25
+// A wheel without a reading for this long (usecs) stands still
+#define TWROTATION_IDLEUSECS	200000
+// Default axis range: GameInput's 0...1, and the axis units per revolution: the whole axis range
+#define TWROTATION_RANGEDFLT	1.0f
+#define TWROTATION_UNITSDFLT	TWROTATION_RANGEDFLT
+
+struct Twrotationsample
+{
+	uint64_t timestamp;			// GameInput timestamp of the reading (usecs)
+	double rotation;			// cumulative rotation at this reading (revolutions)
+};
+
+struct Twrotation
+{
+	float units;				// axis units per revolution
+	float range;				// span of the axis values, a step of more than half of it is a wrap-around
+	bool started;				// a reading since the start or the last reconnect, 'axis' is valid
+	float axis;					// axis value of the last reading
+	uint64_t lastseq;			// sequence number of the last reading
+	uint64_t readings;			// readings evaluated
+	uint64_t wraps;				// wrap-arounds of the axis
+	double rotation;			// summed signed steps (revolutions)
+	double turned;				// summed absolute steps (revolutions)
+	double rate;				// smoothed revolutions per second
+	double peakrate;			// largest absolute smoothed rate
+	uint32_t ringcount;			// samples in the ring, up to TWROTATION_RING
+	uint32_t ringnext;			// next sample to fill
+	Twrotationsample ring[TWROTATION_RING];
+};
+
+// Start from scratch with 'units' axis units per revolution of an axis whose values span 'range'
+void twrotation_init(Twrotation* rot, float units, float range);
+
+// The Trimwheel has (re)connected: its axis starts over, the counts go on
+void twrotation_restart(Twrotation* rot);
+
+// Evaluate the axis value 'axis' of the reading with sequence number 'sequence' and GameInput timestamp 'timestamp'
+void twrotation_update(Twrotation* rot, uint64_t sequence, uint64_t timestamp, float axis);
+
+// Smoothed revolutions per second at GameInput timestamp 'now', 0 if the wheel stands still
+double twrotation_rate(const Twrotation* rot, uint64_t now);
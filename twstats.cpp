@@ -0,0 +1,208 @@
+/*
+	twstats.cpp
+
+	Per-phase timing statistics of SaitekTrimwheel.cpp, see twstats.h
+*/
+
+#include "twstats.h"
+#include "twlog.h"
+
+#include <windows.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+bool twstats_active = false;
+
+struct Twstatshisto
+{
+	uint64_t count;
+	uint64_t sumns;
+	uint64_t maxns;
+	uint32_t buckets[TWSTATS_BUCKETS];
+};
+
+static Twstatshisto statshisto[TWSTATS_PHASES];
+static const char* phasenames[TWSTATS_PHASES] = { "cycle", "Dispatch", "GetCurrentReading", "GetDeviceInfo",
+	"state extraction", "reading drain", "change detection", "printing", "_kbhit drain", "Beep", "event latency" };
+static double nspertick = 1.0;
+static double boundaryns = 0;		// calibrated cost of one phase boundary in ns
+static uint64_t cyclestart;			// ticks at twstats_begin
+static uint64_t lastboundary;		// ticks at the last boundary of the cycle
+static uint64_t skips;				// boundaries without a phase (twstats_skip)
+
+// Bucket of a value: exact below 8, else 8 sub-buckets per power of two
+static uint32_t bucketof(uint64_t value)
+{
+	if (value < 8) {
+		return (uint32_t)value;
+	}
+// Highest bit set: one instruction instead of a loop, the bucket is computed for every sample
+#ifdef _MSC_VER
+	unsigned long exponent;
+	_BitScanReverse64(&exponent, value);
+#else
+	uint32_t exponent = 63 - (uint32_t)__builtin_clzll(value);
+#endif
+	uint32_t sub = (uint32_t)(value >> (exponent - 3)) & 7;
+	return (exponent - 2) * 8 + sub;
+}
+
+// Highest value of a bucket
+static uint64_t bucketmax(uint32_t bucket)
+{
+	if (bucket < 8) {
+		return bucket;
+	}
+	uint32_t exponent = bucket / 8 + 2;
+	uint64_t lower = (uint64_t)(8 + bucket % 8) << (exponent - 3);
+	return lower + ((uint64_t)1 << (exponent - 3)) - 1;
+}
+
+static uint64_t qpcnow()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)counter.QuadPart;
+}
+
+#ifndef TWSTATS_TSC
+uint64_t twstats_now()
+{
+	return qpcnow();
+}
+#endif
+
+void twstats_begin()
+{
+	if (twstats_active) {
+		cyclestart = twstats_now();
+		lastboundary = cyclestart;
+	}
+}
+
+void twstats_markat(Twstatsphase phase, uint64_t now)
+{
+	twstats_addns(phase, (uint64_t)((now - lastboundary) * nspertick));
+	lastboundary = now;
+}
+
+void twstats_skip()
+{
+	if (twstats_active) {
+		lastboundary = twstats_now();
+		++skips;
+	}
+}
+
+uint64_t twstats_end()
+{
+	if (!twstats_active) {
+		return 0;
+	}
+	uint64_t ns = (uint64_t)((lastboundary - cyclestart) * nspertick);
+	twstats_addns(TWSTATS_CYCLE, ns);
+	return ns;
+}
+
+void twstats_add(Twstatsphase phase, uint64_t start)
+{
+	twstats_addns(phase, (uint64_t)((twstats_now() - start) * nspertick));
+}
+
+void twstats_addns(Twstatsphase phase, uint64_t ns)
+{
+	Twstatshisto* histo = &statshisto[phase];
+	++histo->count;
+	histo->sumns += ns;
+	if (ns > histo->maxns) {
+		histo->maxns = ns;
+	}
+	++histo->buckets[bucketof(ns)];
+}
+
+void twstats_init()
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	nspertick = 1e9 / (double)frequency.QuadPart;
+#ifdef TWSTATS_TSC
+// The TSC's rate: ticks during 10 ms of QueryPerformanceCounter (busy, a Sleep() may be shorter or longer)
+	uint64_t qpcstart = qpcnow();
+	uint64_t tscstart = twstats_now();
+	uint64_t qpcend;
+	do {
+		qpcend = qpcnow();
+	} while ((qpcend - qpcstart) * nspertick < 10e6);
+	uint64_t tscend = twstats_now();
+	if (tscend > tscstart) {
+		nspertick = (qpcend - qpcstart) * nspertick / (double)(tscend - tscstart);
+	}
+#endif
+// Calibrate: a bunch of boundaries into a phase that is reset afterwards
+	twstats_active = true;
+	const int calibrations = 1000;
+	twstats_begin();
+	for (int ix = 0; ix < calibrations; ++ix) {
+		twstats_mark(TWSTATS_BEEP);
+	}
+	boundaryns = (lastboundary - cyclestart) * nspertick / calibrations;
+	statshisto[TWSTATS_BEEP] = Twstatshisto();
+}
+
+// Value below which 'percent' of the samples are
+static uint64_t percentile(const Twstatshisto* histo, double percent)
+{
+	uint64_t target = (uint64_t)(histo->count * percent / 100.0 + 0.5);
+	if (target == 0) {
+		target = 1;
+	}
+	uint64_t cumulated = 0;
+	for (uint32_t bucket = 0; bucket < TWSTATS_BUCKETS; ++bucket) {
+		cumulated += histo->buckets[bucket];
+		if (cumulated >= target) {
+			uint64_t value = bucketmax(bucket);
+			return (value < histo->maxns) ? value : histo->maxns;
+		}
+	}
+	return histo->maxns;
+}
+
+void twstats_report()
+{
+	twlog_printf("Phase timing (usecs)      samples        p50        p99        max\n");
+	uint64_t samples = 0;
+	for (int phase = 0; phase < TWSTATS_PHASES; ++phase) {
+		const Twstatshisto* histo = &statshisto[phase];
+		if (phase != TWSTATS_OBSERVE) {			// not timed by us
+			samples += histo->count;
+		}
+		if (histo->count == 0) {
+			continue;
+		}
+		twlog_printf("  %-20s %12llu %10.1f %10.1f %10.1f\n", phasenames[phase], (unsigned long long)histo->count,
+			percentile(histo, 50) / 1000.0, percentile(histo, 99) / 1000.0, histo->maxns / 1000.0);
+	}
+// The cycle time contains all other phases, so the instrumentation's share is the cost of all boundaries (one per
+// sample, the cycle's one is its start, and the skips) vs. the summed cycle time
+	const Twstatshisto* cycles = &statshisto[TWSTATS_CYCLE];
+	if (cycles->sumns > 0) {
+		twlog_printf("Instrumentation: %.0f ns per sample, %.3f%% of the cycle time\n", boundaryns,
+			(samples + skips) * boundaryns * 100.0 / cycles->sumns);
+	}
+}
+
+bool twstats_summary(Twstatsphase phase, Twstatssummary* summary)
+{
+	const Twstatshisto* histo = &statshisto[phase];
+	if (histo->count == 0) {
+		return false;
+	}
+	summary->name = phasenames[phase];
+	summary->samples = histo->count;
+	summary->meanns = histo->sumns / histo->count;
+	summary->p50ns = percentile(histo, 50);
+	summary->p99ns = percentile(histo, 99);
+	summary->maxns = histo->maxns;
+	return true;
+}
@@ -0,0 +1,138 @@
+/*
+	twstats.h
+
+	Per-phase timing statistics of SaitekTrimwheel.cpp (option "--stats[=N]"), published under MIT license like the main program.
+
+	Each phase of the cycle loop is timed by the TSC (x86/x64, calibrated against QueryPerformanceCounter at start,
+	else QueryPerformanceCounter itself) and recorded into a log-linear histogram: values 0...7 ns exactly, above that
+	8 sub-buckets per power of two (max. 12.5% error).
+	At program end (and every N seconds with "--stats=N"), p50/p99/max per phase are printed.
+	The cost of the timing itself is calibrated at start, its share of the measured cycle time is printed too.
+
+	The phases of a cycle are chained: one read of the clock per phase boundary, the end of a phase is the start
+	of the next one, so a phase's sample is the time since the previous boundary (code between two timed phases
+	counts to the later one):
+		twstats_begin();					// cycle start
+		... Dispatch ...
+		twstats_mark(TWSTATS_DISPATCH);
+		... GetCurrentReading ...
+		twstats_mark(TWSTATS_READING);
+		... a tone, not part of any phase ...
+		twstats_skip();
+		...
+		uint64_t cyclens = twstats_end();	// the cycle up to the last boundary
+	Rare phases nested into others (GetDeviceInfo in the device callback, Beep) are timed by a scope instead, with
+	two reads of the clock, it doesn't touch the chain:
+		{
+			Twstatsscope statsscope(TWSTATS_DEVINFO);
+			... the phase ...
+		}
+	If statistics are off (twstats_active false), a boundary or scope costs just the test of the flag.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TWSTATS_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// Phases of the cycle loop
+enum Twstatsphase
+{
+	TWSTATS_CYCLE = 0,			// whole cycle without the wait at its end
+	TWSTATS_DISPATCH,			// dispatcher->Dispatch(0), including our device callback
+	TWSTATS_READING,			// GetCurrentReading()
+	TWSTATS_DEVINFO,			// GetDeviceInfo() (only at connect time, see decodedeviceinfo)
+	TWSTATS_STATE,				// state extraction by the profile's state handler
+	TWSTATS_DRAIN,				// readings of the Trimwheel since the last cycle (drain mode, see drainreadings)
+	TWSTATS_DIFF,				// change detection of all controllers' state against the last cycle (devreg_diffstate)
+	TWSTATS_PRINT,				// formatting/printing of the controller state
+	TWSTATS_KBHIT,				// _kbhit()/_getch() drain
+	TWSTATS_BEEP,				// Beep()
+	TWSTATS_OBSERVE,			// no phase: latency from a device event/reading (GameInput timestamp) to the main loop seeing it
+	TWSTATS_PHASES				// number of phases
+};
+
+// Histogram buckets: 8 exact values, then 8 sub-buckets for each power of two from 2^3 to 2^63
+#define TWSTATS_BUCKETS	(8 + 61 * 8)
+
+// Statistics are recorded only while this flag is set (by twstats_init)
+extern bool twstats_active;
+
+// Switch statistics on, calibrate the clock and the cost of one phase boundary
+void twstats_init();
+
+// Current time in clock ticks (TSC or QueryPerformanceCounter)
+#ifdef TWSTATS_TSC
+inline uint64_t twstats_now()
+{
+	return __rdtsc();
+}
+#else
+uint64_t twstats_now();
+#endif
+
+// Start of a cycle: the first phase starts now
+void twstats_begin();
+
+// Boundary at 'now': the time since the last boundary is a sample of the phase
+void twstats_markat(Twstatsphase phase, uint64_t now);
+
+// End of a phase: the time since the last boundary is one sample of it, the next phase starts now
+inline void twstats_mark(Twstatsphase phase)
+{
+	if (twstats_active) {
+		twstats_markat(phase, twstats_now());
+	}
+}
+
+// Boundary without a phase: the time since the last boundary isn't recorded (it is still part of the cycle)
+void twstats_skip();
+
+// End of the cycle at the last boundary: records the cycle and returns its time in ns (0 if statistics are off)
+uint64_t twstats_end();
+
+// Record the time since 'start' (from twstats_now) for a phase
+void twstats_add(Twstatsphase phase, uint64_t start);
+
+// Record a time in ns measured otherwise (e.g. by GameInput timestamps)
+void twstats_addns(Twstatsphase phase, uint64_t ns);
+
+// Print p50/p99/max of all phases with samples and the share of the instrumentation in the cycle time (by twlog_printf)
+void twstats_report();
+
+// Summary of one phase in ns, for machine-readable reports (--json)
+struct Twstatssummary
+{
+	const char* name;
+	uint64_t samples;
+	uint64_t meanns;
+	uint64_t p50ns;
+	uint64_t p99ns;
+	uint64_t maxns;
+};
+
+// Fill the summary of a phase, returns false if the phase has no samples
+bool twstats_summary(Twstatsphase phase, Twstatssummary* summary);
+
+// Times the lifetime of the scope as one sample of a phase
+struct Twstatsscope
+{
+	Twstatsphase phase;
+	uint64_t start;
+	explicit Twstatsscope(Twstatsphase scopephase) : phase(scopephase), start(twstats_active ? twstats_now() : 0)
+	{
+	}
+	~Twstatsscope()
+	{
+		if (start != 0) {
+			twstats_add(phase, start);
+		}
+	}
+};
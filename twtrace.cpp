@@ -0,0 +1,247 @@
+/*
+	twtrace.cpp
+
+	Binary trace file of SaitekTrimwheel.cpp, see twtrace.h
+
+	The file is mapped as a whole (header and all pre-allocated records). When the mapped records are used up,
+	the view is unmapped and the file is mapped again TWTRACE_CHUNK records larger (CreateFileMapping extends the file).
+	On close, the file is cut to the records really written.
+*/
+
+#include "twtrace.h"
+
+#include <windows.h>
+#include <string.h>
+
+static HANDLE tracefile = INVALID_HANDLE_VALUE;
+static HANDLE tracemapping = NULL;
+static Twtraceheader* traceheader = NULL;		// start of the mapped view
+static Twtracerecord* tracerecords = NULL;		// first record behind the header
+static uint64_t tracecapacity = 0;				// records fitting into the mapped view
+static uint64_t tracewritten = 0;
+static uint64_t tracelost = 0;
+
+// Map the file with room for 'capacity' records, extends the file if it is shorter
+static bool twtrace_map(uint64_t capacity)
+{
+	uint64_t filesize = sizeof(Twtraceheader) + capacity * sizeof(Twtracerecord);
+	tracemapping = CreateFileMappingA(tracefile, NULL, PAGE_READWRITE, (DWORD)(filesize >> 32), (DWORD)filesize, NULL);
+	if (tracemapping == NULL) {
+		return false;
+	}
+	traceheader = (Twtraceheader*)MapViewOfFile(tracemapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)filesize);
+	if (traceheader == NULL) {
+		CloseHandle(tracemapping);
+		tracemapping = NULL;
+		return false;
+	}
+	tracerecords = (Twtracerecord*)(traceheader + 1);
+	tracecapacity = capacity;
+	return true;
+}
+
+static void twtrace_unmap()
+{
+	if (traceheader != NULL) {
+		UnmapViewOfFile(traceheader);
+		traceheader = NULL;
+		tracerecords = NULL;
+	}
+	if (tracemapping != NULL) {
+		CloseHandle(tracemapping);
+		tracemapping = NULL;
+	}
+	tracecapacity = 0;
+}
+
+bool twtrace_open(const char* filename)
+{
+	tracefile = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (tracefile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER filesize;
+	if (!GetFileSizeEx(tracefile, &filesize)) {
+		twtrace_close();
+		return false;
+	}
+	if (filesize.QuadPart == 0) {
+// New trace file: pre-allocate the first chunk and write the header
+		if (!twtrace_map(TWTRACE_CHUNK)) {
+			twtrace_close();
+			return false;
+		}
+		memset(traceheader, 0, sizeof(Twtraceheader));
+		memcpy(traceheader->magic, TWTRACE_MAGIC, sizeof(traceheader->magic));
+		traceheader->version = TWTRACE_VERSION;
+		traceheader->recordsize = sizeof(Twtracerecord);
+		return true;
+	}
+// Existing file: continue it, but never overwrite something that isn't our trace
+	if (filesize.QuadPart < (LONGLONG)sizeof(Twtraceheader)) {
+		twtrace_close();
+		return false;
+	}
+	Twtraceheader header;
+	DWORD bytesread = 0;
+	if (!ReadFile(tracefile, &header, sizeof(header), &bytesread, NULL) || (bytesread != sizeof(header))
+		|| (memcmp(header.magic, TWTRACE_MAGIC, sizeof(header.magic)) != 0)
+		|| (header.version != TWTRACE_VERSION) || (header.recordsize != sizeof(Twtracerecord))) {
+		twtrace_close();
+		return false;
+	}
+	if (!twtrace_map(header.recordcount + TWTRACE_CHUNK)) {
+		twtrace_close();
+		return false;
+	}
+	return true;
+}
+
+// Next free record, maps the next chunk if the mapped records are used up
+// Returns NULL (record lost) if the file can't grow anymore (disk full)
+static Twtracerecord* twtrace_next()
+{
+	if (traceheader == NULL) {
+		if (tracefile != INVALID_HANDLE_VALUE) {
+			++tracelost;
+		}
+		return NULL;
+	}
+	uint64_t count = traceheader->recordcount;
+	if (count >= tracecapacity) {
+		twtrace_unmap();
+		if (!twtrace_map(count + TWTRACE_CHUNK)) {
+// Map at least the records written so far again, so close can cut the file correctly
+			twtrace_map(count);
+			++tracelost;
+			return NULL;
+		}
+	}
+	return &tracerecords[count];
+}
+
+// Publish the record filled at tracerecords[recordcount]
+static void twtrace_commit()
+{
+	++traceheader->recordcount;
+	++tracewritten;
+}
+
+void twtrace_reading(uint16_t device, uint16_t vid, uint16_t pid, uint64_t sequence, uint64_t timestamp,
+		const float* axes, uint32_t nbraxes, const uint64_t* buttons, uint32_t nbrbutt)
+{
+	Twtracerecord* record = twtrace_next();
+	if (record == NULL) {
+		return;
+	}
+	memset(record, 0, sizeof(Twtracerecord));
+	record->kind = TWTRACE_READING;
+	record->event = TWTRACE_EV_NONE;
+	record->device = device;
+	record->vid = vid;
+	record->pid = pid;
+	record->sequence = sequence;
+	record->timestamp = timestamp;
+	record->nbraxes = nbraxes;
+	record->nbrbutt = nbrbutt;
+	uint32_t axescopy = (nbraxes < TWTRACE_AXES) ? nbraxes : TWTRACE_AXES;
+	if (axescopy > 0) {
+		memcpy(record->axes, axes, axescopy * sizeof(float));
+	}
+	uint32_t wordscopy = (nbrbutt + 63) / 64;
+	if (wordscopy > TWTRACE_BUTTONWORDS) {
+		wordscopy = TWTRACE_BUTTONWORDS;
+	}
+	if (wordscopy > 0) {
+		memcpy(record->buttons, buttons, wordscopy * sizeof(uint64_t));
+	}
+	twtrace_commit();
+}
+
+void twtrace_event(uint16_t device, uint16_t vid, uint16_t pid, Twtraceevent event, uint64_t timestamp)
+{
+	Twtracerecord* record = twtrace_next();
+	if (record == NULL) {
+		return;
+	}
+	memset(record, 0, sizeof(Twtracerecord));
+	record->kind = TWTRACE_EVENT;
+	record->event = (uint8_t)event;
+	record->device = device;
+	record->vid = vid;
+	record->pid = pid;
+	record->timestamp = timestamp;
+	twtrace_commit();
+}
+
+void twtrace_callback(uint16_t device, uint16_t vid, uint16_t pid, uint32_t nbraxes, uint32_t nbrbutt, uint32_t nbrswch,
+		uint32_t currentstatus, uint32_t previousstatus, uint64_t timestamp)
+{
+	Twtracerecord* record = twtrace_next();
+	if (record == NULL) {
+		return;
+	}
+	memset(record, 0, sizeof(Twtracerecord));
+	record->kind = TWTRACE_CALLBACK;
+// GameInputDeviceConnected is bit 0 of the device status
+	if ((currentstatus & 1) && !(previousstatus & 1)) {
+		record->event = TWTRACE_EV_CONNECTED;
+	} else if (!(currentstatus & 1) && (previousstatus & 1)) {
+		record->event = TWTRACE_EV_DISCONNECTED;
+	}
+	record->device = device;
+	record->vid = vid;
+	record->pid = pid;
+	record->sequence = nbrswch;
+	record->timestamp = timestamp;
+	record->nbraxes = nbraxes;
+	record->nbrbutt = nbrbutt;
+	record->buttons[0] = currentstatus;
+	record->buttons[1] = previousstatus;
+	twtrace_commit();
+}
+
+void twtrace_exit(int retcode, uint64_t timestamp)
+{
+	Twtracerecord* record = twtrace_next();
+	if (record == NULL) {
+		return;
+	}
+	memset(record, 0, sizeof(Twtracerecord));
+	record->kind = TWTRACE_EVENT;
+	record->event = TWTRACE_EV_EXIT;
+	record->device = TWTRACE_NODEVICE;
+	record->sequence = (uint64_t)retcode;
+	record->timestamp = timestamp;
+	twtrace_commit();
+}
+
+uint64_t twtrace_written()
+{
+	return tracewritten;
+}
+
+uint64_t twtrace_lost()
+{
+	return tracelost;
+}
+
+void twtrace_close()
+{
+	if (tracefile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	uint64_t count = (traceheader != NULL) ? traceheader->recordcount : 0;
+	bool mapped = (traceheader != NULL);
+	twtrace_unmap();
+// Cut the pre-allocated records that haven't been used
+	if (mapped) {
+		LARGE_INTEGER filesize;
+		filesize.QuadPart = (LONGLONG)(sizeof(Twtraceheader) + count * sizeof(Twtracerecord));
+		if (SetFilePointerEx(tracefile, filesize, NULL, FILE_BEGIN)) {
+			SetEndOfFile(tracefile);
+		}
+	}
+	CloseHandle(tracefile);
+	tracefile = INVALID_HANDLE_VALUE;
+}
@@ -0,0 +1,115 @@
+/*
+	twtrace.h
+
+	Binary trace file of SaitekTrimwheel.cpp (option "-T <file>"), published under MIT license like the main program.
+
+	For the post-mortem analysis of boots where the Trimwheel "didn't come up", every evaluated reading and every
+	device event (connect, disconnect, detected, appeared, disappeared, turned ...) is appended as a fixed-width
+	record of 64 bytes to a trace file. The file is memory-mapped and pre-allocated in chunks of TWTRACE_CHUNK records,
+	so writing a record is a plain memory copy: no allocation and no system call, except when the next chunk is mapped.
+	An existing trace file is continued, so the traces of several boots can be collected in one file.
+
+	File layout: one Twtraceheader, followed by Twtraceheader.recordcount records of Twtracerecord (little endian,
+	as written by the x86/x64 CPU). The file may be longer than that (pre-allocated, after a crash), the record count
+	in the header is authoritative.
+
+	twtracedecode.cpp converts a trace file to CSV, it only needs the definitions of this header.
+
+	Record and replay: each run writes a session start event first and an exit event with its return code last,
+	and traces the arguments of every device callback (kind TWTRACE_CALLBACK). With drain mode "-d", every reading
+	of the watched controllers is traced too, so a trace holds the complete GameInput input of a boot session.
+	The fake GameInput build (option "--replay <file>") feeds a session of a trace file back into the program.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// File identification and format version
+#define TWTRACE_MAGIC		"TWTRACE1"
+#define TWTRACE_VERSION		1
+// Number of axes and button words (64 buttons each) stored per record, more aren't traced
+#define TWTRACE_AXES		4
+#define TWTRACE_BUTTONWORDS	2
+// File growth step in records (64 bytes each, so 4 MB)
+#define TWTRACE_CHUNK		65536
+// Device index of events that don't belong to a registered controller (e.g. "Trimwheel not found")
+#define TWTRACE_NODEVICE	0xFFFF
+
+// Record kinds
+enum Twtracekind
+{
+	TWTRACE_READING = 1,			// state of a controller as evaluated by the program
+	TWTRACE_EVENT = 2,				// device or status transition, see Twtraceevent
+	TWTRACE_CALLBACK = 3			// arguments of a device callback (deviceChangeCallback), see Twtracerecord
+};
+
+// Status transitions (Twtracerecord.event)
+enum Twtraceevent
+{
+	TWTRACE_EV_NONE = 0,			// reading records
+	TWTRACE_EV_CONNECTED = 1,		// controller registered by the device callback
+	TWTRACE_EV_DISCONNECTED = 2,	// controller removed by the device callback
+	TWTRACE_EV_DETECTED = 3,		// Trimwheel found in the first cycle
+	TWTRACE_EV_APPEARED = 4,		// Trimwheel found again in a later cycle
+	TWTRACE_EV_DISAPPEARED = 5,		// Trimwheel gone since the last cycle
+	TWTRACE_EV_NOTFOUND = 6,		// Trimwheel not there in this cycle and the last one
+	TWTRACE_EV_TURNED = 7,			// Trimwheel axis not zero, program ends with RC=0
+	TWTRACE_EV_START = 8,			// session start (trace opened), timestamp of the program's virtual time 0 on replay
+	TWTRACE_EV_EXIT = 9				// program end, return code in Twtracerecord.sequence
+};
+
+// File header, 64 bytes
+struct Twtraceheader
+{
+	char magic[8];					// TWTRACE_MAGIC without terminating zero
+	uint32_t version;				// TWTRACE_VERSION
+	uint32_t recordsize;			// sizeof(Twtracerecord)
+	uint64_t recordcount;			// number of valid records following the header
+	uint8_t reserved[40];
+};
+
+// One trace record, 64 bytes
+// Device callback records (TWTRACE_CALLBACK): event is TWTRACE_EV_CONNECTED/DISCONNECTED if the connected status changed
+// (else TWTRACE_EV_NONE), device is TWTRACE_NODEVICE for controllers not kept in the registry, nbraxes/nbrbutt
+// are the controller's counts, sequence its number of switches, buttons[0]/[1] the current/previous GameInputDeviceStatus
+struct Twtracerecord
+{
+	uint8_t kind;					// Twtracekind
+	uint8_t event;					// Twtraceevent
+	uint16_t device;				// index of the controller in the device registry pool, TWTRACE_NODEVICE if none
+	uint16_t vid;					// Vendor-ID
+	uint16_t pid;					// Product-ID
+	uint64_t sequence;				// GameInput sequence number of the reading (GameInputKindController), 0 for events
+	uint64_t timestamp;				// GameInput timestamp (microseconds)
+	uint32_t nbraxes;				// number of axes of the controller (the first TWTRACE_AXES are stored)
+	uint32_t nbrbutt;				// number of buttons of the controller (the first TWTRACE_BUTTONWORDS*64 are stored)
+	float axes[TWTRACE_AXES];
+	uint64_t buttons[TWTRACE_BUTTONWORDS];	// button n in buttons[n/64] bit n%64, like the device registry's bitset
+};
+
+static_assert(sizeof(Twtraceheader) == 64, "Twtraceheader must be 64 bytes");
+static_assert(sizeof(Twtracerecord) == 64, "Twtracerecord must be 64 bytes");
+
+// Open (create or continue) a trace file, returns false if it can't be opened or isn't a trace file
+bool twtrace_open(const char* filename);
+
+// Append a reading: the controller's state buffers after the state handler has read 'sequence'
+void twtrace_reading(uint16_t device, uint16_t vid, uint16_t pid, uint64_t sequence, uint64_t timestamp,
+		const float* axes, uint32_t nbraxes, const uint64_t* buttons, uint32_t nbrbutt);
+
+// Append a device event or status transition
+void twtrace_event(uint16_t device, uint16_t vid, uint16_t pid, Twtraceevent event, uint64_t timestamp);
+
+// Append the arguments of a device callback, with the controller's counts of axes, buttons and switches
+void twtrace_callback(uint16_t device, uint16_t vid, uint16_t pid, uint32_t nbraxes, uint32_t nbrbutt, uint32_t nbrswch,
+		uint32_t currentstatus, uint32_t previousstatus, uint64_t timestamp);
+
+// Append the exit event with the program's return code
+void twtrace_exit(int retcode, uint64_t timestamp);
+
+// Records written since twtrace_open() and records lost because the file couldn't grow
+uint64_t twtrace_written();
+uint64_t twtrace_lost();
+
+// Cut the pre-allocated rest of the file and close it
+void twtrace_close();
@@ -0,0 +1,212 @@
+/*
+	twtracedecode.cpp
+
+	Decoder for the binary trace files of SaitekTrimwheel.cpp (option "-T <file>"), published under MIT license
+	like the main program. Converts a trace file to CSV, one line per record:
+
+	record,kind,event,device,vid,pid,sequence,timestamp,nbraxes,nbrbutt,axis0,axis1,axis2,axis3,buttons0,buttons1
+
+	(callback records: sequence = number of switches, buttons0/1 = current/previous device status; exit: sequence = RC)
+
+	Call: twtracedecode <tracefile> [<csvfile>]   (without csvfile, the CSV is written to stdout)
+
+	The trace is read in large blocks and the CSV lines are formatted by hand into a large output buffer,
+	as printf() per field would be the bottleneck for traces of several hundred MB. At the end, the record count and
+	the rate (MB of the trace file per sec) are shown on stderr.
+	Return codes: 0 = ok, 8 = parameter error, 12 = file error (also a failed write of the CSV), 16 = not a trace file
+*/
+
+#include "twtrace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+// Records read per block and size of the CSV output buffer (a line has less than 256 chars)
+static const size_t recordsperblock = 16384;
+static const size_t outbufsize = (recordsperblock + 1) * 256;
+
+static const char* kindnames[] = { "?", "reading", "event", "callback" };
+static const char* eventnames[] = { "", "connected", "disconnected", "detected", "appeared", "disappeared", "notfound", "turned",
+	"start", "exit" };
+
+// Append an unsigned decimal number
+static char* putuint(char* out, uint64_t value)
+{
+	char digits[20];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	while (count > 0) {
+		*out++ = digits[--count];
+	}
+	return out;
+}
+
+// Append a 64 bit hexadecimal number with 16 digits and 0x prefix
+static char* puthex64(char* out, uint64_t value)
+{
+	static const char hexdigits[] = "0123456789abcdef";
+	*out++ = '0';
+	*out++ = 'x';
+	for (int shift = 60; shift >= 0; shift -= 4) {
+		*out++ = hexdigits[(value >> shift) & 0xF];
+	}
+	return out;
+}
+
+// Append a 16 bit hexadecimal number like the program's messages (0x06A3)
+static char* puthex16(char* out, uint16_t value)
+{
+	static const char hexdigits[] = "0123456789ABCDEF";
+	*out++ = '0';
+	*out++ = 'x';
+	for (int shift = 12; shift >= 0; shift -= 4) {
+		*out++ = hexdigits[(value >> shift) & 0xF];
+	}
+	return out;
+}
+
+// Append a float with 6 decimals (axis values are between -1 and 1), unusual values by snprintf
+static char* putfloat(char* out, float value)
+{
+	double dvalue = value;
+	if (!(fabs(dvalue) < 1e9)) {			// also true for NaN
+		return out + snprintf(out, 32, "%g", dvalue);
+	}
+	if (dvalue < 0) {
+		*out++ = '-';
+		dvalue = -dvalue;
+	}
+	uint64_t scaled = (uint64_t)(dvalue * 1000000.0 + 0.5);
+	out = putuint(out, scaled / 1000000);
+	*out++ = '.';
+	uint32_t fraction = (uint32_t)(scaled % 1000000);
+	for (uint32_t divisor = 100000; divisor > 0; divisor /= 10) {
+		*out++ = (char)('0' + (fraction / divisor) % 10);
+	}
+	return out;
+}
+
+static char* putstring(char* out, const char* text)
+{
+	size_t length = strlen(text);
+	memcpy(out, text, length);
+	return out + length;
+}
+
+static char* putrecord(char* out, uint64_t recordnbr, const Twtracerecord* record)
+{
+	out = putuint(out, recordnbr);
+	*out++ = ',';
+	out = putstring(out, (record->kind < sizeof(kindnames) / sizeof(kindnames[0])) ? kindnames[record->kind] : "?");
+	*out++ = ',';
+	out = putstring(out, (record->event < sizeof(eventnames) / sizeof(eventnames[0])) ? eventnames[record->event] : "?");
+	*out++ = ',';
+	if (record->device != TWTRACE_NODEVICE) {
+		out = putuint(out, record->device);
+	}
+	*out++ = ',';
+	out = puthex16(out, record->vid);
+	*out++ = ',';
+	out = puthex16(out, record->pid);
+	*out++ = ',';
+	out = putuint(out, record->sequence);
+	*out++ = ',';
+	out = putuint(out, record->timestamp);
+	*out++ = ',';
+	out = putuint(out, record->nbraxes);
+	*out++ = ',';
+	out = putuint(out, record->nbrbutt);
+	for (int axis = 0; axis < TWTRACE_AXES; ++axis) {
+		*out++ = ',';
+		if ((uint32_t)axis < record->nbraxes) {
+			out = putfloat(out, record->axes[axis]);
+		}
+	}
+	for (int word = 0; word < TWTRACE_BUTTONWORDS; ++word) {
+		*out++ = ',';
+		out = puthex64(out, record->buttons[word]);
+	}
+	*out++ = '\n';
+	return out;
+}
+
+int main(int argc, char** argv)
+{
+	if ((argc < 2) || (argc > 3)) {
+		fprintf(stderr, "Convert a SaitekTrimwheel trace file (-T) to CSV\nCall: %s <tracefile> [<csvfile>]\n", argv[0]);
+		return 8;
+	}
+	FILE* tracefile = fopen(argv[1], "rb");
+	if (tracefile == NULL) {
+		fprintf(stderr, "Cannot open trace file %s\n", argv[1]);
+		return 12;
+	}
+	Twtraceheader header;
+	if ((fread(&header, sizeof(header), 1, tracefile) != 1)
+		|| (memcmp(header.magic, TWTRACE_MAGIC, sizeof(header.magic)) != 0)
+		|| (header.version != TWTRACE_VERSION) || (header.recordsize != sizeof(Twtracerecord))) {
+		fprintf(stderr, "%s is no trace file of this version (%s, version %i)\n", argv[1], TWTRACE_MAGIC, TWTRACE_VERSION);
+		fclose(tracefile);
+		return 16;
+	}
+	FILE* csvfile = stdout;
+	if (argc == 3) {
+		csvfile = fopen(argv[2], "wb");
+		if (csvfile == NULL) {
+			fprintf(stderr, "Cannot create CSV file %s\n", argv[2]);
+			fclose(tracefile);
+			return 12;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	static Twtracerecord records[recordsperblock];
+	static char outbuf[outbufsize];
+	char* out = outbuf;
+	out = putstring(out, "record,kind,event,device,vid,pid,sequence,timestamp,nbraxes,nbrbutt,"
+		"axis0,axis1,axis2,axis3,buttons0,buttons1\n");
+	uint64_t recordnbr = 0;
+	int retcode = 0;
+	bool written = true;
+	while (recordnbr < header.recordcount) {
+		uint64_t remaining = header.recordcount - recordnbr;
+		size_t toread = (remaining < recordsperblock) ? (size_t)remaining : recordsperblock;
+		size_t got = fread(records, sizeof(Twtracerecord), toread, tracefile);
+		for (size_t ix = 0; ix < got; ++ix) {
+			out = putrecord(out, recordnbr++, &records[ix]);
+		}
+		written = (fwrite(outbuf, 1, out - outbuf, csvfile) == (size_t)(out - outbuf)) && !ferror(csvfile);
+		out = outbuf;
+		if (!written) {
+			break;
+		}
+		if (got < toread) {
+			fprintf(stderr, "Trace file %s truncated: %llu of %llu records\n", argv[1],
+				(unsigned long long)recordnbr, (unsigned long long)header.recordcount);
+			retcode = 12;
+			break;
+		}
+	}
+// The rest of the buffer, and the data still in the stream's buffer: a full disk shows up only now
+	written = written && (fwrite(outbuf, 1, out - outbuf, csvfile) == (size_t)(out - outbuf));
+	written = (fflush(csvfile) == 0) && written && !ferror(csvfile);
+	if (csvfile != stdout) {
+		written = (fclose(csvfile) == 0) && written;
+	}
+	if (!written) {
+		fprintf(stderr, "Cannot write CSV file %s\n", (argc == 3) ? argv[2] : "(stdout)");
+		retcode = 12;
+	}
+	fclose(tracefile);
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double mbytes = (double)recordnbr * sizeof(Twtracerecord) / (1024 * 1024);
+	fprintf(stderr, "%llu records decoded (%.1f MB in %.3f secs, %.0f MB/s)\n", (unsigned long long)recordnbr, mbytes,
+		secs, (secs > 0) ? mbytes / secs : 0.0);
+	return retcode;
+}